@@ -0,0 +1,31 @@
+#ifndef ALEA_H
+#define ALEA_H
+
+/**
+ * \file alea.h
+ * \brief Générateur de nombres pseudo-aléatoires à état explicite.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ */
+
+#include <stdint.h>
+
+/**
+ * \struct Alea
+ * \brief État d'un générateur xorshift64*.
+ *
+ * Contrairement à rand(), chaque Alea est indépendant : deux threads avec
+ * chacun leur Alea ne partagent rien, et une même graine redonne toujours la
+ * même suite de nombres.
+ */
+typedef struct Alea {
+	uint64_t etat; /*!< État interne, jamais nul. */
+} Alea;
+
+void alea_init(Alea* alea, uint64_t graine);
+uint32_t alea_suivant(Alea* alea);
+int alea_borne(Alea* alea, int n);
+uint64_t alea_melanger(uint64_t valeur);
+
+#endif
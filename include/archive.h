@@ -0,0 +1,84 @@
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+/**
+ * \file archive.h
+ * \brief Archive compacte des parties jouées, pour les analyser en masse.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ *
+ * Une archive est une suite de blocs de ::ARCHIVE_TAILLE_BLOC octets, chacun
+ * au début d'un multiple de ::ARCHIVE_TAILLE_BLOC dans le fichier. Une partie
+ * n'est jamais à cheval sur deux blocs : chaque bloc se lit seul, et des
+ * threads peuvent se partager les blocs d'une archive projetée en mémoire.
+ *
+ * Un bloc commence par une entête de ::ARCHIVE_ENTETE octets :
+ *
+ * Octets | Valeur
+ * ------ | -------------
+ * 0      | ::ARCHIVE_MAGIQUE
+ * 1      | ::ARCHIVE_VERSION
+ * 2 et 3 | 0
+ * 4 à 7  | Octets des parties qui suivent, en petit-boutiste
+ *
+ * Le reste du bloc est à zéro. Une partie est une suite de varints (voir
+ * format.h) : longueur, largeur et alignement, nombre de joueurs puis leurs
+ * identifiants dans l'ordre où ils jouent, gagnant (0 si la partie est
+ * nulle), nombre de coups puis l'indice y * longueur + x de chaque case
+ * jouée. Le coup k est celui du joueur k modulo le nombre de joueurs.
+ *
+ * Une partie de 20 coups sur 8x8 tient ainsi en moins de 30 octets.
+ */
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <pthread.h>
+
+#include "morpion.h"
+
+#define ARCHIVE_MAGIQUE 0x50       /**< Premier octet de chaque bloc, 'P'. */
+#define ARCHIVE_VERSION 1          /**< Version du format écrite par ce code. */
+#define ARCHIVE_ENTETE 8           /**< Taille de l'entête d'un bloc. */
+#define ARCHIVE_TAILLE_BLOC 65536  /**< Taille d'un bloc, puissance de 2. */
+#define ARCHIVE_MAX_JOUEURS 16     /**< Nombre maximal de joueurs d'une partie. */
+
+/**
+ * \struct Archive
+ * \brief Archive ouverte en écriture, partageable entre threads.
+ */
+typedef struct Archive {
+	int fd;                                       /*!< Fichier de l'archive. */
+	pthread_mutex_t verrou;                       /*!< Protège le bloc en cours. */
+	unsigned char bloc[ARCHIVE_TAILLE_BLOC];      /*!< Bloc en cours de remplissage. */
+	size_t rempli;                                /*!< Octets utilisés du bloc, entête comprise. */
+	size_t ecrit;                                 /*!< Octets du bloc déjà dans le fichier. */
+	off_t position;                               /*!< Début du bloc en cours dans le fichier. */
+	unsigned long parties;                        /*!< Parties ajoutées depuis l'ouverture. */
+} Archive;
+
+/**
+ * \struct PartieArchivee
+ * \brief Une partie lue dans une archive.
+ */
+typedef struct PartieArchivee {
+	MorpionConfig config;                  /*!< Configuration de la partie. */
+	int nb_joueurs;                        /*!< Nombre de joueurs. */
+	int joueurs[ARCHIVE_MAX_JOUEURS];      /*!< Identifiants, dans l'ordre du jeu. */
+	int gagnant;                           /*!< Identifiant du gagnant, 0 si nulle. */
+	int nb_coups;                          /*!< Nombre de coups. */
+	int* cases;                            /*!< Indice de la case de chaque coup. */
+	int capacite;                          /*!< Taille allouée de cases. */
+} PartieArchivee;
+
+Archive* archive_ouvrir(const char* chemin);
+int archive_ajouter(Archive* archive, MorpionConfig config, const int* joueurs, int nb_joueurs,
+		int gagnant, const int* cases, int nb_coups);
+void archive_synchroniser(Archive* archive);
+void archive_fermer(Archive* archive);
+
+long archive_nombre_blocs(size_t taille);
+size_t archive_bloc(const unsigned char* carte, size_t taille, long rang, const unsigned char** parties);
+size_t archive_lire_partie(const unsigned char* donnees, size_t taille, PartieArchivee* partie);
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef CLIENT_H
+#define CLIENT_H
+
+/**
+ * \file client.h
+ * \brief Fonctions pour jouer au morpion en réseau (client).
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ *
+ * Chaque fonction client_* envoie une requête de protocol.h et attend la
+ * réponse du serveur. Elles servent au client interactif et au générateur de
+ * charge.
+ */
+
+#include "morpion.h"
+
+/** Délai sans notification après lequel le client redemande le tour (us). */
+#define CLIENT_RELANCE_US 5000000L
+
+void* client_initialize_context();
+void* client_connect(void* context);
+void* client_subscribe(void* context, int partie);
+void client_watch_game(void* subscriber, int partie);
+void client_unwatch_game(void* subscriber, int partie);
+int client_wait_notification(void* subscriber, long timeout, int* partie, int* joueur_courant, int* auteur, int* x, int* y, int* version);
+MorpionConfig client_get_morpion_config(void* requester, int partie);
+int client_join(void* requester, int* partie);
+void client_update_morpion_grille(Grille* grille, void* requester, int partie);
+int client_sync_grille(Grille* grille, void* requester, int partie, int version);
+int client_get_player_turn(void* requester, int partie);
+int client_play_turn(void* requester, int partie, int joueur_id, int x, int y);
+int client_leave(void* requester, int partie, int joueur_id);
+void client_quit(void* context, void* requester);
+
+#endif
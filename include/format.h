@@ -0,0 +1,73 @@
+#ifndef FORMAT_H
+#define FORMAT_H
+
+/**
+ * \file format.h
+ * \brief Format binaire versionné des grilles et configurations échangées.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ *
+ * Chaque message commence par une entête de ::FORMAT_ENTETE octets :
+ *
+ * Octets | Valeur
+ * ------ | -------------
+ * 0      | ::FORMAT_MAGIQUE
+ * 1      | ::FORMAT_VERSION
+ * 2      | Type : ::FORMAT_CONFIG ou ::FORMAT_GRILLE
+ * 3      | Encodage des cases d'une grille, 0 pour une configuration
+ * 4 à 7  | Taille de la suite du message en octets
+ *
+ * Tous les entiers sont écrits en petit-boutiste (octet de poids faible en
+ * premier), quelle que soit la machine.
+ *
+ * Une configuration est suivie de 3 entiers de 32 bits : longueur, largeur
+ * et alignement. Une grille est suivie de sa longueur et de sa largeur sur
+ * 16 bits, puis de ses cases dans l'un des encodages :
+ * - ::FORMAT_CASES_2BITS : 4 cases par octet, la case i sur les bits
+ *   2*(i%4) et 2*(i%4)+1, pour les identifiants de joueurs jusqu'à 3 ;
+ * - ::FORMAT_CASES_OCTET : une case par octet, identifiants jusqu'à 255 ;
+ * - ::FORMAT_CASES_CREUX : nombre de pions sur 32 bits puis, pour chaque
+ *   pion dans l'ordre des cases, l'écart à la case du pion précédent moins 1
+ *   et l'identifiant du joueur, tous deux en varint (7 bits par octet, le
+ *   bit de poids fort indique qu'un octet suit).
+ *
+ * Quel que soit l'encodage, un identifiant au delà de ::GRILLE_JOUEUR_MAX
+ * rend le message invalide.
+ */
+
+#include <stddef.h>
+
+#include "grille.h"
+#include "morpion.h"
+
+#define FORMAT_MAGIQUE 0x4D /**< Premier octet de tout message, 'M'. */
+#define FORMAT_VERSION 1    /**< Version du format écrite par ce code. */
+#define FORMAT_ENTETE  8    /**< Taille de l'entête en octets. */
+#define FORMAT_VARINT_MAX 5 /**< Octets maximaux d'un varint de 32 bits. */
+
+#define FORMAT_CONFIG 1     /**< Le message contient une MorpionConfig. */
+#define FORMAT_GRILLE 2     /**< Le message contient une Grille. */
+
+#define FORMAT_CASES_AUTO  0xFF /**< Pour l'écriture : l'encodage le plus court. */
+#define FORMAT_CASES_2BITS 0    /**< 4 cases par octet. */
+#define FORMAT_CASES_OCTET 1    /**< Une case par octet. */
+#define FORMAT_CASES_CREUX 2    /**< Liste des pions seulement. */
+
+/** Taille d'une configuration écrite par ::format_ecrire_config. */
+#define FORMAT_TAILLE_CONFIG (FORMAT_ENTETE + 12)
+
+void format_ecrire_u32(unsigned char* tampon, unsigned long valeur);
+unsigned long format_lire_u32(const unsigned char* message);
+void format_ecrire_u64(unsigned char* tampon, uint64_t valeur);
+size_t format_taille_varint(unsigned long valeur);
+size_t format_ecrire_varint(unsigned char* tampon, unsigned long valeur);
+size_t format_lire_varint(const unsigned char* message, size_t taille, unsigned long* valeur);
+
+size_t format_taille_max_grille(int longueur, int largeur);
+long format_ecrire_grille(Grille* grille, int encodage, unsigned char* tampon, size_t taille);
+int format_lire_grille(Grille* grille, const unsigned char* message, size_t taille);
+long format_ecrire_config(MorpionConfig config, unsigned char* tampon, size_t taille);
+int format_lire_config(MorpionConfig* config, const unsigned char* message, size_t taille);
+
+#endif
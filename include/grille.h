@@ -9,37 +9,177 @@
  * \date Janvier 2013
  */
 
+#include <stdint.h>
+
 #include "user_interface.h"
+#include "alea.h"
+
+/** Nombre de directions dans lesquelles on cherche un alignement. */
+#define GRILLE_NB_DIRECTIONS 4
+#define GRILLE_HORIZONTALE   0 /**< Direction (1, 0). */
+#define GRILLE_VERTICALE     1 /**< Direction (0, 1). */
+#define GRILLE_DIAGONALE1    2 /**< Direction (1, 1). */
+#define GRILLE_DIAGONALE2    3 /**< Direction (1, -1). */
+
+/**
+ * Alignement maximal que les bitboards savent vérifier en une fenêtre de
+ * 64 bits (2n-1 <= 64). Au delà, ::alignePion compte case par case.
+ */
+#define GRILLE_ALIGNEMENT_MAX_BITBOARD 32
+
+/** Valeur des cases de la bordure du plateau d'octets, jamais un identifiant de joueur. */
+#define GRILLE_BORD 0xFF
+/** Plus grand identifiant de joueur que ::placerPion accepte, pour tenir dans un octet. */
+#define GRILLE_JOUEUR_MAX 254
+/** Alignement en octets des rangées du plateau d'octets, pour les lectures vectorielles. */
+#define GRILLE_ALIGNEMENT_RANGEE 16
+
+/** Nombre maximal de symétries d'une grille : 8 si elle est carrée, 4 sinon. */
+#define GRILLE_SYMETRIES_MAX 8
+#define GRILLE_SYMETRIE_MIROIR_X   1 /**< Bit de symétrie : x devient longueur - 1 - x. */
+#define GRILLE_SYMETRIE_MIROIR_Y   2 /**< Bit de symétrie : y devient largeur - 1 - y. */
+#define GRILLE_SYMETRIE_TRANSPOSEE 4 /**< Bit de symétrie : x et y sont ensuite échangés. */
+
+/**
+ * \struct MenacesJoueur
+ * \brief Cases vides où un joueur prolongerait une de ses lignes.
+ *
+ * Une case vide est menacée par un joueur si ::grille_meilleure_ligne y vaut
+ * au moins 2, c'est à dire si elle touche un de ses pions. Les cases menacées
+ * sont rangées de façon contigüe dans cases, dans l'ordre des indices, et
+ * leur longueur de ligne est dans valeur.
+ */
+typedef struct MenacesJoueur {
+	int* valeur;   /*!< Meilleure ligne par case menacée, 0 pour les autres cases. */
+	int* cases;    /*!< Indices croissants des cases menacées, les nb_cases premiers sont valides. */
+	int nb_cases;  /*!< Nombre de cases menacées. */
+	int pions;     /*!< Nombre de pions du joueur sur la grille. */
+} MenacesJoueur;
 
 /**
  * \struct Grille
- * \brief Contient un tableau 2D d'entiers avec ses dimensions.
+ * \brief Contient un plateau d'octets avec ses dimensions.
  *
- * La Grille d'un jeu de Morpion contient l'état du jeu dans un tableau 2D
- * d'entiers. Les entiers dans la grille sont les identifiants des joueurs qui
- * ont posé les pions dedans.
+ * La Grille d'un jeu de Morpion contient l'état du jeu dans un plateau
+ * d'octets, lu par ::GRILLE_OCTET. Les octets de la grille sont les
+ * identifiants des joueurs qui ont posé les pions dedans.
  * La structure a aussi pour champs,
- * - les dimentions (longueur et largeur) du tableau d'entiers ;
- * - le nombre de cases libres.
+ * - les dimentions (longueur et largeur) du plateau ;
+ * - le nombre de cases libres ;
+ * - le nombre de pions à aligner, que les stratégies de recherche utilisent ;
+ * - un bitboard par joueur ;
+ * - les longueurs des lignes de pions, dans les 4 directions ;
+ * - une clé de Zobrist de la position ;
+ * - l'ensemble des cases libres ;
+ * - sur demande, les cases menacées par chaque joueur ;
+ * - sur demande, les coups candidats proches des pions.
+ *
+ * Le bitboard d'un joueur est composé de 4 plans de bits, un par direction
+ * d'alignement. Dans chaque plan, les cases d'une même ligne (horizontale,
+ * verticale ou diagonale) sont contigües et chaque ligne est suivie d'un bit
+ * de garde toujours nul. Un alignement dans n'importe quelle direction se
+ * vérifie donc avec une seule fenêtre de 64 bits et des décalages/ET.
+ *
+ * Pour chaque direction, les deux cases aux extrémités d'une ligne de pions
+ * d'un même joueur contiennent dans lignes la longueur de cette ligne. Ce
+ * compteur est mis à jour en temps constant par ::placerPion et
+ * ::retirerPion, qui doivent être appelés dans l'ordre inverse pour annuler
+ * des coups. Les cases intérieures d'une ligne gardent une longueur qui peut
+ * être inférieure à la longueur réelle.
+ *
+ * Le plateau a un octet par case : l'identifiant du joueur, 0 si la case est
+ * vide. Chaque rangée occupe pas octets, un multiple de
+ * ::GRILLE_ALIGNEMENT_RANGEE, et commence à une adresse alignée. Les octets
+ * au delà de la longueur, une rangée au dessus et une rangée en dessous de la
+ * grille valent ::GRILLE_BORD : ils forment une bordure autour de la grille,
+ * si bien que les voisines de toute case, et les cases suivantes d'une ligne
+ * jusqu'au premier pion d'un autre joueur, se lisent sans vérifier qu'elles
+ * sont dans la grille. Un plateau 19x19 tient en 11 lignes de cache.
+ *
+ * Les indices (y * longueur + x) des cases libres sont rangés de façon
+ * contigüe dans les libres premières cases de cases_libres, et rang_libre
+ * donne pour chaque case libre sa position dans ce tableau. Tirer une case
+ * libre au hasard ne coûte donc qu'un tirage, et placer ou retirer un pion
+ * met l'ensemble à jour en temps constant. Toutes les cases avant
+ * premiere_libre sont occupées : retirer un pion plus haut l'abaisse, et
+ * ::grille_premiere_case_libre la fait avancer.
  *
- * Pour être correctement sérialisé par ::grille_serialize, la grille doit être
- * alloué et initialisé par ::initGrille.
+ * Une fois ::grille_suivre_menaces appelée, ::placerPion et ::retirerPion
+ * tiennent à jour les MenacesJoueur : seules la case jouée et les cases au
+ * bout des lignes qui la traversent changent. Les grilles qui ne s'en servent
+ * pas, comme les copies des recherches, ne paient rien.
+ *
+ * De même, une fois ::grille_suivre_candidats appelée, les cases vides à
+ * une distance (en nombre de cases, diagonales comprises) d'au plus
+ * distance_candidats d'un pion forment l'ensemble des candidats. proximite
+ * compte pour chaque case les pions à cette distance ; un coup ne met à jour
+ * que le carré de côté 2 * distance_candidats + 1 qui l'entoure. Les
+ * candidats se parcourent avec ::grille_candidat. Tant que
+ * candidats_suspendus est vrai, les coups ne les mettent plus à jour : les
+ * coups joués pendant la suspension doivent être retirés avant de la lever.
+ *
+ * Enfin, une fois ::grille_suivre_symetries appelée, zobrist_symetries
+ * contient la clé de Zobrist de l'image de la position par chaque symétrie
+ * de la grille (voir ::grille_symetrie_case), tenue à jour par le même XOR
+ * que zobrist. ::grille_cle_canonique en déduit, sans parcourir la grille,
+ * une clé commune à toutes les positions symétriques.
  */
 typedef struct Grille {
-	int** tab;     /*!< Tableau 2D d'entier. */
+	uint8_t* plateau; /*!< Case (0,0) du plateau d'octets bordé, voir ::GRILLE_OCTET. */
+	int pas;       /*!< Octets d'une rangée du plateau d'octets, bordure comprise. */
 	int longueur;  /*!< Longueur de la grille. */
 	int largeur;   /*!< Largeur de la grille. */
 	int libres;    /*!< Nombre de cases libres dans la grille. */
+	int alignement; /*!< Nombre de pions à aligner pour gagner, pour les stratégies. */
+	uint64_t** plans;  /*!< Bitboards des joueurs, indexés par identifiant. */
+	int nb_plans;      /*!< Nombre d'identifiants couverts par plans. */
+	int mots_plans;    /*!< Nombre de mots de 64 bits d'un bitboard. */
+	int decalage[GRILLE_NB_DIRECTIONS]; /*!< Premier mot de chaque plan. */
+	int* lignes;       /*!< Longueur de ligne par case et par direction. */
+	int* annulation;   /*!< Lignes fusionnées par chaque pion, pour ::retirerPion. */
+	uint64_t zobrist;  /*!< Clé de Zobrist de la position, voir ::grille_cle_zobrist. */
+	int* cases_libres; /*!< Indices des cases libres, les libres premiers sont valides. */
+	int* rang_libre;   /*!< Position de chaque case libre dans cases_libres. */
+	int premiere_libre; /*!< Les cases d'indice inférieur sont occupées, voir ::grille_premiere_case_libre. */
+	int suivi_menaces; /*!< Vrai si les menaces sont tenues à jour. */
+	MenacesJoueur* menaces; /*!< Menaces des joueurs, indexées par identifiant. */
+	int nb_menaces;    /*!< Nombre d'identifiants couverts par menaces. */
+	int distance_candidats; /*!< Distance des candidats aux pions, 0 s'ils ne sont pas suivis. */
+	int* proximite;    /*!< Nombre de pions à distance_candidats de chaque case. */
+	int* candidats;    /*!< Indices des candidats, les nb_candidats premiers sont valides. */
+	int* rang_candidat; /*!< Position de chaque case dans candidats, -1 si absente. */
+	int nb_candidats;  /*!< Nombre de coups candidats. */
+	int candidats_suspendus; /*!< Vrai pendant des coups qui ne touchent pas aux candidats. */
+	int nb_symetries;  /*!< Nombre de symétries suivies, 0 si elles ne le sont pas. */
+	int* images;       /*!< Image de chaque case par chaque symétrie, GRILLE_SYMETRIES_MAX par case. */
+	uint64_t zobrist_symetries[GRILLE_SYMETRIES_MAX]; /*!< Clé de l'image par chaque symétrie, l'identité est zobrist. */
 } Grille;
 
+/** Octet du plateau de la case (x,y), ::GRILLE_BORD juste autour de la grille. */
+#define GRILLE_OCTET(grille, x, y) ((grille)->plateau[(y) * (grille)->pas + (x)])
+
 Grille* initGrille(int x, int y);
 void libererGrille(Grille * G);
+Grille* copierGrille(Grille * G);
 int placerPion(Grille * G, int J, int x, int y);
+int retirerPion(Grille * G, int x, int y);
 int estPleineGrille(Grille * G);
+void grille_vider(Grille * G);
+int grille_case_libre_aleatoire(Grille * G, Alea* alea);
+int grille_premiere_case_libre(Grille * G);
 int alignePion(Grille * G, int x, int y, int n);
+int grille_ligne_potentielle(Grille * G, int J, int x, int y, int direction);
+int grille_meilleure_ligne(Grille * G, int J, int x, int y);
+void grille_suivre_menaces(Grille * G);
+int grille_premier_pion(Grille * G, int J);
+void grille_suivre_candidats(Grille * G, int distance);
+int grille_candidat(Grille * G, int rang);
+uint64_t grille_cle_zobrist(int indice, int J);
+int grille_nb_symetries(int longueur, int largeur);
+int grille_symetrie_case(int longueur, int largeur, int symetrie, int indice);
+int grille_symetrie_inverse(int symetrie);
+void grille_suivre_symetries(Grille * G);
+uint64_t grille_cle_canonique(Grille * G, int* symetrie);
 void afficherGrille(Grille * G);
 
-char* grille_serialize(Grille* grille);
-void grille_update_deserialize(Grille*, char*);
-
 #endif
@@ -0,0 +1,14 @@
+#ifndef HORLOGE_H
+#define HORLOGE_H
+
+/**
+ * \file horloge.h
+ * \brief Mesure du temps pour les stratégies et les benchmarks.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ */
+
+double horloge_secondes(void);
+
+#endif
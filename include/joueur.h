@@ -10,6 +10,10 @@
  */
 
 #include "grille.h"
+#include "alea.h"
+#include "transposition.h"
+#include "livre.h"
+#include "solution.h"
 
 /**
  * \struct Joueur
@@ -18,10 +22,27 @@
  * Un joueur est caractérisé par son identifiant et sa stratégie.
  * S'il a une stratégie non interactive, c'est que c'est un joueur automatisé
  * (un ia du jeu).
+ *
+ * Chaque joueur a son propre générateur aléatoire, pour que des parties
+ * jouées en parallèle soient indépendantes et reproductibles.
+ *
+ * Les joueurs et les éléments de ListeJoueurs sont pris dans des réserves
+ * (voir reserve.h) partagées par tous les threads : ils doivent être libérés
+ * par ::libererJoueur et ::joueurs_liberer_element, jamais par free.
+ *
+ * Les stratégies défense, alpha-beta et MCTS jouent le coup de la solution
+ * exacte ou du livre d'ouvertures du joueur quand la position y est.
  */
 typedef struct Joueur {
 	int id;        /*!< Identifiant du joueur. */
 	void (*place)(struct Joueur*, Grille*, int* x, int* y); /*!< Pointeur vers la fonction de stratégie. */
+	Alea alea;     /*!< Générateur aléatoire propre au joueur. */
+	int budget_ms; /*!< Temps de réflexion maximal par coup, 0 si sans objet. */
+	long budget_iterations; /*!< Nombre maximal de simulations par coup, 0 si sans objet. */
+	int nb_threads; /*!< Threads de réflexion, 0 pour un par coeur. */
+	TableTransposition* table; /*!< Table de transposition des stratégies de recherche, NULL sinon. */
+	const Livre* livre; /*!< Livres d'ouvertures consultés, NULL pour toujours chercher. */
+	const Solution* solution; /*!< Solutions exactes consultées, NULL pour toujours chercher. */
 } Joueur;
 
 /**
@@ -46,11 +67,17 @@ typedef struct ListeJoueurs {
 
 ListeJoueurs* joueurs_creer_liste(Joueur* joueur);
 void joueurs_place_suivant(ListeJoueurs* liste, Joueur* joueur);
+void joueurs_liberer_element(ListeJoueurs* element);
 void joueurs_liberer_liste(ListeJoueurs* liste);
 
+void libererJoueur(Joueur* joueur);
+
 Joueur* creerJoueurHumain(int id);
 Joueur* creerJoueurRandom(int id);
 Joueur* creerJoueurDefense(int id);
+Joueur* creerJoueurAlphaBeta(int id);
+Joueur* creerJoueurMCTS(int id);
+Joueur* creerJoueurParNom(const char* nom, int id);
 
 #endif
 
@@ -0,0 +1,94 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+/**
+ * \file journal.h
+ * \brief Journal des parties du serveur, pour les retrouver après un arrêt.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ *
+ * Le journal est un fichier en ajout seul : une entête avec la configuration
+ * du serveur, puis un enregistrement de taille fixe par changement d'une
+ * partie (joueur qui arrive, coup accepté, joueur qui part, partie ouverte
+ * aux joueurs sans partie). Rejouer ces changements dans l'ordre redonne
+ * exactement les parties en cours.
+ *
+ * Les threads qui écrivent ne font que copier l'enregistrement dans un
+ * tampon ; un thread dédié écrit le tampon et le synchronise sur le disque
+ * (fdatasync) pendant que le tampon suivant se remplit. Tous les
+ * enregistrements arrivés pendant une synchronisation partent ensemble à la
+ * suivante : une requête a sa réponse avant d'être sur le disque, et un arrêt
+ * brutal perd au plus le dernier groupe.
+ *
+ * Les entiers sont écrits dans l'ordre de la machine : le journal se relit
+ * par mmap, sans décodage. Un journal d'une autre architecture est refusé
+ * par son nombre magique.
+ */
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include "morpion.h"
+
+/** Nombre magique en tête du journal, "MJNL" sur une machine petit-boutiste. */
+#define JOURNAL_MAGIQUE 0x4C4E4A4D
+/** Version du format du journal. */
+#define JOURNAL_VERSION 1
+/** Taille de chacun des deux tampons d'écriture (octets). */
+#define JOURNAL_TAILLE_TAMPON (1 << 20)
+
+#define JOURNAL_JOIN 1 /**< Un joueur rejoint la partie. */
+#define JOURNAL_COUP 2 /**< Un coup est accepté. */
+#define JOURNAL_QUIT 3 /**< Un joueur quitte la partie. */
+#define JOURNAL_ATTENTE 4 /**< Le frontal ouvre une nouvelle partie en attente. */
+
+/**
+ * \struct EnteteJournal
+ * \brief Début du fichier du journal.
+ */
+typedef struct EnteteJournal {
+	uint32_t magique;     /*!< ::JOURNAL_MAGIQUE. */
+	uint32_t version;     /*!< ::JOURNAL_VERSION. */
+	int32_t longueur;     /*!< Configuration des parties journalisées. */
+	int32_t largeur;      /*!< Configuration des parties journalisées. */
+	int32_t alignement;   /*!< Configuration des parties journalisées. */
+	uint32_t reserve;     /*!< 0. */
+} EnteteJournal;
+
+/**
+ * \struct EnregistrementJournal
+ * \brief Un changement d'une partie.
+ */
+typedef struct EnregistrementJournal {
+	int32_t type;     /*!< Un des JOURNAL_*, 0 marque la fin d'un journal interrompu. */
+	int32_t partie;   /*!< Identifiant de la partie. */
+	int32_t joueur;   /*!< Joueur qui arrive, joue ou part. */
+	int32_t x;        /*!< Position x du coup, 0 sinon. */
+	int32_t y;        /*!< Position y du coup, 0 sinon. */
+} EnregistrementJournal;
+
+/**
+ * \struct Journal
+ * \brief Journal ouvert en écriture.
+ */
+typedef struct Journal {
+	int fd;                        /*!< Fichier du journal. */
+	unsigned char* tampons[2];     /*!< Tampon qui se remplit et tampon qui s'écrit. */
+	size_t rempli;                 /*!< Octets dans le tampon qui se remplit. */
+	int courant;                   /*!< Indice du tampon qui se remplit. */
+	int actif;                     /*!< 0 quand le journal se ferme. */
+	pthread_mutex_t verrou;        /*!< Protège le tampon qui se remplit. */
+	pthread_cond_t donnees;        /*!< Signalé quand le tampon reçoit un enregistrement. */
+	pthread_cond_t place;          /*!< Signalé quand les tampons sont échangés. */
+	pthread_t thread;              /*!< Thread d'écriture. */
+	unsigned long enregistrements; /*!< Enregistrements écrits depuis l'ouverture. */
+	unsigned long synchronisations;/*!< Appels à fdatasync depuis l'ouverture. */
+} Journal;
+
+Journal* journal_ouvrir(const char* chemin, MorpionConfig config,
+		void (*rejouer)(void* contexte, const EnregistrementJournal* enregistrement), void* contexte);
+void journal_ecrire(Journal* journal, int type, int partie, int joueur, int x, int y);
+void journal_fermer(Journal* journal);
+
+#endif
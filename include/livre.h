@@ -0,0 +1,86 @@
+#ifndef LIVRE_H
+#define LIVRE_H
+
+/**
+ * \file livre.h
+ * \brief Livre d'ouvertures précalculé, lu par projection en mémoire.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ *
+ * Un livre est fait pour une configuration (longueur, largeur, alignement)
+ * par bin/livre, une fois pour toutes. C'est une entête puis un tableau
+ * d'entrées triées par clé : un coup se trouve par recherche dichotomique,
+ * directement dans le fichier projeté en lecture seule. Tous les processus
+ * qui ouvrent le même livre partagent ses pages, sans temps de chargement.
+ *
+ * La clé d'une position est sa clé de Zobrist (voir ::grille_cle_zobrist)
+ * où les pions du joueur au trait comptent pour le joueur 1 et tous les
+ * autres pour le joueur 2 : elle ne dépend pas des identifiants des joueurs.
+ * Le livre vaut donc pour deux joueurs. Parmi les clés des images de la
+ * position par les symétries de la grille (voir ::grille_symetrie_case), la
+ * plus petite est gardée : les positions symétriques n'ont qu'une entrée,
+ * dont le coup est donné dans la forme canonique.
+ *
+ * Comme le journal, les entiers sont dans l'ordre de la machine et un livre
+ * d'une autre architecture est refusé par son nombre magique.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "grille.h"
+
+/** Nombre magique en tête d'un livre, "MLIV" sur une machine petit-boutiste. */
+#define LIVRE_MAGIQUE 0x56494C4D
+/** Version du format des livres. */
+#define LIVRE_VERSION 2
+/** Nombre maximal de livres ouverts par ::livre_partage. */
+#define LIVRE_MAX 8
+
+/**
+ * \struct EnteteLivre
+ * \brief Début du fichier d'un livre.
+ */
+typedef struct EnteteLivre {
+	uint32_t magique;     /*!< ::LIVRE_MAGIQUE. */
+	uint32_t version;     /*!< ::LIVRE_VERSION. */
+	int32_t longueur;     /*!< Configuration des parties du livre. */
+	int32_t largeur;      /*!< Configuration des parties du livre. */
+	int32_t alignement;   /*!< Configuration des parties du livre. */
+	int32_t profondeur;   /*!< Nombre maximal de pions des positions du livre. */
+	uint64_t nombre;      /*!< Nombre d'entrées. */
+} EnteteLivre;
+
+/**
+ * \struct EntreeLivre
+ * \brief Coup à jouer dans une position, sur 16 octets.
+ */
+typedef struct EntreeLivre {
+	uint64_t cle;         /*!< Clé de la position, voir livre.h. */
+	uint16_t coup;        /*!< Indice de la case à jouer, dans la forme canonique. */
+	uint16_t pions;       /*!< Nombre de pions de la position. */
+	uint32_t reserve;     /*!< 0. */
+} EntreeLivre;
+
+/**
+ * \struct Livre
+ * \brief Livre ouvert en lecture.
+ */
+typedef struct Livre {
+	const EnteteLivre* entete;    /*!< Début de la projection. */
+	const EntreeLivre* entrees;   /*!< Entrées triées par clé. */
+	size_t taille;                /*!< Taille de la projection en octets. */
+	struct Livre* suivant;        /*!< Livre suivant de ::livre_partage, NULL sinon. */
+} Livre;
+
+uint64_t livre_cle(Grille* grille, int joueur, int* symetrie);
+
+Livre* livre_ouvrir(const char* chemin);
+void livre_fermer(Livre* livre);
+int livre_chercher(const Livre* livre, Grille* grille, int joueur);
+const Livre* livre_partage(void);
+
+int livre_ecrire(const char* chemin, const EnteteLivre* entete, EntreeLivre* entrees);
+
+#endif
@@ -17,6 +17,8 @@
 #include "joueur.h"
 #include "user_interface.h"
 
+struct Archive;
+
 /**
  * \struct MorpionConfig
  * \brief Contient la configuration d'un jeu de morpion.
@@ -38,21 +40,20 @@ typedef struct MorpionConfig {
  * La structure Morpion contient un pointeur vers la grille, un pointeur vers
  * la liste des joueurs et un MorpionConfig.
  * Pour gérer de multiples interfaces, une UserInterface est aussi stockée.
+ * Si une Archive est donnée, ::morpion_play y ajoute chaque partie jouée.
  */
 typedef struct Morpion {
 	Grille* grille;              /**< Pointeur vers une Grille. */
 	MorpionConfig config;        /**< Configuration du jeu. */
 	ListeJoueurs* liste_joueurs; /**< Liste des joueurs. */
 	UserInterface ui;            /**< UserInterface à utiliser. */
+	struct Archive* archive;     /**< Archive des parties jouées, NULL pour ne rien enregistrer. */
 } Morpion;
 
 MorpionConfig morpion_config_parse_options(int argc, char* argv[]);
 void morpion_reset_grille(Morpion* morpion);
 void morpion_free_resources(Morpion* morpion);
 void morpion_add_players(Morpion* morpion);
-void morpion_play(Morpion* morpion);
-
-char* morpion_config_serialize(MorpionConfig config);
-MorpionConfig morpion_config_deserialize(char*);
+int morpion_play(Morpion* morpion);
 
 #endif
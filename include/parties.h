@@ -0,0 +1,67 @@
+#ifndef PARTIES_H
+#define PARTIES_H
+
+/**
+ * \file parties.h
+ * \brief Table des parties hébergées par un serveur.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ */
+
+#include "morpion.h"
+
+/** Nombre de joueurs qu'attend une partie avant de commencer. */
+#define PARTIES_JOUEURS_PAR_PARTIE 2
+/** Nombre de cases de la table à sa création (puissance de 2). */
+#define PARTIES_TAILLE_INITIALE 1024
+
+/**
+ * \struct Partie
+ * \brief Une partie hébergée par le serveur.
+ *
+ * Le Morpion de la partie contient sa grille et l'anneau de ses joueurs, dont
+ * le premier élément est le joueur qui doit jouer.
+ *
+ * Les coups acceptés sont rangés dans l'ordre dans le journal : le coup k
+ * occupe journal[2k] (joueur) et journal[2k+1] (indice de la case). La
+ * version de la partie est le nombre de coups joués.
+ */
+typedef struct Partie {
+	int id;             /*!< Identifiant de la partie, > 0. */
+	Morpion morpion;    /*!< Grille, configuration et joueurs de la partie. */
+	int nb_joueurs;     /*!< Joueurs qui ont rejoint, donne leurs identifiants. */
+	int presents;       /*!< Joueurs qui n'ont pas encore quitté la partie. */
+	int* journal;       /*!< Coups joués, deux entiers par coup. */
+	int version;        /*!< Nombre de coups joués. */
+} Partie;
+
+/**
+ * \struct TableParties
+ * \brief Table de hachage des parties par identifiant.
+ *
+ * Adressage ouvert avec sondage linéaire : chercher, créer et supprimer une
+ * partie se font en temps constant en moyenne. Les cases des parties
+ * supprimées sont marquées jusqu'au prochain agrandissement.
+ */
+typedef struct TableParties {
+	Partie** cases;        /*!< Cases de la table, NULL si jamais occupées. */
+	int masque;            /*!< Nombre de cases moins 1. */
+	int nombre;            /*!< Nombre de parties dans la table. */
+	int occupees;          /*!< Cases non NULL, parties supprimées comprises. */
+	int prochain_id;       /*!< Prochain identifiant essayé par ::parties_creer_partie. */
+	MorpionConfig config;  /*!< Configuration des nouvelles parties. */
+} TableParties;
+
+TableParties* parties_creer(MorpionConfig config);
+void parties_liberer(TableParties* table);
+Partie* parties_chercher(TableParties* table, int id);
+Partie* parties_creer_partie(TableParties* table, int id);
+void parties_supprimer(TableParties* table, int id);
+
+int parties_ajouter_joueur(Partie* partie);
+int parties_retirer_joueur(Partie* partie, int joueur_id);
+int parties_joueur_courant(Partie* partie);
+int parties_jouer(Partie* partie, int joueur_id, int x, int y);
+
+#endif
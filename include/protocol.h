@@ -7,6 +7,10 @@
  * \author Philippe Lewin <lewinp@esiee.fr>
  * \version 0.1
  * \date Janvier 2013
+ *
+ * Un serveur héberge plusieurs parties. Chaque requête commence par l'opcode
+ * puis l'identifiant de la partie visée (int). Une requête sur une partie qui
+ * n'existe pas reçoit une réponse vide.
  */
 
 /**
@@ -18,15 +22,18 @@
  * Type de champ | Valeur
  * ------------- | -------------
  * char          | ::PROTOCOL_JOIN
+ * int           | Identifiant de la partie, 0 pour une partie qui attend des joueurs
  * char*         | Nom d'utilisateur terminé par \0
  *
+ * Une partie demandée par son identifiant est créée si elle n'existe pas.
  *
  * Réponse du serveur
  * ------------------
  *
  * Type de champ | Valeur
  * ------------- | -------------
- * int           | Identifiant du Joueur
+ * int           | Identifiant du Joueur, 0 si la partie a déjà donné ::GRILLE_JOUEUR_MAX identifiants
+ * int           | Identifiant de la partie rejointe
  */
 #define PROTOCOL_JOIN       0x01
 
@@ -39,6 +46,7 @@
  * Type de champ | Valeur
  * ------------- | -------------
  * char          | ::PROTOCOL_QUIT
+ * int           | Identifiant de la partie
  * int           | Identifiant du joueur
  *
  *
@@ -60,6 +68,7 @@
  * Type de champ | Valeur
  * ------------- | -------------
  * char          | ::PROTOCOL_GET_CONFIG
+ * int           | Identifiant de la partie
  *
  *
  * Réponse du serveur
@@ -72,7 +81,7 @@
 #define PROTOCOL_GET_CONFIG 0x10
 
 /**
- * Le client veut la configuration du Morpion sur le serveur.
+ * Le client veut la grille d'une partie.
  *
  * Requête du client
  * -----------------
@@ -80,6 +89,7 @@
  * Type de champ | Valeur
  * ------------- | -------------
  * char          | ::PROTOCOL_GET_GRILLE
+ * int           | Identifiant de la partie
  *
  *
  * Réponse du serveur
@@ -87,7 +97,7 @@
  *
  * Type de champ | Valeur
  * ------------- | -------------
- * char*         | Tableau 2D d'entiers sérialisé
+ * char*         | Grille au format de format.h (::format_ecrire_grille)
  */
 #define PROTOCOL_GET_GRILLE 0x11
 
@@ -101,6 +111,7 @@
  * Type de champ | Valeur
  * ------------- | -------------
  * char          | ::PROTOCOL_GET_TURN
+ * int           | Identifiant de la partie
  *
  *
  * Réponse du serveur
@@ -122,6 +133,7 @@
  * Type de champ | Valeur
  * ------------- | -------------
  * char          | ::PROTOCOL_PLAY_TURN
+ * int           | Identifiant de la partie
  * int           | Identifiant du Joueur
  * int           | Position x sur la Grille
  * int           | Position y sur la Grille
@@ -133,7 +145,109 @@
  * Type de champ | Valeur
  * ------------- | -------------
  * int           | Acceptation ou non du placement.
+ *
+ * Le placement est refusé (0) si ce n'est pas le tour du joueur ou si la case
+ * est occupée ; le tour ne passe au joueur suivant que si le pion est placé.
  */
 #define PROTOCOL_PLAY_TURN  0x13
 
+/**
+ * Le client veut les coups joués depuis une version de la grille.
+ *
+ * La version d'une partie est son nombre de coups joués. Si le client a plus
+ * de ::PROTOCOL_COUPS_MAX coups de retard, ou une version que le serveur ne
+ * connait pas, la réponse est la grille entière.
+ *
+ * Requête du client
+ * -----------------
+ *
+ * Type de champ | Valeur
+ * ------------- | -------------
+ * char          | ::PROTOCOL_GET_COUPS
+ * int           | Identifiant de la partie
+ * int           | Version de la grille du client
+ *
+ *
+ * Réponse du serveur
+ * ------------------
+ *
+ * Type de champ | Valeur
+ * ------------- | -------------
+ * int           | Version de la grille du serveur
+ * char          | ::PROTOCOL_COUPS_DELTA ou ::PROTOCOL_COUPS_GRILLE
+ * int*          | Delta : (joueur, y * longueur + x) pour chaque coup, dans l'ordre
+ * char*         | Grille : grille au format de format.h, comme ::PROTOCOL_GET_GRILLE
+ */
+#define PROTOCOL_GET_COUPS  0x14
+
+/** Réponse à ::PROTOCOL_GET_COUPS qui ne contient que les nouveaux coups. */
+#define PROTOCOL_COUPS_DELTA  0
+/** Réponse à ::PROTOCOL_GET_COUPS qui contient la grille entière. */
+#define PROTOCOL_COUPS_GRILLE 1
+/** Retard maximal, en coups, rattrapé par un delta. */
+#define PROTOCOL_COUPS_MAX    64
+
+/**
+ * Le client veut les statistiques du serveur.
+ *
+ * La requête est traitée par le frontal, quel que soit l'identifiant de
+ * partie, qui doit être présent mais est ignoré. Dans la réponse, les
+ * entiers de 32 et 64 bits sont en petit-boutiste, comme ceux de format.h ;
+ * les durées sont en nanosecondes.
+ *
+ * Requête du client
+ * -----------------
+ *
+ * Type de champ | Valeur
+ * ------------- | -------------
+ * char          | ::PROTOCOL_GET_STATS
+ * int           | Identifiant de partie, ignoré
+ *
+ *
+ * Réponse du serveur
+ * ------------------
+ *
+ * Type de champ | Valeur
+ * ------------- | -------------
+ * uint32_t      | Parties hébergées
+ * uint32_t      | Joueurs présents
+ * uint32_t      | Threads travailleurs
+ * uint64_t      | PLAY_TURN refusés (pas son tour, case prise, requête courte)
+ * uint32_t      | Nombre N d'opcodes, puis N fois :
+ * char          | - opcode, 0 pour les opcodes inconnus
+ * uint64_t[7]   | - requêtes, durée moyenne, p50, p90, p99, p99.9, maximum
+ * uint32_t      | - nombre K de cases non vides de l'histogramme, puis K fois :
+ * uint64_t[2]   |   - plus petite durée de la case, nombre de requêtes
+ *
+ * Une case de l'histogramme couvre moins de 1/16 de sa plus petite durée
+ * (voir statistiques.h).
+ */
+#define PROTOCOL_GET_STATS  0x15
+
+/**
+ * Le serveur annonce un changement dans une partie.
+ *
+ * Les notifications sont publiées sur un socket PUB (port 5555 + 1). Elles
+ * commencent par l'identifiant de la partie : un client s'abonne à sa partie
+ * en s'abonnant à ces sizeof(int) octets. Une notification est publiée quand
+ * un pion est placé et quand un joueur rejoint ou quitte la partie.
+ *
+ * Notification du serveur
+ * -----------------------
+ *
+ * Type de champ | Valeur
+ * ------------- | -------------
+ * int           | Identifiant de la partie
+ * char          | ::PROTOCOL_NOTIFICATION
+ * int           | Identifiant du joueur qui doit jouer, 0 si personne
+ * int           | Identifiant du joueur qui a placé un pion, 0 sinon
+ * int           | Position x du pion placé
+ * int           | Position y du pion placé
+ * int           | Version de la grille après ce changement
+ *
+ * Un client dont la version n'est pas celle qui précède le coup notifié a
+ * manqué des coups : il les demande par ::PROTOCOL_GET_COUPS.
+ */
+#define PROTOCOL_NOTIFICATION 0x20
+
 #endif
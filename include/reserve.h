@@ -0,0 +1,44 @@
+#ifndef RESERVE_H
+#define RESERVE_H
+
+/**
+ * \file reserve.h
+ * \brief Réserve d'objets de même taille, recyclés sans passer par malloc.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ *
+ * Une réserve alloue ses objets par blocs de RESERVE_PAR_BLOC et garde les
+ * objets rendus dans une liste chaînée par leur premier mot : prendre ou
+ * rendre un objet ne coûte qu'une opération de liste, sous un verrou. Les
+ * blocs ne sont jamais rendus au système ; la réserve garde la mémoire du
+ * plus grand nombre d'objets utilisés à la fois.
+ *
+ * Une réserve se déclare statiquement :
+ *
+ *     static Reserve reserve = RESERVE_INITIALISEUR(sizeof(Objet));
+ */
+
+#include <stddef.h>
+#include <pthread.h>
+
+/** Nombre d'objets alloués à la fois quand une réserve est vide. */
+#define RESERVE_PAR_BLOC 64
+
+/**
+ * \struct Reserve
+ * \brief Objets libres et blocs d'une réserve.
+ */
+typedef struct Reserve {
+	size_t taille;          /*!< Taille d'un objet, au moins celle d'un pointeur. */
+	void* libres;           /*!< Premier objet libre, NULL si aucun. */
+	pthread_mutex_t verrou; /*!< Protège libres. */
+} Reserve;
+
+/** Initialiseur d'une réserve d'objets de la taille donnée. */
+#define RESERVE_INITIALISEUR(taille) { (taille), NULL, PTHREAD_MUTEX_INITIALIZER }
+
+void* reserve_prendre(Reserve* reserve);
+void reserve_rendre(Reserve* reserve, void* objet);
+
+#endif
@@ -9,4 +9,13 @@
  * \date Janvier 2013
  */
 
+/** Nombre maximal de threads travailleurs, un par cœur au plus. */
+#define SERVER_TRAVAILLEURS_MAX 64
+/** Nombre maximal de trames d'un message relayé : adresse et corps. */
+#define SERVER_TRAMES_MAX 8
+/** Période d'écriture du fichier des statistiques par défaut (s). */
+#define SERVER_STATS_PERIODE 60
+/** Période d'écriture des parties archivées dont le bloc n'est pas plein (s). */
+#define SERVER_ARCHIVE_PERIODE 1
+
 #endif
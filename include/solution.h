@@ -0,0 +1,105 @@
+#ifndef SOLUTION_H
+#define SOLUTION_H
+
+/**
+ * \file solution.h
+ * \brief Solution exacte des petites configurations, lue par projection en mémoire.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ *
+ * bin/solution parcourt tout l'arbre de jeu d'une configuration à deux
+ * joueurs et range, pour chaque position atteignable où il faut jouer, son
+ * résultat pour le joueur au trait (gagnée, nulle ou perdue), le nombre de
+ * coups jusqu'à la fin de la partie si les deux joueurs jouent au mieux, et
+ * le meilleur coup.
+ *
+ * Une position est codée en base 3, case par case (0 vide, 1 joueur au
+ * trait, 2 adversaire) : le code est exact jusqu'à ::SOLUTION_CASES_MAX
+ * cases. Les positions symétriques (rotations et réflexions qui gardent la
+ * grille, 8 pour une grille carrée, 4 sinon) ne sont rangées qu'une fois,
+ * sous la forme de plus petit code ; leur coup est donné dans cette forme.
+ *
+ * Le fichier est une entête, les codes triés puis la valeur de chaque code :
+ * un coup se trouve par recherche dichotomique dans la projection en
+ * lecture seule, partagée entre processus. Comme le livre d'ouvertures, les
+ * entiers sont dans l'ordre de la machine.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "grille.h"
+
+/** Nombre magique en tête d'une solution, "MSOL" sur une machine petit-boutiste. */
+#define SOLUTION_MAGIQUE 0x4C4F534D
+/** Version du format des solutions. */
+#define SOLUTION_VERSION 1
+/** Nombre maximal de cases : 3 puissance 40 tient sur 64 bits. */
+#define SOLUTION_CASES_MAX 40
+/** Nombre maximal de solutions ouvertes par ::solution_partage. */
+#define SOLUTION_MAX 8
+/** Nombre maximal de symétries d'une grille. */
+#define SOLUTION_SYMETRIES_MAX GRILLE_SYMETRIES_MAX
+
+#define SOLUTION_PERDUE 1 /**< Le joueur au trait perd. */
+#define SOLUTION_NULLE  2 /**< La partie est nulle. */
+#define SOLUTION_GAGNEE 3 /**< Le joueur au trait gagne. */
+
+/** Résultat d'une valeur, un des SOLUTION_*. */
+#define SOLUTION_RESULTAT(valeur) ((valeur) & 3)
+/** Coups jusqu'à la fin de la partie d'une valeur. */
+#define SOLUTION_DISTANCE(valeur) (((valeur) >> 2) & 63)
+/** Meilleur coup d'une valeur, dans la forme canonique. */
+#define SOLUTION_COUP(valeur) ((valeur) >> 8)
+/** Valeur d'un résultat, d'une distance et d'un coup. */
+#define SOLUTION_VALEUR(resultat, distance, coup) ((uint16_t) ((resultat) | (distance) << 2 | (coup) << 8))
+
+/**
+ * \struct EnteteSolution
+ * \brief Début du fichier d'une solution.
+ */
+typedef struct EnteteSolution {
+	uint32_t magique;     /*!< ::SOLUTION_MAGIQUE. */
+	uint32_t version;     /*!< ::SOLUTION_VERSION. */
+	int32_t longueur;     /*!< Configuration résolue. */
+	int32_t largeur;      /*!< Configuration résolue. */
+	int32_t alignement;   /*!< Configuration résolue. */
+	uint32_t valeur;      /*!< Valeur de la grille vide pour le premier joueur. */
+	uint64_t nombre;      /*!< Nombre de positions. */
+} EnteteSolution;
+
+/**
+ * \struct Symetries
+ * \brief Symétries d'une grille, en permutations des indices de cases.
+ */
+typedef struct Symetries {
+	int cases;                                                /*!< Nombre de cases. */
+	int nombre;                                               /*!< Nombre de symétries, l'identité d'abord. */
+	uint8_t image[SOLUTION_SYMETRIES_MAX][SOLUTION_CASES_MAX];  /*!< Case image de chaque case. */
+	uint8_t origine[SOLUTION_SYMETRIES_MAX][SOLUTION_CASES_MAX]; /*!< Case dont chaque case est l'image. */
+	uint64_t poids[SOLUTION_SYMETRIES_MAX][SOLUTION_CASES_MAX];  /*!< 3 puissance l'image de chaque case. */
+} Symetries;
+
+/**
+ * \struct Solution
+ * \brief Solution ouverte en lecture.
+ */
+typedef struct Solution {
+	const EnteteSolution* entete;  /*!< Début de la projection. */
+	const uint64_t* codes;         /*!< Codes des positions, triés. */
+	const uint16_t* valeurs;       /*!< Valeur de chaque position. */
+	size_t taille;                 /*!< Taille de la projection en octets. */
+	Symetries symetries;           /*!< Symétries de la configuration. */
+	struct Solution* suivante;     /*!< Solution suivante de ::solution_partage, NULL sinon. */
+} Solution;
+
+int solution_symetries(Symetries* symetries, int longueur, int largeur);
+uint64_t solution_canonique(const Symetries* symetries, const uint8_t* cases, int* symetrie);
+
+Solution* solution_ouvrir(const char* chemin);
+void solution_fermer(Solution* solution);
+int solution_chercher(const Solution* solution, Grille* grille, int joueur, int* valeur);
+const Solution* solution_partage(void);
+
+#endif
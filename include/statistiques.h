@@ -0,0 +1,77 @@
+#ifndef STATISTIQUES_H
+#define STATISTIQUES_H
+
+/**
+ * \file statistiques.h
+ * \brief Compteurs et histogrammes de latence des requêtes du serveur.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ *
+ * Chaque Statistiques n'a qu'un seul thread qui écrit. Les écritures sont
+ * des stores atomiques relâchés : un autre thread peut lire et fusionner les
+ * compteurs à tout moment, sans verrou et sans ralentir celui qui écrit.
+ *
+ * Les histogrammes sont log-linéaires, comme HdrHistogram : chaque puissance
+ * de 2 est découpée en ::STATISTIQUES_SOUS_CASES cases, soit une erreur
+ * relative inférieure à 1 / ::STATISTIQUES_SOUS_CASES sur toute l'étendue
+ * d'un entier de 64 bits.
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Bits de précision des histogrammes. */
+#define STATISTIQUES_PRECISION 4
+/** Cases par puissance de 2. */
+#define STATISTIQUES_SOUS_CASES (1 << STATISTIQUES_PRECISION)
+/** Cases d'un histogramme, de quoi couvrir tout uint64_t. */
+#define STATISTIQUES_CASES ((64 - STATISTIQUES_PRECISION + 1) * STATISTIQUES_SOUS_CASES)
+/** Opcodes suivis ; le dernier rang compte les opcodes inconnus. */
+#define STATISTIQUES_OPCODES 9
+
+/** Taille maximale de la sérialisation de ::statistiques_serialiser. */
+#define STATISTIQUES_TAILLE_MAX (3 * 4 + 8 + 4 \
+	+ STATISTIQUES_OPCODES * (1 + 7 * 8 + 4 + STATISTIQUES_CASES * 2 * 8))
+
+/**
+ * \struct Histogramme
+ * \brief Distribution de durées en nanosecondes.
+ */
+typedef struct Histogramme {
+	uint64_t cases[STATISTIQUES_CASES]; /*!< Nombre de valeurs par case. */
+	uint64_t nombre;                    /*!< Nombre de valeurs. */
+	uint64_t somme;                     /*!< Somme des valeurs. */
+	uint64_t maximum;                   /*!< Plus grande valeur. */
+} Histogramme;
+
+/**
+ * \struct Statistiques
+ * \brief Activité d'un thread du serveur.
+ */
+typedef struct Statistiques {
+	uint64_t requetes[STATISTIQUES_OPCODES];     /*!< Requêtes par opcode. */
+	Histogramme latences[STATISTIQUES_OPCODES];  /*!< Durée de traitement par opcode. */
+	uint64_t coups_refuses;                      /*!< PLAY_TURN refusés ou mal formés. */
+	int parties;                                 /*!< Parties hébergées. */
+	int joueurs;                                 /*!< Joueurs présents dans ces parties. */
+} Statistiques;
+
+Statistiques* statistiques_creer(void);
+void statistiques_liberer(Statistiques* statistiques);
+void statistiques_vider(Statistiques* statistiques);
+
+void statistiques_requete(Statistiques* statistiques, char opcode, uint64_t duree);
+void statistiques_coup_refuse(Statistiques* statistiques);
+void statistiques_jauges(Statistiques* statistiques, int parties, int joueurs);
+void statistiques_fusionner(Statistiques* total, Statistiques* source);
+
+uint64_t histogramme_quantile(Histogramme* histogramme, double quantile);
+uint64_t histogramme_borne(int rang);
+
+size_t statistiques_serialiser(Statistiques* statistiques, int travailleurs, unsigned char* tampon);
+void statistiques_ecrire(Statistiques* statistiques, int travailleurs, FILE* fichier);
+void statistiques_ecrire_latences(Statistiques* statistiques, FILE* fichier);
+
+#endif
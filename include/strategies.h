@@ -4,9 +4,21 @@
 #include "joueur.h"
 #include "grille.h"
 
+/** Temps de réflexion par défaut de la stratégie alpha-beta. */
+#define STRATEGIE_ALPHABETA_BUDGET_MS 50
+/** Temps de réflexion par défaut de la stratégie MCTS. */
+#define STRATEGIE_MCTS_BUDGET_MS 50
+/** Taille par défaut de la table de transposition d'un joueur. */
+#define STRATEGIE_TRANSPOSITION_OCTETS (16 * 1024 * 1024)
+
 void strategie_manuelle(Joueur* joueur, Grille* grille, int* x, int* y);
 void strategie_random(Joueur* joueur, Grille* grille, int* x, int* y);
 void strategie_defense(Joueur* joueur, Grille* grille, int* x, int* y);
+void strategie_alphabeta(Joueur* joueur, Grille* grille, int* x, int* y);
+void strategie_mcts(Joueur* joueur, Grille* grille, int* x, int* y);
+
+int strategie_adversaire(Grille* grille, int id);
+int strategie_coup_connu(Joueur* joueur, Grille* grille, int* x, int* y);
 
 
 #endif
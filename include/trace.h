@@ -0,0 +1,58 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+/**
+ * \file trace.h
+ * \brief Traces du serveur par niveau, écrites par un thread en arrière-plan.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ *
+ * Les messages sont formatés par le thread appelant dans une file circulaire
+ * sans verrou ; un thread dédié les écrit dans le fichier. Un appelant ne
+ * bloque jamais sur une entrée-sortie : si la file est pleine, le message est
+ * perdu et compté.
+ *
+ * Le niveau maximal est fixé à la compilation par ::TRACE_NIVEAU_MAX (les
+ * appels à ::TRACE au-delà disparaissent du code), puis à l'exécution par
+ * ::trace_niveau.
+ *
+ * La macro ::TRACE est variadique : elle demande C99 (-std=gnu99).
+ */
+
+#define TRACE_ERREUR        0 /**< Le serveur ne peut pas faire ce qu'on lui demande. */
+#define TRACE_AVERTISSEMENT 1 /**< Requête invalide ou situation anormale. */
+#define TRACE_INFO          2 /**< Vie des parties : joueurs qui arrivent et partent. */
+#define TRACE_DEBUG         3 /**< Chaque requête. */
+
+#ifndef TRACE_NIVEAU_MAX
+/** Niveau maximal compilé, à redéfinir par -DTRACE_NIVEAU_MAX=... */
+#define TRACE_NIVEAU_MAX TRACE_DEBUG
+#endif
+
+/** Nombre de messages de la file (puissance de 2). */
+#define TRACE_CASES 4096
+/** Taille maximale d'un message, les messages plus longs sont tronqués. */
+#define TRACE_TAILLE_MESSAGE 192
+/** Attente du thread d'écriture quand la file est vide (us). */
+#define TRACE_ATTENTE_US 1000
+
+/** Niveau des messages gardés, -1 tant que les traces ne sont pas démarrées. */
+extern int trace_niveau;
+
+/**
+ * Écrit un message si son niveau est actif, sinon n'évalue pas ses arguments.
+ */
+#define TRACE(niveau, ...) \
+	do { \
+		if((niveau) <= TRACE_NIVEAU_MAX && (niveau) <= trace_niveau) { \
+			trace_ecrire((niveau), __VA_ARGS__); \
+		} \
+	} while(0)
+
+int trace_demarrer(const char* chemin, int niveau);
+void trace_arreter(void);
+void trace_ecrire(int niveau, const char* format, ...);
+unsigned long trace_perdus(void);
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef TRANSPOSITION_H
+#define TRANSPOSITION_H
+
+/**
+ * \file transposition.h
+ * \brief Table de transposition pour les stratégies de recherche.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TRANSPOSITION_EXACT      0 /**< Le score est exact. */
+#define TRANSPOSITION_BORNE_INF  1 /**< Le score est une borne inférieure (coupure beta). */
+#define TRANSPOSITION_BORNE_SUP  2 /**< Le score est une borne supérieure (aucun coup n'a dépassé alpha). */
+
+#define TRANSPOSITION_POLITIQUE_PROFONDEUR 0 /**< Remplace d'abord les entrées anciennes, puis les moins profondes. */
+#define TRANSPOSITION_POLITIQUE_TOUJOURS   1 /**< Remplace toujours une entrée du seau. */
+
+#define TRANSPOSITION_PAS_DE_COUP 0xFFFF /**< Valeur de EntreeTransposition::coup sans coup connu. */
+#define TRANSPOSITION_PAR_SEAU    4      /**< Entrées par seau de 64 octets. */
+
+/**
+ * \struct EntreeTransposition
+ * \brief Résultat de recherche d'une position, sur 16 octets.
+ */
+typedef struct EntreeTransposition {
+	uint64_t cle;        /*!< Clé de Zobrist de la position. */
+	int32_t score;       /*!< Score de la position pour le joueur au trait. */
+	uint16_t coup;       /*!< Meilleur coup (indice de case), TRANSPOSITION_PAS_DE_COUP sinon. */
+	uint8_t profondeur;  /*!< Profondeur de la recherche qui a donné le score. */
+	uint8_t type_age;    /*!< Type de score (2 bits bas) et âge de la recherche (6 bits hauts), 0 si vide. */
+} EntreeTransposition;
+
+/**
+ * \struct SeauTransposition
+ * \brief Groupe d'entrées qui tient dans une ligne de cache.
+ */
+typedef struct SeauTransposition {
+	EntreeTransposition entrees[TRANSPOSITION_PAR_SEAU]; /*!< Entrées du seau. */
+} SeauTransposition;
+
+/**
+ * \struct TableTransposition
+ * \brief Table de transposition de taille fixe.
+ *
+ * Une position est rangée dans le seau désigné par les bits bas de sa clé.
+ * Les seaux sont alignés sur 64 octets : une recherche ne lit qu'une ligne
+ * de cache. La table n'est pas protégée contre les accès concurrents, chaque
+ * thread de recherche doit avoir la sienne.
+ */
+typedef struct TableTransposition {
+	SeauTransposition* seaux; /*!< Seaux alignés sur 64 octets. */
+	void* memoire;            /*!< Bloc alloué, à libérer. */
+	size_t masque;            /*!< Nombre de seaux - 1 (puissance de 2). */
+	int politique;            /*!< Politique de remplacement. */
+	uint8_t age;              /*!< Âge de la recherche courante, de 1 à 63. */
+	long sondes;              /*!< Nombre de sondages. */
+	long succes;              /*!< Nombre de sondages qui ont trouvé la position. */
+} TableTransposition;
+
+TableTransposition* transposition_creer(size_t octets, int politique);
+void transposition_liberer(TableTransposition* table);
+void transposition_vider(TableTransposition* table);
+void transposition_nouvelle_recherche(TableTransposition* table);
+int transposition_sonder(TableTransposition* table, uint64_t cle, EntreeTransposition* entree);
+void transposition_stocker(TableTransposition* table, uint64_t cle, int profondeur, int score, int type, int coup);
+
+#endif
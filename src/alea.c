@@ -0,0 +1,74 @@
+/**
+ * \file alea.c
+ * \brief Générateur de nombres pseudo-aléatoires à état explicite.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ */
+
+#include "alea.h"
+
+/** Construit une constante 64 bits sans suffixe ULL (absent d'ANSI C). */
+#define ALEA_CONSTANTE(haut, bas) (((uint64_t) (haut) << 32) | (uint64_t) (bas))
+
+/**
+ * \fn uint64_t alea_melanger(uint64_t valeur)
+ * \brief Mélange les bits d'un entier (étape de splitmix64).
+ *
+ * Deux valeurs proches donnent des résultats sans rapport. Sert aussi à
+ * dériver des clés de hachage reproductibles.
+ *
+ * \param valeur Valeur à mélanger.
+ * \return La valeur mélangée.
+ */
+uint64_t alea_melanger(uint64_t valeur) {
+	uint64_t z = valeur + ALEA_CONSTANTE(0x9E3779B9UL, 0x7F4A7C15UL);
+	z = (z ^ (z >> 30)) * ALEA_CONSTANTE(0xBF58476DUL, 0x1CE4E5B9UL);
+	z = (z ^ (z >> 27)) * ALEA_CONSTANTE(0x94D049BBUL, 0x133111EBUL);
+	return z ^ (z >> 31);
+}
+
+/**
+ * \fn void alea_init(Alea* alea, uint64_t graine)
+ * \brief Initialise un générateur à partir d'une graine.
+ *
+ * La graine est mélangée par ::alea_melanger pour que des graines proches
+ * (0, 1, 2, ...) donnent des suites sans rapport.
+ *
+ * \param alea Générateur à initialiser.
+ * \param graine Graine quelconque, 0 compris.
+ */
+void alea_init(Alea* alea, uint64_t graine) {
+	uint64_t z = alea_melanger(graine);
+
+	alea->etat = z != 0 ? z : 1;
+}
+
+/**
+ * \fn uint32_t alea_suivant(Alea* alea)
+ * \brief Tire un entier pseudo-aléatoire de 32 bits.
+ *
+ * \param alea Générateur.
+ * \return Un entier uniforme sur 32 bits.
+ */
+uint32_t alea_suivant(Alea* alea) {
+	uint64_t x = alea->etat;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	alea->etat = x;
+
+	return (uint32_t) ((x * ALEA_CONSTANTE(0x2545F491UL, 0x4F6CDD1DUL)) >> 32);
+}
+
+/**
+ * \fn int alea_borne(Alea* alea, int n)
+ * \brief Tire un entier pseudo-aléatoire entre 0 et n-1.
+ *
+ * \param alea Générateur.
+ * \param n Borne supérieure exclue (> 0).
+ * \return Un entier entre 0 et n-1.
+ */
+int alea_borne(Alea* alea, int n) {
+	return (int) (((uint64_t) alea_suivant(alea) * (uint64_t) n) >> 32);
+}
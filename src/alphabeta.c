@@ -0,0 +1,411 @@
+/**
+ * \file alphabeta.c
+ * \brief Stratégie de recherche negamax alpha-beta à temps borné.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ *
+ * La recherche se fait par approfondissement itératif : profondeur 1, puis 2,
+ * etc. jusqu'à l'échéance du coup. Chaque itération essaye d'abord la
+ * variation principale de l'itération précédente, ce qui rend les coupures
+ * alpha-beta beaucoup plus efficaces. Une itération interrompue par
+ * l'échéance est abandonnée et le meilleur coup de la dernière itération
+ * complète est joué.
+ *
+ * Si le joueur a une table de transposition, les positions déjà cherchées
+ * assez profondément ne sont pas recherchées à nouveau, et leur meilleur coup
+ * est essayé en premier. La table est gardée d'un coup à l'autre. Elle est
+ * indexée par la clé canonique (voir ::grille_cle_canonique) : les positions
+ * symétriques les unes des autres partagent une seule entrée.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "strategies.h"
+#include "horloge.h"
+
+#define ALPHABETA_PROFONDEUR_MAX 32      /**< Profondeur maximale de recherche. */
+#define ALPHABETA_LARGEUR        12      /**< Nombre de coups essayés par position. */
+#define ALPHABETA_VOISINAGE      2       /**< Distance maximale d'un coup à un pion. */
+#define ALPHABETA_GAGNE          1000000 /**< Score d'une partie gagnée. */
+#define ALPHABETA_INFINI         (2 * ALPHABETA_GAGNE)
+/** Plus grande évaluation statique, en dessous des scores de partie gagnée. */
+#define ALPHABETA_EVALUATION_MAX (ALPHABETA_GAGNE - ALPHABETA_PROFONDEUR_MAX - 1)
+/** Poids d'une case où un joueur aligne ses pions et gagne. */
+#define ALPHABETA_POIDS_GAGNANT  (ALPHABETA_GAGNE / 4)
+/** Longueur au delà de laquelle une ligne qui ne gagne pas ne pèse pas plus. */
+#define ALPHABETA_LONGUEUR_POIDS 5
+#define ALPHABETA_NOEUDS_HORLOGE 15      /**< L'échéance est vérifiée tous les 16 noeuds. */
+
+/**
+ * \struct RechercheAB
+ * \brief État d'une recherche alpha-beta.
+ *
+ * Les tampons de coups sont alloués une fois par recherche, une tranche par
+ * niveau de profondeur.
+ */
+typedef struct RechercheAB {
+	Grille* grille;         /*!< Grille sur laquelle on cherche. */
+	int joueurs[2];         /*!< Identifiants : 0 pour nous, 1 pour l'adversaire. */
+	int cases;              /*!< Nombre de cases de la grille. */
+	double echeance;        /*!< Heure à laquelle la recherche doit s'arrêter. */
+	long noeuds;            /*!< Nombre de positions visitées. */
+	int interrompue;        /*!< Non nul si l'échéance est passée. */
+	int* coups;             /*!< Coups candidats, cases par niveau. */
+	int* scores;            /*!< Score d'ordonnancement des coups candidats. */
+	int pv[ALPHABETA_PROFONDEUR_MAX][ALPHABETA_PROFONDEUR_MAX]; /*!< Variations principales triangulaires. */
+	int pv_longueur[ALPHABETA_PROFONDEUR_MAX];                  /*!< Longueur de chaque variation. */
+	int pv_precedente[ALPHABETA_PROFONDEUR_MAX];                /*!< Variation principale de l'itération précédente. */
+	int pv_precedente_longueur;                                 /*!< Longueur de pv_precedente. */
+	int suivre_pv;          /*!< Non nul tant qu'on suit la variation précédente. */
+	TableTransposition* table; /*!< Table de transposition du joueur, peut être NULL. */
+} RechercheAB;
+
+/**
+ * \fn static int alphabeta_poids(Grille* grille, int longueur)
+ * \brief Valeur d'une ligne potentielle d'une longueur donnée.
+ *
+ * Une ligne qui ne gagne pas pèse au plus 8 puissance
+ * ::ALPHABETA_LONGUEUR_POIDS, bien moins qu'une case gagnante, quel que
+ * soit l'alignement.
+ */
+static int alphabeta_poids(Grille* grille, int longueur) {
+	if(longueur >= grille->alignement) {
+		return ALPHABETA_POIDS_GAGNANT;
+	}
+	if(longueur > ALPHABETA_LONGUEUR_POIDS) {
+		longueur = ALPHABETA_LONGUEUR_POIDS;
+	}
+	return 1 << (3 * longueur);
+}
+
+/**
+ * \fn static int alphabeta_candidats(RechercheAB* recherche, int niveau, int cote, int* evaluation)
+ * \brief Génère et ordonne les coups candidats d'une position.
+ *
+ * Les candidats sont les cases vides proches d'un pion, tenus à jour par la
+ * grille (voir ::grille_suivre_candidats). Chacun est noté
+ * par les lignes que le joueur au trait y ferait (attaque) et celles que
+ * l'adversaire y ferait (défense). Seuls les ALPHABETA_LARGEUR meilleurs
+ * sont gardés, précédés du coup de la variation principale précédente ou, à
+ * défaut, du coup de la table de transposition.
+ *
+ * La même boucle calcule l'évaluation statique de la position pour le
+ * joueur au trait : la somme des attaques moins la somme des défenses,
+ * bornée par ::ALPHABETA_EVALUATION_MAX pour ne jamais passer pour une
+ * partie gagnée ou perdue.
+ *
+ * \param recherche État de la recherche.
+ * \param niveau Profondeur courante depuis la racine.
+ * \param cote Joueur au trait (0 nous, 1 l'adversaire).
+ * \param evaluation Pointeur pour sauver l'évaluation statique.
+ * \param coup_table Coup de la table de transposition, -1 s'il n'y en a pas.
+ * \return Le nombre de coups candidats rangés dans la tranche du niveau.
+ */
+static int alphabeta_candidats(RechercheAB* recherche, int niveau, int cote, int* evaluation, int coup_table) {
+	Grille* grille = recherche->grille;
+	int* coups  = &recherche->coups[niveau * recherche->cases];
+	int* scores = &recherche->scores[niveau * recherche->cases];
+	int nombre = 0;
+	long somme = 0;
+	int rang, indice;
+	int i, k;
+
+	*evaluation = 0;
+
+	if(grille->libres == recherche->cases) {
+		coups[0] = (grille->largeur / 2) * grille->longueur + grille->longueur / 2;
+		return 1;
+	}
+
+	for(rang = 0; (indice = grille_candidat(grille, rang)) >= 0; rang++) {
+		int x = indice % grille->longueur;
+		int y = indice / grille->longueur;
+		int attaque = alphabeta_poids(grille, grille_meilleure_ligne(grille, recherche->joueurs[cote], x, y));
+		int defense = alphabeta_poids(grille, grille_meilleure_ligne(grille, recherche->joueurs[1 - cote], x, y));
+
+		somme += attaque - defense;
+
+		coups[nombre]  = indice;
+		scores[nombre] = 2 * attaque + defense;
+		nombre++;
+	}
+	*evaluation = somme > ALPHABETA_EVALUATION_MAX ? ALPHABETA_EVALUATION_MAX
+			: somme < -ALPHABETA_EVALUATION_MAX ? -ALPHABETA_EVALUATION_MAX
+			: (int) somme;
+
+	/* Sélection des meilleurs coups en tête de tranche. */
+	for(k = 0; k < nombre && k < ALPHABETA_LARGEUR; k++) {
+		int meilleur = k;
+		int tmp;
+		for(i = k + 1; i < nombre; i++) {
+			if(scores[i] > scores[meilleur]) {
+				meilleur = i;
+			}
+		}
+		tmp = coups[k];  coups[k]  = coups[meilleur];  coups[meilleur]  = tmp;
+		tmp = scores[k]; scores[k] = scores[meilleur]; scores[meilleur] = tmp;
+	}
+
+	/* Le coup de la variation principale passe en premier. */
+	if(recherche->suivre_pv) {
+		int pv_coup = niveau < recherche->pv_precedente_longueur ? recherche->pv_precedente[niveau] : -1;
+		recherche->suivre_pv = 0;
+		for(i = 0; i < nombre; i++) {
+			if(coups[i] == pv_coup) {
+				for(; i > 0; i--) {
+					coups[i] = coups[i - 1];
+				}
+				coups[0] = pv_coup;
+				recherche->suivre_pv = 1;
+				coup_table = -1;
+				break;
+			}
+		}
+	}
+
+	/* Sinon, le coup de la table de transposition. */
+	for(i = 0; coup_table >= 0 && i < nombre; i++) {
+		if(coups[i] == coup_table) {
+			for(; i > 0; i--) {
+				coups[i] = coups[i - 1];
+			}
+			coups[0] = coup_table;
+			break;
+		}
+	}
+
+	return nombre < ALPHABETA_LARGEUR ? nombre : ALPHABETA_LARGEUR;
+}
+
+/**
+ * \fn static int alphabeta_score_vers_table(int score, int niveau)
+ * \brief Convertit un score de victoire en distance depuis la position.
+ *
+ * Les scores de victoire dépendent du niveau où la position a été trouvée ;
+ * la table les range relativement à la position elle-même.
+ */
+static int alphabeta_score_vers_table(int score, int niveau) {
+	if(score >= ALPHABETA_GAGNE - ALPHABETA_PROFONDEUR_MAX) {
+		return score + niveau;
+	}
+	if(score <= -ALPHABETA_GAGNE + ALPHABETA_PROFONDEUR_MAX) {
+		return score - niveau;
+	}
+	return score;
+}
+
+/**
+ * \fn static int alphabeta_score_depuis_table(int score, int niveau)
+ * \brief Inverse de ::alphabeta_score_vers_table.
+ */
+static int alphabeta_score_depuis_table(int score, int niveau) {
+	if(score >= ALPHABETA_GAGNE - ALPHABETA_PROFONDEUR_MAX) {
+		return score - niveau;
+	}
+	if(score <= -ALPHABETA_GAGNE + ALPHABETA_PROFONDEUR_MAX) {
+		return score + niveau;
+	}
+	return score;
+}
+
+/**
+ * \fn static int alphabeta_negamax(RechercheAB* recherche, int profondeur, int niveau, int cote, int alpha, int beta)
+ * \brief Recherche negamax avec coupures alpha-beta.
+ *
+ * \param recherche État de la recherche.
+ * \param profondeur Profondeur restante.
+ * \param niveau Profondeur courante depuis la racine.
+ * \param cote Joueur au trait (0 nous, 1 l'adversaire).
+ * \param alpha Borne inférieure de la fenêtre.
+ * \param beta Borne supérieure de la fenêtre.
+ * \return Le score de la position pour le joueur au trait.
+ */
+static int alphabeta_negamax(RechercheAB* recherche, int profondeur, int niveau, int cote, int alpha, int beta) {
+	Grille* grille = recherche->grille;
+	int* coups = &recherche->coups[niveau * recherche->cases];
+	int meilleur = -ALPHABETA_INFINI;
+	int meilleur_coup = -1;
+	int alpha_initial = alpha;
+	int coup_table = -1;
+	int symetrie = 0;
+	int evaluation, nombre, i;
+	uint64_t cle = 0;
+	EntreeTransposition entree;
+
+	recherche->pv_longueur[niveau] = niveau;
+
+	recherche->noeuds++;
+	if((recherche->noeuds & ALPHABETA_NOEUDS_HORLOGE) == 0 && horloge_secondes() > recherche->echeance) {
+		recherche->interrompue = 1;
+	}
+	if(recherche->interrompue) {
+		return 0;
+	}
+
+	if(estPleineGrille(grille)) {
+		return 0;
+	}
+
+	/* Les positions symétriques partagent leur entrée, coup dans la forme canonique. */
+	if(recherche->table != NULL) {
+		cle = grille_cle_canonique(grille, &symetrie);
+	}
+	if(recherche->table != NULL && transposition_sonder(recherche->table, cle, &entree)) {
+		int score = alphabeta_score_depuis_table(entree.score, niveau);
+		int type  = entree.type_age & 3;
+
+		coup_table = entree.coup == TRANSPOSITION_PAS_DE_COUP || entree.coup >= recherche->cases ? -1
+				: grille_symetrie_case(grille->longueur, grille->largeur, grille_symetrie_inverse(symetrie), entree.coup);
+
+		/* Pas de coupure à la racine : il faut une variation principale. */
+		if(niveau > 0 && entree.profondeur >= profondeur && (
+				   type == TRANSPOSITION_EXACT
+				|| (type == TRANSPOSITION_BORNE_INF && score >= beta)
+				|| (type == TRANSPOSITION_BORNE_SUP && score <= alpha))) {
+			return score;
+		}
+	}
+
+	nombre = alphabeta_candidats(recherche, niveau, cote, &evaluation, coup_table);
+	if(profondeur == 0 || nombre == 0 || niveau + 1 >= ALPHABETA_PROFONDEUR_MAX) {
+		return evaluation;
+	}
+
+	for(i = 0; i < nombre; i++) {
+		int x = coups[i] % grille->longueur;
+		int y = coups[i] / grille->longueur;
+		int score;
+
+		if(i > 0) {
+			recherche->suivre_pv = 0;
+		}
+
+		placerPion(grille, recherche->joueurs[cote], x, y);
+		if(alignePion(grille, x, y, grille->alignement)) {
+			score = ALPHABETA_GAGNE - niveau;
+			recherche->pv_longueur[niveau + 1] = niveau + 1;
+		} else {
+			score = -alphabeta_negamax(recherche, profondeur - 1, niveau + 1, 1 - cote, -beta, -alpha);
+		}
+		retirerPion(grille, x, y);
+
+		if(recherche->interrompue) {
+			return 0;
+		}
+
+		if(score > meilleur) {
+			meilleur = score;
+			meilleur_coup = coups[i];
+		}
+		if(score > alpha) {
+			int k;
+			alpha = score;
+			recherche->pv[niveau][niveau] = coups[i];
+			for(k = niveau + 1; k < recherche->pv_longueur[niveau + 1]; k++) {
+				recherche->pv[niveau][k] = recherche->pv[niveau + 1][k];
+			}
+			recherche->pv_longueur[niveau] = recherche->pv_longueur[niveau + 1];
+			if(alpha >= beta) {
+				break;
+			}
+		}
+	}
+
+	if(recherche->table != NULL) {
+		int type = meilleur <= alpha_initial ? TRANSPOSITION_BORNE_SUP
+				: meilleur >= beta ? TRANSPOSITION_BORNE_INF
+				: TRANSPOSITION_EXACT;
+		transposition_stocker(recherche->table, cle, profondeur,
+				alphabeta_score_vers_table(meilleur, niveau), type, meilleur_coup < 0 ? -1
+				: grille_symetrie_case(grille->longueur, grille->largeur, symetrie, meilleur_coup));
+	}
+
+	return meilleur;
+}
+
+/**
+ * \fn void strategie_alphabeta(Joueur* joueur, Grille* grille, int* x, int* y)
+ * \brief Stratégie negamax alpha-beta par approfondissement itératif.
+ *
+ * Dans la solution exacte ou le livre d'ouvertures, leur coup est joué sans
+ * recherche. Sinon la recherche s'arrête à l'échéance fixée par
+ * Joueur::budget_ms, et joue le meilleur coup de la dernière itération
+ * complète. Si aucune itération n'a eu le temps de finir, le meilleur
+ * candidat selon l'ordonnancement est joué.
+ *
+ * \param joueur Joueur qui a la stratégie.
+ * \param grille Grille sur laquelle il faut jouer.
+ * \param x Pointeur pour sauver la position x de la case choisie.
+ * \param y Pointeur pour sauver la position y de la case choisie.
+ */
+void strategie_alphabeta(Joueur* joueur, Grille* grille, int* x, int* y) {
+	RechercheAB recherche;
+	int profondeur, evaluation, meilleur_coup;
+
+	if(strategie_coup_connu(joueur, grille, x, y)) {
+		return;
+	}
+
+	recherche.grille      = grille;
+	recherche.joueurs[0]  = joueur->id;
+	recherche.joueurs[1]  = strategie_adversaire(grille, joueur->id);
+	recherche.cases       = grille->longueur * grille->largeur;
+	recherche.echeance    = horloge_secondes() + joueur->budget_ms / 1000.0;
+	recherche.noeuds      = 0;
+	recherche.interrompue = 0;
+	recherche.suivre_pv   = 0;
+	recherche.pv_precedente_longueur = 0;
+	recherche.table       = joueur->table;
+
+	if(recherche.table != NULL) {
+		transposition_nouvelle_recherche(recherche.table);
+	}
+	grille_suivre_candidats(grille, ALPHABETA_VOISINAGE);
+	if(recherche.table != NULL) {
+		grille_suivre_symetries(grille);
+	}
+
+	recherche.coups  = (int*) malloc(sizeof(int) * recherche.cases * ALPHABETA_PROFONDEUR_MAX);
+	recherche.scores = (int*) malloc(sizeof(int) * recherche.cases * ALPHABETA_PROFONDEUR_MAX);
+	if(recherche.coups == NULL || recherche.scores == NULL) {
+		perror("Impossible d'allouer les coups de la recherche alpha-beta.");
+		exit(EXIT_FAILURE);
+	}
+
+	alphabeta_candidats(&recherche, 0, 0, &evaluation, -1);
+	meilleur_coup = recherche.coups[0];
+
+	for(profondeur = 1; profondeur < ALPHABETA_PROFONDEUR_MAX && profondeur <= grille->libres; profondeur++) {
+		int score;
+
+		recherche.suivre_pv = 1;
+		score = alphabeta_negamax(&recherche, profondeur, 0, 0, -ALPHABETA_INFINI, ALPHABETA_INFINI);
+		if(recherche.interrompue) {
+			break;
+		}
+
+		meilleur_coup = recherche.pv[0][0];
+		for(recherche.pv_precedente_longueur = 0;
+				recherche.pv_precedente_longueur < recherche.pv_longueur[0];
+				recherche.pv_precedente_longueur++) {
+			recherche.pv_precedente[recherche.pv_precedente_longueur] =
+					recherche.pv[0][recherche.pv_precedente_longueur];
+		}
+
+		/* Victoire ou défaite forcée : chercher plus loin ne change rien. */
+		if(score >= ALPHABETA_GAGNE - ALPHABETA_PROFONDEUR_MAX
+				|| score <= -ALPHABETA_GAGNE + ALPHABETA_PROFONDEUR_MAX) {
+			break;
+		}
+	}
+
+	free(recherche.coups);
+	free(recherche.scores);
+
+	*x = meilleur_coup % grille->longueur;
+	*y = meilleur_coup / grille->longueur;
+
+	placerPion(grille, joueur->id, *x, *y);
+}
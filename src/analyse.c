@@ -0,0 +1,542 @@
+/**
+ * \file analyse.c
+ * \brief Statistiques sur des archives de parties, lues en parallèle.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ *
+ * Les archives sont projetées en mémoire et leurs blocs distribués aux
+ * threads par paquets de ::ANALYSE_BLOCS_PAR_PAQUET, au fur et à mesure :
+ * aucun thread n'attend qu'un autre ait fini un gros fichier. Chaque thread
+ * compte dans ses propres statistiques, additionnées à la fin.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <getopt.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "archive.h"
+#include "grille.h"
+#include "horloge.h"
+
+#define ANALYSE_MAX_CONFIGS 8         /**< Configurations distinctes comptées à part. */
+#define ANALYSE_BLOCS_PAR_PAQUET 4    /**< Blocs pris d'un coup par un thread. */
+#define ANALYSE_MAX_CASES 65536       /**< Cases au plus d'une grille archivée. */
+
+/**
+ * \struct AnalyseFichier
+ * \brief Une archive projetée en mémoire.
+ */
+typedef struct AnalyseFichier {
+	const char* chemin;          /*!< Chemin de l'archive. */
+	const unsigned char* carte;  /*!< Projection de l'archive, NULL si vide. */
+	size_t taille;               /*!< Taille de l'archive en octets. */
+	long premier_bloc;           /*!< Rang global de son premier bloc. */
+	long nb_blocs;               /*!< Nombre de ses blocs. */
+} AnalyseFichier;
+
+/**
+ * \struct AnalyseConfig
+ * \brief Statistiques des parties d'une configuration.
+ */
+typedef struct AnalyseConfig {
+	MorpionConfig config;   /*!< Configuration comptée. */
+	long parties;           /*!< Parties lues. */
+	long coups;             /*!< Coups joués. */
+	long premier;           /*!< Parties gagnées par le premier joueur. */
+	long nulles;            /*!< Parties sans gagnant. */
+	long* longueurs;        /*!< Parties par nombre de coups, de 0 à longueur * largeur. */
+	long* ouvertures;       /*!< Par case du premier coup : parties, victoires du premier joueur, nulles. */
+	Grille* grille;         /*!< Grille pour vérifier les parties, NULL sans vérification. */
+} AnalyseConfig;
+
+/**
+ * \struct AnalyseTravail
+ * \brief Blocs à lire et statistiques d'un thread.
+ */
+typedef struct AnalyseTravail {
+	pthread_t thread;                              /*!< Thread qui lit. */
+	AnalyseFichier* fichiers;                      /*!< Archives, partagées. */
+	int nb_fichiers;                               /*!< Nombre d'archives. */
+	long total_blocs;                              /*!< Blocs de toutes les archives. */
+	long* prochain;                                /*!< Prochain bloc à distribuer, partagé. */
+	int verifier;                                  /*!< Vrai pour rejouer chaque partie. */
+	AnalyseConfig configs[ANALYSE_MAX_CONFIGS];    /*!< Statistiques par configuration. */
+	int nb_configs;                                /*!< Configurations rencontrées. */
+	long autres;                                   /*!< Parties des configurations suivantes. */
+	long blocs;                                    /*!< Blocs lus. */
+	long octets;                                   /*!< Octets de parties lus. */
+	long invalides;                                /*!< Blocs dont une partie est illisible. */
+	long incoherentes;                             /*!< Parties dont les coups contredisent le résultat. */
+} AnalyseTravail;
+
+/**
+ * \struct AnalyseOptions
+ * \brief Options de la ligne de commande.
+ */
+typedef struct AnalyseOptions {
+	int threads;       /*!< Nombre de threads. */
+	int verifier;      /*!< Vrai pour rejouer chaque partie. */
+	int ouvertures;    /*!< Nombre d'ouvertures affichées par configuration. */
+} AnalyseOptions;
+
+/**
+ * \fn static void analyse_usage(FILE* stream, int exit_code)
+ * \brief Affiche comment utiliser la commande.
+ *
+ * \param stream Le flux où écrire l'aide.
+ * \param exit_code Le code d'erreur à utiliser.
+ */
+static void analyse_usage(FILE* stream, int exit_code) {
+	fprintf(stream, "Utilisation : analyse options archive...\n");
+	fprintf(stream,
+			" -t --threads n          Nombre de threads (nombre de coeurs).\n"
+			" -v --verifier           Rejoue chaque partie pour vérifier son résultat.\n"
+			" -n --ouvertures n       Nombre de premiers coups affichés (10).\n"
+			" -h --help               Affiche une aide et quitte le programme.\n"
+	);
+	exit(exit_code);
+}
+
+/**
+ * \fn static AnalyseOptions analyse_parse_options(int argc, char* argv[])
+ * \brief Lit les options de la ligne de commande.
+ *
+ * Les archives sont les arguments à partir de optind.
+ *
+ * \param argc Nombre d'arguments de la commande (du main).
+ * \param argv Tableau des chaines des arguments de la commande (du main).
+ * \return Les options.
+ */
+static AnalyseOptions analyse_parse_options(int argc, char* argv[]) {
+	int next_option;
+	const char* const short_options = "t:vn:h";
+
+	const struct option long_options[] = {
+		{ "threads",    1, NULL, 't' },
+		{ "verifier",   0, NULL, 'v' },
+		{ "ouvertures", 1, NULL, 'n' },
+		{ "help",       0, NULL, 'h' },
+		{ NULL,         0, NULL,   0 }
+	};
+
+	AnalyseOptions options;
+	options.threads    = sysconf(_SC_NPROCESSORS_ONLN);
+	options.verifier   = 0;
+	options.ouvertures = 10;
+
+	do {
+		next_option = getopt_long(argc, argv, short_options, long_options, NULL);
+
+		switch (next_option) {
+		case 't':
+			options.threads = atoi(optarg);
+			break;
+		case 'v':
+			options.verifier = 1;
+			break;
+		case 'n':
+			options.ouvertures = atoi(optarg);
+			break;
+		case 'h':
+			analyse_usage(stdout, 0);
+			break;
+		case '?':
+			analyse_usage(stderr, 1);
+			break;
+		case -1:
+			break;
+		default:
+			abort();
+		}
+	} while (next_option != -1);
+
+	if(options.threads < 1 || optind >= argc) {
+		analyse_usage(stderr, 1);
+	}
+
+	return options;
+}
+
+/**
+ * \fn static int analyse_config_valide(MorpionConfig config)
+ * \brief Vérifie les dimensions lues dans une partie avant de les allouer.
+ *
+ * \return 1 si la grille a entre 1 et ::ANALYSE_MAX_CASES cases, 0 sinon.
+ */
+static int analyse_config_valide(MorpionConfig config) {
+	return config.longueur >= 1 && config.largeur >= 1
+		&& config.longueur <= ANALYSE_MAX_CASES / config.largeur;
+}
+
+/**
+ * \fn static AnalyseConfig* analyse_config(AnalyseTravail* travail, MorpionConfig config)
+ * \brief Trouve ou ajoute les statistiques d'une configuration.
+ *
+ * \return Les statistiques, NULL s'il y a déjà ::ANALYSE_MAX_CONFIGS configurations.
+ */
+static AnalyseConfig* analyse_config(AnalyseTravail* travail, MorpionConfig config) {
+	AnalyseConfig* stats;
+	size_t cellules = (size_t) config.longueur * config.largeur;
+	int i;
+
+	for(i = 0; i < travail->nb_configs; i++) {
+		stats = &travail->configs[i];
+		if(stats->config.longueur == config.longueur && stats->config.largeur == config.largeur
+				&& stats->config.alignement == config.alignement) {
+			return stats;
+		}
+	}
+	if(travail->nb_configs == ANALYSE_MAX_CONFIGS) {
+		return NULL;
+	}
+
+	stats = &travail->configs[travail->nb_configs++];
+	memset(stats, 0, sizeof(AnalyseConfig));
+	stats->config     = config;
+	stats->longueurs  = (long*) calloc(cellules + 1, sizeof(long));
+	stats->ouvertures = (long*) calloc(3 * cellules, sizeof(long));
+	if(stats->longueurs == NULL || stats->ouvertures == NULL) {
+		perror("Impossible d'allouer les statistiques d'une configuration.");
+		exit(EXIT_FAILURE);
+	}
+	if(travail->verifier) {
+		stats->grille = initGrille(config.longueur, config.largeur);
+		if(stats->grille == NULL) {
+			exit(EXIT_FAILURE);
+		}
+	}
+	return stats;
+}
+
+/**
+ * \fn static int analyse_verifier(Grille* grille, const PartieArchivee* partie)
+ * \brief Rejoue une partie et vérifie son résultat.
+ *
+ * Les cases doivent être libres, seul le dernier coup peut aligner, et il
+ * aligne si et seulement si la partie a un gagnant, celui qui l'a joué.
+ *
+ * \return 1 si la partie est cohérente, 0 sinon.
+ */
+static int analyse_verifier(Grille* grille, const PartieArchivee* partie) {
+	int k;
+
+	grille_vider(grille);
+	for(k = 0; k < partie->nb_coups; k++) {
+		int joueur = partie->joueurs[k % partie->nb_joueurs];
+		int x = partie->cases[k] % grille->longueur;
+		int y = partie->cases[k] / grille->longueur;
+
+		if(GRILLE_OCTET(grille, x, y) != 0) {
+			return 0;
+		}
+		placerPion(grille, joueur, x, y);
+		if(alignePion(grille, x, y, partie->config.alignement)) {
+			return k == partie->nb_coups - 1 && partie->gagnant == joueur;
+		}
+	}
+	return partie->gagnant == 0;
+}
+
+/**
+ * \fn static void analyse_compter(AnalyseTravail* travail, const PartieArchivee* partie)
+ * \brief Ajoute une partie aux statistiques du thread.
+ */
+static void analyse_compter(AnalyseTravail* travail, const PartieArchivee* partie) {
+	AnalyseConfig* stats = analyse_config(travail, partie->config);
+
+	if(stats == NULL) {
+		travail->autres += 1;
+		return;
+	}
+	if(stats->grille != NULL && !analyse_verifier(stats->grille, partie)) {
+		travail->incoherentes += 1;
+	}
+
+	stats->parties += 1;
+	stats->coups   += partie->nb_coups;
+	stats->longueurs[partie->nb_coups] += 1;
+	if(partie->gagnant == 0) {
+		stats->nulles += 1;
+	} else if(partie->gagnant == partie->joueurs[0]) {
+		stats->premier += 1;
+	}
+	if(partie->nb_coups > 0) {
+		long* ouverture = &stats->ouvertures[3 * partie->cases[0]];
+		ouverture[0] += 1;
+		ouverture[1] += partie->gagnant != 0 && partie->gagnant == partie->joueurs[0];
+		ouverture[2] += partie->gagnant == 0;
+	}
+}
+
+/**
+ * \fn static void* analyse_thread(void* argument)
+ * \brief Lit des paquets de blocs jusqu'à ce qu'il n'en reste plus.
+ */
+static void* analyse_thread(void* argument) {
+	AnalyseTravail* travail = (AnalyseTravail*) argument;
+	PartieArchivee partie;
+	int fichier = 0;
+
+	partie.cases    = NULL;
+	partie.capacite = 0;
+
+	while(1) {
+		long debut = __atomic_fetch_add(travail->prochain, ANALYSE_BLOCS_PAR_PAQUET, __ATOMIC_RELAXED);
+		long rang;
+
+		if(debut >= travail->total_blocs) {
+			break;
+		}
+		for(rang = debut; rang < debut + ANALYSE_BLOCS_PAR_PAQUET && rang < travail->total_blocs; rang++) {
+			AnalyseFichier* courant;
+			const unsigned char* donnees;
+			size_t octets, lus;
+
+			/* Les paquets d'un thread se suivent : le fichier ne recule jamais. */
+			while(rang >= travail->fichiers[fichier].premier_bloc + travail->fichiers[fichier].nb_blocs) {
+				fichier++;
+			}
+			courant = &travail->fichiers[fichier];
+
+			octets = archive_bloc(courant->carte, courant->taille, rang - courant->premier_bloc, &donnees);
+			travail->blocs  += 1;
+			travail->octets += octets;
+			while(octets > 0) {
+				lus = archive_lire_partie(donnees, octets, &partie);
+				if(lus == 0 || !analyse_config_valide(partie.config)) {
+					travail->invalides += 1;
+					break;
+				}
+				analyse_compter(travail, &partie);
+				donnees += lus;
+				octets  -= lus;
+			}
+		}
+	}
+
+	free(partie.cases);
+	return NULL;
+}
+
+/**
+ * \fn static void analyse_ouvrir(AnalyseFichier* fichier, const char* chemin)
+ * \brief Projette une archive en mémoire pour une lecture séquentielle.
+ */
+static void analyse_ouvrir(AnalyseFichier* fichier, const char* chemin) {
+	struct stat etat;
+	int fd = open(chemin, O_RDONLY);
+
+	if(fd < 0 || fstat(fd, &etat) < 0) {
+		perror(chemin);
+		exit(EXIT_FAILURE);
+	}
+
+	fichier->chemin = chemin;
+	fichier->taille = etat.st_size;
+	fichier->carte  = NULL;
+	if(fichier->taille > 0) {
+		void* carte = mmap(NULL, fichier->taille, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(carte == MAP_FAILED) {
+			perror("Impossible de projeter l'archive en mémoire.");
+			exit(EXIT_FAILURE);
+		}
+		madvise(carte, fichier->taille, MADV_SEQUENTIAL);
+		fichier->carte = (const unsigned char*) carte;
+	}
+	fichier->nb_blocs = archive_nombre_blocs(fichier->taille);
+	close(fd);
+}
+
+/**
+ * \fn static void analyse_additionner(AnalyseTravail* total, AnalyseTravail* travail)
+ * \brief Ajoute les statistiques d'un thread au total puis les libère.
+ */
+static void analyse_additionner(AnalyseTravail* total, AnalyseTravail* travail) {
+	int i;
+
+	total->autres       += travail->autres;
+	total->blocs        += travail->blocs;
+	total->octets       += travail->octets;
+	total->invalides    += travail->invalides;
+	total->incoherentes += travail->incoherentes;
+
+	for(i = 0; i < travail->nb_configs; i++) {
+		AnalyseConfig* source = &travail->configs[i];
+		AnalyseConfig* cible  = analyse_config(total, source->config);
+		size_t cellules = (size_t) source->config.longueur * source->config.largeur;
+		size_t k;
+
+		if(cible == NULL) {
+			total->autres += source->parties;
+		} else {
+			cible->parties += source->parties;
+			cible->coups   += source->coups;
+			cible->premier += source->premier;
+			cible->nulles  += source->nulles;
+			for(k = 0; k <= cellules; k++) {
+				cible->longueurs[k] += source->longueurs[k];
+			}
+			for(k = 0; k < 3 * cellules; k++) {
+				cible->ouvertures[k] += source->ouvertures[k];
+			}
+		}
+
+		free(source->longueurs);
+		free(source->ouvertures);
+		if(source->grille != NULL) {
+			libererGrille(source->grille);
+		}
+	}
+}
+
+/**
+ * \fn static void analyse_afficher(const AnalyseConfig* stats, int ouvertures)
+ * \brief Affiche les statistiques d'une configuration.
+ *
+ * \param stats Statistiques additionnées.
+ * \param ouvertures Nombre de premiers coups affichés, les plus joués d'abord.
+ */
+static void analyse_afficher(const AnalyseConfig* stats, int ouvertures) {
+	int cellules = stats->config.longueur * stats->config.largeur;
+	int* ordre;
+	int i, j;
+
+	printf("%dx%d alignement %d : %ld parties, %.1f coups en moyenne, "
+			"premier joueur %.1f %%, nulles %.1f %%\n",
+			stats->config.longueur, stats->config.largeur, stats->config.alignement,
+			stats->parties, (double) stats->coups / stats->parties,
+			100.0 * stats->premier / stats->parties, 100.0 * stats->nulles / stats->parties);
+
+	printf("  coups :");
+	for(i = 0; i <= cellules; i++) {
+		if(stats->longueurs[i] > 0) {
+			printf(" %d:%ld", i, stats->longueurs[i]);
+		}
+	}
+	printf("\n");
+
+	ordre = (int*) malloc(sizeof(int) * cellules);
+	if(ordre == NULL) {
+		perror("Impossible d'allouer le tri des ouvertures.");
+		exit(EXIT_FAILURE);
+	}
+	for(i = 0; i < cellules; i++) {
+		ordre[i] = i;
+	}
+	/* Tri partiel par sélection : seules les premières ouvertures comptent. */
+	for(i = 0; i < cellules && i < ouvertures; i++) {
+		int meilleure = i;
+		for(j = i + 1; j < cellules; j++) {
+			if(stats->ouvertures[3 * ordre[j]] > stats->ouvertures[3 * ordre[meilleure]]) {
+				meilleure = j;
+			}
+		}
+		j = ordre[i];
+		ordre[i] = ordre[meilleure];
+		ordre[meilleure] = j;
+	}
+	for(i = 0; i < cellules && i < ouvertures; i++) {
+		const long* ouverture = &stats->ouvertures[3 * ordre[i]];
+		if(ouverture[0] == 0) {
+			break;
+		}
+		printf("  ouverture (%d, %d) : %ld parties, premier joueur %.1f %%, nulles %.1f %%\n",
+				ordre[i] % stats->config.longueur, ordre[i] / stats->config.longueur, ouverture[0],
+				100.0 * ouverture[1] / ouverture[0], 100.0 * ouverture[2] / ouverture[0]);
+	}
+	free(ordre);
+}
+
+/**
+ * \fn int main(int argc, char* argv[])
+ * \brief Point d'entrée de l'analyse des archives.
+ *
+ * \param argc Nombre d'arguments de la commande.
+ * \param argv Tableau des arguments.
+ *
+ * \return Code de sortie du programme.
+ */
+int main(int argc, char* argv[]) {
+	AnalyseOptions options = analyse_parse_options(argc, argv);
+	int nb_fichiers = argc - optind;
+	AnalyseFichier* fichiers;
+	AnalyseTravail* travaux;
+	AnalyseTravail total;
+	long total_blocs = 0, prochain = 0, parties;
+	double debut, duree;
+	int i;
+
+	fichiers = (AnalyseFichier*) malloc(sizeof(AnalyseFichier) * nb_fichiers);
+	travaux  = (AnalyseTravail*) malloc(sizeof(AnalyseTravail) * options.threads);
+	if(fichiers == NULL || travaux == NULL) {
+		perror("Impossible d'allouer les travaux des threads.");
+		exit(EXIT_FAILURE);
+	}
+	for(i = 0; i < nb_fichiers; i++) {
+		analyse_ouvrir(&fichiers[i], argv[optind + i]);
+		fichiers[i].premier_bloc = total_blocs;
+		total_blocs += fichiers[i].nb_blocs;
+	}
+
+	debut = horloge_secondes();
+	for(i = 0; i < options.threads; i++) {
+		memset(&travaux[i], 0, sizeof(AnalyseTravail));
+		travaux[i].fichiers    = fichiers;
+		travaux[i].nb_fichiers = nb_fichiers;
+		travaux[i].total_blocs = total_blocs;
+		travaux[i].prochain    = &prochain;
+		travaux[i].verifier    = options.verifier;
+		if(pthread_create(&travaux[i].thread, NULL, analyse_thread, &travaux[i]) != 0) {
+			perror("Impossible de créer un thread.");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	memset(&total, 0, sizeof(total));
+	for(i = 0; i < options.threads; i++) {
+		pthread_join(travaux[i].thread, NULL);
+		analyse_additionner(&total, &travaux[i]);
+	}
+	duree = horloge_secondes() - debut;
+	if(duree <= 0) {
+		duree = 1e-9;
+	}
+
+	parties = total.autres;
+	for(i = 0; i < total.nb_configs; i++) {
+		parties += total.configs[i].parties;
+	}
+	printf("%d archives, %ld blocs, %d threads : %ld parties, %.3f s, %.1f parties/s, %.1f Mo/s\n",
+			nb_fichiers, total.blocs, options.threads, parties, duree,
+			parties / duree, total.octets / duree / (1 << 20));
+	for(i = 0; i < total.nb_configs; i++) {
+		analyse_afficher(&total.configs[i], options.ouvertures);
+		free(total.configs[i].longueurs);
+		free(total.configs[i].ouvertures);
+	}
+	if(total.autres > 0) {
+		printf("autres configurations : %ld parties\n", total.autres);
+	}
+	if(total.invalides > 0) {
+		printf("blocs illisibles : %ld\n", total.invalides);
+	}
+	if(options.verifier) {
+		printf("parties incohérentes : %ld\n", total.incoherentes);
+	}
+
+	for(i = 0; i < nb_fichiers; i++) {
+		if(fichiers[i].carte != NULL) {
+			munmap((void*) fichiers[i].carte, fichiers[i].taille);
+		}
+	}
+	free(fichiers);
+	free(travaux);
+
+	return total.invalides > 0 || total.incoherentes > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,320 @@
+/**
+ * \file archive.c
+ * \brief Archive compacte des parties jouées, pour les analyser en masse.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "archive.h"
+#include "format.h"
+
+/**
+ * \fn static int archive_ecrire_tout(int fd, const unsigned char* donnees, size_t taille, off_t position)
+ * \brief Écrit tous les octets à une position, même si pwrite s'interrompt.
+ *
+ * \return 1 si tout est écrit, 0 sinon.
+ */
+static int archive_ecrire_tout(int fd, const unsigned char* donnees, size_t taille, off_t position) {
+	while(taille > 0) {
+		ssize_t ecrits = pwrite(fd, donnees, taille, position);
+		if(ecrits < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+			return 0;
+		}
+		donnees  += ecrits;
+		taille   -= (size_t) ecrits;
+		position += ecrits;
+	}
+	return 1;
+}
+
+/**
+ * \fn static void archive_vider(Archive* archive, int complet)
+ * \brief Écrit le bloc en cours à sa place dans le fichier.
+ *
+ * Un bloc incomplet peut être écrit plusieurs fois : chaque écriture
+ * remplace la précédente, entête comprise.
+ *
+ * \param archive Archive, verrou tenu.
+ * \param complet 1 pour écrire le bloc entier complété de zéros et en
+ * commencer un nouveau, 0 pour n'écrire que sa partie utilisée.
+ */
+static void archive_vider(Archive* archive, int complet) {
+	size_t taille = complet ? ARCHIVE_TAILLE_BLOC : archive->rempli;
+
+	if(archive->rempli == ARCHIVE_ENTETE || (!complet && archive->rempli == archive->ecrit)) {
+		return;
+	}
+
+	archive->bloc[0] = ARCHIVE_MAGIQUE;
+	archive->bloc[1] = ARCHIVE_VERSION;
+	archive->bloc[2] = 0;
+	archive->bloc[3] = 0;
+	format_ecrire_u32(archive->bloc + 4, archive->rempli - ARCHIVE_ENTETE);
+	memset(archive->bloc + archive->rempli, 0, ARCHIVE_TAILLE_BLOC - archive->rempli);
+
+	if(!archive_ecrire_tout(archive->fd, archive->bloc, taille, archive->position)) {
+		perror("Impossible d'écrire l'archive des parties.");
+	}
+	if(complet) {
+		archive->position += ARCHIVE_TAILLE_BLOC;
+		archive->rempli    = ARCHIVE_ENTETE;
+	}
+	archive->ecrit = archive->rempli;
+}
+
+/**
+ * \fn Archive* archive_ouvrir(const char* chemin)
+ * \brief Ouvre une archive pour y ajouter des parties.
+ *
+ * L'archive est créée si elle n'existe pas. Si son dernier bloc est
+ * incomplet, les nouvelles parties commencent au bloc suivant : le trou
+ * se lit comme des zéros.
+ *
+ * \param chemin Fichier de l'archive.
+ * \return L'archive, NULL en cas d'échec.
+ */
+Archive* archive_ouvrir(const char* chemin) {
+	Archive* archive = (Archive*) malloc(sizeof(Archive));
+	struct stat etat;
+
+	if(archive == NULL) {
+		perror("Impossible d'allouer l'archive des parties.");
+		return NULL;
+	}
+	archive->fd = open(chemin, O_WRONLY | O_CREAT, 0644);
+	if(archive->fd < 0 || fstat(archive->fd, &etat) < 0) {
+		perror("Impossible d'ouvrir l'archive des parties.");
+		free(archive);
+		return NULL;
+	}
+
+	archive->position = (off_t) archive_nombre_blocs(etat.st_size) * ARCHIVE_TAILLE_BLOC;
+	archive->rempli   = ARCHIVE_ENTETE;
+	archive->ecrit    = ARCHIVE_ENTETE;
+	archive->parties = 0;
+	pthread_mutex_init(&archive->verrou, NULL);
+
+	return archive;
+}
+
+/**
+ * \fn int archive_ajouter(Archive* archive, MorpionConfig config, const int* joueurs, int nb_joueurs, int gagnant, const int* cases, int nb_coups)
+ * \brief Ajoute une partie à l'archive.
+ *
+ * \param archive Archive ouverte, éventuellement partagée entre threads.
+ * \param config Configuration de la partie.
+ * \param joueurs Identifiants des joueurs dans l'ordre du jeu, le premier a joué le premier coup.
+ * \param nb_joueurs Nombre de joueurs.
+ * \param gagnant Identifiant du gagnant, 0 si la partie est nulle.
+ * \param cases Indice y * longueur + x de la case de chaque coup.
+ * \param nb_coups Nombre de coups.
+ * \return 1 si la partie est ajoutée, 0 si elle est invalide ou trop longue pour un bloc.
+ */
+int archive_ajouter(Archive* archive, MorpionConfig config, const int* joueurs, int nb_joueurs,
+		int gagnant, const int* cases, int nb_coups) {
+	unsigned long cellules = (unsigned long) config.longueur * config.largeur;
+	unsigned char* tampon;
+	size_t taille;
+	int i;
+
+	if(config.longueur < 1 || config.largeur < 1 || config.alignement < 0
+			|| nb_joueurs < 1 || nb_joueurs > ARCHIVE_MAX_JOUEURS || gagnant < 0
+			|| nb_coups < 0 || (unsigned long) nb_coups > cellules) {
+		return 0;
+	}
+
+	taille = format_taille_varint(config.longueur) + format_taille_varint(config.largeur)
+		+ format_taille_varint(config.alignement) + format_taille_varint(nb_joueurs)
+		+ format_taille_varint(gagnant) + format_taille_varint(nb_coups);
+	for(i = 0; i < nb_joueurs; i++) {
+		if(joueurs[i] < 0) {
+			return 0;
+		}
+		taille += format_taille_varint(joueurs[i]);
+	}
+	for(i = 0; i < nb_coups; i++) {
+		if(cases[i] < 0 || (unsigned long) cases[i] >= cellules) {
+			return 0;
+		}
+		taille += format_taille_varint(cases[i]);
+	}
+	if(taille > ARCHIVE_TAILLE_BLOC - ARCHIVE_ENTETE) {
+		return 0;
+	}
+
+	pthread_mutex_lock(&archive->verrou);
+	if(archive->rempli + taille > ARCHIVE_TAILLE_BLOC) {
+		archive_vider(archive, 1);
+	}
+
+	tampon = archive->bloc + archive->rempli;
+	tampon += format_ecrire_varint(tampon, config.longueur);
+	tampon += format_ecrire_varint(tampon, config.largeur);
+	tampon += format_ecrire_varint(tampon, config.alignement);
+	tampon += format_ecrire_varint(tampon, nb_joueurs);
+	for(i = 0; i < nb_joueurs; i++) {
+		tampon += format_ecrire_varint(tampon, joueurs[i]);
+	}
+	tampon += format_ecrire_varint(tampon, gagnant);
+	tampon += format_ecrire_varint(tampon, nb_coups);
+	for(i = 0; i < nb_coups; i++) {
+		tampon += format_ecrire_varint(tampon, cases[i]);
+	}
+
+	archive->rempli  += taille;
+	archive->parties += 1;
+	pthread_mutex_unlock(&archive->verrou);
+
+	return 1;
+}
+
+/**
+ * \fn void archive_synchroniser(Archive* archive)
+ * \brief Écrit les parties du bloc en cours sans attendre qu'il soit plein.
+ *
+ * Pour un programme qui ne ferme pas l'archive, comme le serveur : les
+ * parties ajoutées avant l'appel survivent à un arrêt brutal.
+ *
+ * \param archive Archive ouverte, éventuellement partagée entre threads.
+ */
+void archive_synchroniser(Archive* archive) {
+	pthread_mutex_lock(&archive->verrou);
+	archive_vider(archive, 0);
+	pthread_mutex_unlock(&archive->verrou);
+}
+
+/**
+ * \fn void archive_fermer(Archive* archive)
+ * \brief Écrit les dernières parties et ferme l'archive.
+ *
+ * \param archive Archive ouverte, sans autre thread qui y ajoute.
+ */
+void archive_fermer(Archive* archive) {
+	archive_vider(archive, 0);
+	close(archive->fd);
+	pthread_mutex_destroy(&archive->verrou);
+	free(archive);
+}
+
+/**
+ * \fn long archive_nombre_blocs(size_t taille)
+ * \brief Nombre de blocs d'une archive.
+ *
+ * \param taille Taille du fichier en octets.
+ * \return Le nombre de blocs, le dernier peut être incomplet.
+ */
+long archive_nombre_blocs(size_t taille) {
+	return (long) ((taille + ARCHIVE_TAILLE_BLOC - 1) / ARCHIVE_TAILLE_BLOC);
+}
+
+/**
+ * \fn size_t archive_bloc(const unsigned char* carte, size_t taille, long rang, const unsigned char** parties)
+ * \brief Trouve les parties d'un bloc d'une archive en mémoire.
+ *
+ * \param carte Archive entière, projetée en mémoire par exemple.
+ * \param taille Taille de l'archive en octets.
+ * \param rang Rang du bloc.
+ * \param parties Pointeur pour sauver le début des parties du bloc.
+ * \return Le nombre d'octets des parties, 0 si le bloc est vide ou invalide.
+ */
+size_t archive_bloc(const unsigned char* carte, size_t taille, long rang, const unsigned char** parties) {
+	size_t debut = (size_t) rang * ARCHIVE_TAILLE_BLOC;
+	size_t octets;
+
+	if(rang < 0 || debut + ARCHIVE_ENTETE > taille
+			|| carte[debut] != ARCHIVE_MAGIQUE || carte[debut + 1] != ARCHIVE_VERSION) {
+		return 0;
+	}
+	octets = format_lire_u32(carte + debut + 4);
+	if(octets > ARCHIVE_TAILLE_BLOC - ARCHIVE_ENTETE || debut + ARCHIVE_ENTETE + octets > taille) {
+		return 0;
+	}
+
+	*parties = carte + debut + ARCHIVE_ENTETE;
+	return octets;
+}
+
+/**
+ * \fn static int archive_lire_entier(const unsigned char* donnees, size_t taille, size_t* lus, int* valeur)
+ * \brief Lit un varint positif d'une partie.
+ *
+ * \return 1 si le varint est lu, 0 sinon.
+ */
+static int archive_lire_entier(const unsigned char* donnees, size_t taille, size_t* lus, int* valeur) {
+	unsigned long lu;
+	size_t n = format_lire_varint(donnees + *lus, taille - *lus, &lu);
+
+	if(n == 0 || lu > 0x7FFFFFFFUL) {
+		return 0;
+	}
+	*lus  += n;
+	*valeur = (int) lu;
+	return 1;
+}
+
+/**
+ * \fn size_t archive_lire_partie(const unsigned char* donnees, size_t taille, PartieArchivee* partie)
+ * \brief Lit la partie suivante d'un bloc.
+ *
+ * Le tableau des cases est agrandi au besoin : initialiser cases à NULL et
+ * capacite à 0 avant la première lecture, libérer cases après la dernière.
+ *
+ * \param donnees Début de la partie.
+ * \param taille Octets restants dans le bloc.
+ * \param partie Partie à remplir.
+ * \return Le nombre d'octets lus, 0 si la partie est invalide ou tronquée.
+ */
+size_t archive_lire_partie(const unsigned char* donnees, size_t taille, PartieArchivee* partie) {
+	size_t lus = 0;
+	long cellules;
+	int i;
+
+	if(!archive_lire_entier(donnees, taille, &lus, &partie->config.longueur)
+			|| !archive_lire_entier(donnees, taille, &lus, &partie->config.largeur)
+			|| !archive_lire_entier(donnees, taille, &lus, &partie->config.alignement)
+			|| !archive_lire_entier(donnees, taille, &lus, &partie->nb_joueurs)
+			|| partie->nb_joueurs < 1 || partie->nb_joueurs > ARCHIVE_MAX_JOUEURS) {
+		return 0;
+	}
+	for(i = 0; i < partie->nb_joueurs; i++) {
+		if(!archive_lire_entier(donnees, taille, &lus, &partie->joueurs[i])) {
+			return 0;
+		}
+	}
+
+	cellules = (long) partie->config.longueur * partie->config.largeur;
+	if(!archive_lire_entier(donnees, taille, &lus, &partie->gagnant)
+			|| !archive_lire_entier(donnees, taille, &lus, &partie->nb_coups)
+			|| partie->nb_coups > cellules) {
+		return 0;
+	}
+
+	if(partie->nb_coups > partie->capacite) {
+		int* cases = (int*) realloc(partie->cases, sizeof(int) * partie->nb_coups);
+		if(cases == NULL) {
+			perror("Impossible d'allouer les coups d'une partie.");
+			return 0;
+		}
+		partie->cases    = cases;
+		partie->capacite = partie->nb_coups;
+	}
+	for(i = 0; i < partie->nb_coups; i++) {
+		if(!archive_lire_entier(donnees, taille, &lus, &partie->cases[i]) || partie->cases[i] >= cellules) {
+			return 0;
+		}
+	}
+
+	return lus;
+}
@@ -4,29 +4,471 @@
  * \author Philippe Lewin <lewinp@esiee.fr>
  * \version 0.1
  * \date Janvier 2013
+ *
+ * Joue un nombre de parties donné pour chaque configuration (longueur,
+ * largeur, alignement) et mesure le débit (parties et coups par seconde) et
+ * la latence de chaque appel à Joueur::place (p50, p99 et max) par joueur.
  */
 #include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
 #include <time.h>
+#include <getopt.h>
 
 #include "morpion.h"
+#include "horloge.h"
+#include "archive.h"
 
-int main(int argc, char* argv[]) {
+#define BENCHMARK_MAX_VALEURS 32 /**< Nombre maximal de valeurs par liste d'options. */
+#define BENCHMARK_MAX_JOUEURS 16 /**< Nombre maximal de joueurs par partie. */
+
+/**
+ * \struct Echantillons
+ * \brief Tableau dynamique de durées en secondes.
+ */
+typedef struct Echantillons {
+	double* valeurs; /*!< Durées mesurées. */
+	int nombre;      /*!< Nombre de durées mesurées. */
+	int capacite;    /*!< Taille allouée de valeurs. */
+} Echantillons;
+
+/**
+ * \struct BenchmarkOptions
+ * \brief Options de la ligne de commande du benchmark.
+ */
+typedef struct BenchmarkOptions {
+	int parties;                               /*!< Parties par configuration. */
+	int longueurs[BENCHMARK_MAX_VALEURS];      /*!< Longueurs à tester. */
+	int nb_longueurs;                          /*!< Nombre de longueurs. */
+	int largeurs[BENCHMARK_MAX_VALEURS];       /*!< Largeurs à tester, 0 pour des grilles carrées. */
+	int nb_largeurs;                           /*!< Nombre de largeurs. */
+	int alignements[BENCHMARK_MAX_VALEURS];    /*!< Alignements à tester. */
+	int nb_alignements;                        /*!< Nombre d'alignements. */
+	char* strategies[BENCHMARK_MAX_JOUEURS];   /*!< Stratégie de chaque joueur. */
+	int nb_strategies;                         /*!< Nombre de joueurs. */
+	int json;                                  /*!< Sortie JSON si non nul. */
+	unsigned int graine;                       /*!< Graine de rand(). */
+	Archive* archive;                          /*!< Archive des parties, NULL sans archive. */
+} BenchmarkOptions;
+
+/**
+ * \struct BenchmarkResultat
+ * \brief Mesures pour une configuration.
+ */
+typedef struct BenchmarkResultat {
+	MorpionConfig config;                          /*!< Configuration testée. */
+	int parties;                                   /*!< Parties jouées. */
+	long coups;                                    /*!< Coups joués. */
+	int nulles;                                    /*!< Parties sans gagnant. */
+	double duree;                                  /*!< Durée totale en secondes. */
+	int victoires[BENCHMARK_MAX_JOUEURS];          /*!< Victoires par joueur. */
+	Echantillons latences[BENCHMARK_MAX_JOUEURS];  /*!< Durée de chaque appel à place par joueur. */
+} BenchmarkResultat;
+
+/**
+ * \fn static void benchmark_usage(FILE* stream, int exit_code)
+ * \brief Affiche comment utiliser le benchmark.
+ *
+ * \param stream Le flux où écrire l'aide.
+ * \param exit_code Le code d'erreur à utiliser.
+ */
+static void benchmark_usage(FILE* stream, int exit_code) {
+	fprintf(stream, "Utilisation : benchmark options\n");
+	fprintf(stream,
+			" -n --parties n          Nombre de parties par configuration (100).\n"
+			" -x --largeur l,...      Largeurs de plateau à tester (8).\n"
+			" -y --hauteur l,...      Hauteurs de plateau à tester (plateau carré).\n"
+			" -a --alignement l,...   Alignements à tester (4).\n"
+	);
+	fprintf(stream,
+			" -s --strategies s,...   Stratégies des joueurs, dans l'ordre (random,defense).\n"
+			" -g --graine n           Graine du générateur aléatoire (heure courante).\n"
+			" -j --json               Affiche les résultats en JSON.\n"
+			" -r --archive fichier    Ajoute les parties jouées à cette archive.\n"
+			" -h --help               Affiche une aide et quitte le programme.\n"
+	);
+	exit(exit_code);
+}
+
+/**
+ * \fn static int benchmark_lire_liste(const char* texte, int* valeurs)
+ * \brief Lit une liste d'entiers séparés par des virgules.
+ *
+ * \param texte La liste, par exemple "8,19".
+ * \param valeurs Tableau de BENCHMARK_MAX_VALEURS entiers à remplir.
+ * \return Le nombre d'entiers lus.
+ */
+static int benchmark_lire_liste(const char* texte, int* valeurs) {
+	int nombre = 0;
+
+	while(*texte != '\0' && nombre < BENCHMARK_MAX_VALEURS) {
+		valeurs[nombre++] = atoi(texte);
+		texte += strcspn(texte, ",");
+		if(*texte == ',') {
+			texte++;
+		}
+	}
+
+	return nombre;
+}
+
+/**
+ * \fn static BenchmarkOptions benchmark_parse_options(int argc, char* argv[])
+ * \brief Lit les options de la ligne de commande.
+ *
+ * \param argc Nombre d'arguments de la commande (du main).
+ * \param argv Tableau des chaines des arguments de la commande (du main).
+ * \return Les options du benchmark.
+ */
+static BenchmarkOptions benchmark_parse_options(int argc, char* argv[]) {
+	int next_option;
+	char* strategie;
+	const char* const short_options = "n:x:y:a:s:g:r:jh";
+
+	const struct option long_options[] = {
+		{ "parties",    1, NULL, 'n' },
+		{ "largeur",    1, NULL, 'x' },
+		{ "hauteur",    1, NULL, 'y' },
+		{ "alignement", 1, NULL, 'a' },
+		{ "strategies", 1, NULL, 's' },
+		{ "graine",     1, NULL, 'g' },
+		{ "json",       0, NULL, 'j' },
+		{ "archive",    1, NULL, 'r' },
+		{ "help",       0, NULL, 'h' },
+		{ NULL,         0, NULL,   0 }
+	};
+
+	static char strategies_defaut[] = "random,defense";
+
+	BenchmarkOptions options;
+	options.parties        = 100;
+	options.longueurs[0]   = MORPION_DEFAULT_LONGUEUR;
+	options.nb_longueurs   = 1;
+	options.largeurs[0]    = 0;
+	options.nb_largeurs    = 1;
+	options.alignements[0] = MORPION_DEFAULT_ALIGNEMENT;
+	options.nb_alignements = 1;
+	options.json           = 0;
+	options.archive        = NULL;
+	options.graine         = time(NULL);
+	strategie              = strategies_defaut;
+
+	do {
+		next_option = getopt_long(argc, argv, short_options, long_options, NULL);
+
+		switch (next_option) {
+		case 'n':
+			options.parties = atoi(optarg);
+			break;
+		case 'x':
+			options.nb_longueurs = benchmark_lire_liste(optarg, options.longueurs);
+			break;
+		case 'y':
+			options.nb_largeurs = benchmark_lire_liste(optarg, options.largeurs);
+			break;
+		case 'a':
+			options.nb_alignements = benchmark_lire_liste(optarg, options.alignements);
+			break;
+		case 's':
+			strategie = optarg;
+			break;
+		case 'g':
+			options.graine = strtoul(optarg, NULL, 10);
+			break;
+		case 'j':
+			options.json = 1;
+			break;
+		case 'r':
+			options.archive = archive_ouvrir(optarg);
+			if(options.archive == NULL) {
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'h':
+			benchmark_usage(stdout, 0);
+			break;
+		case '?':
+			benchmark_usage(stderr, 1);
+			break;
+		case -1:
+			break;
+		default:
+			abort();
+		}
+	} while (next_option != -1);
+
+	options.nb_strategies = 0;
+	for(strategie = strtok(strategie, ","); strategie != NULL; strategie = strtok(NULL, ",")) {
+		/* Les noms sont recopiés tels quels dans la sortie JSON. */
+		if(strspn(strategie, "abcdefghijklmnopqrstuvwxyz0123456789_") != strlen(strategie)) {
+			fprintf(stderr, "Nom de stratégie invalide : %s\n", strategie);
+			benchmark_usage(stderr, 1);
+		}
+		if(options.nb_strategies < BENCHMARK_MAX_JOUEURS) {
+			options.strategies[options.nb_strategies++] = strategie;
+		}
+	}
+
+	if(options.nb_strategies == 0 || options.nb_longueurs == 0
+			|| options.nb_largeurs == 0 || options.nb_alignements == 0) {
+		benchmark_usage(stderr, 1);
+	}
+
+	return options;
+}
+
+/**
+ * \fn static void echantillons_ajouter(Echantillons* echantillons, double valeur)
+ * \brief Ajoute une durée à un tableau d'échantillons.
+ */
+static void echantillons_ajouter(Echantillons* echantillons, double valeur) {
+	if(echantillons->nombre == echantillons->capacite) {
+		int capacite = echantillons->capacite == 0 ? 1024 : 2 * echantillons->capacite;
+		double* valeurs = (double*) realloc(echantillons->valeurs, sizeof(double) * capacite);
+		if(valeurs == NULL) {
+			perror("Impossible d'allouer les échantillons du benchmark.");
+			exit(EXIT_FAILURE);
+		}
+		echantillons->valeurs  = valeurs;
+		echantillons->capacite = capacite;
+	}
+	echantillons->valeurs[echantillons->nombre++] = valeur;
+}
+
+/**
+ * \fn static int comparer_doubles(const void* a, const void* b)
+ * \brief Compare deux durées pour qsort.
+ */
+static int comparer_doubles(const void* a, const void* b) {
+	double da = *(const double*) a;
+	double db = *(const double*) b;
+	return (da > db) - (da < db);
+}
+
+/**
+ * \fn static double echantillons_centile(Echantillons* echantillons, int centile)
+ * \brief Centile (rang le plus proche) d'échantillons déjà triés.
+ *
+ * \param echantillons Échantillons triés.
+ * \param centile Centile entre 1 et 100.
+ * \return La valeur du centile, 0 s'il n'y a pas d'échantillon.
+ */
+static double echantillons_centile(Echantillons* echantillons, int centile) {
+	int rang;
+
+	if(echantillons->nombre == 0) {
+		return 0;
+	}
+
+	rang = (echantillons->nombre * centile + 99) / 100 - 1;
+	if(rang < 0) {
+		rang = 0;
+	}
+	return echantillons->valeurs[rang];
+}
+
+/**
+ * \fn static void benchmark_configuration(BenchmarkOptions* options, BenchmarkResultat* resultat)
+ * \brief Joue les parties d'une configuration en mesurant chaque coup.
+ *
+ * La boucle de jeu est celle de ::morpion_play, chronométrée autour de
+ * Joueur::place. Le premier joueur change à chaque partie.
+ *
+ * \param options Options du benchmark.
+ * \param resultat Résultat avec la configuration remplie, à compléter.
+ */
+static void benchmark_configuration(BenchmarkOptions* options, BenchmarkResultat* resultat) {
 	Morpion morpion;
+	ListeJoueurs* dernier;
+	ListeJoueurs* premier;
+	int joueurs[BENCHMARK_MAX_JOUEURS];
+	int* cases = NULL;
+	int i, partie;
+	double debut;
+
+	morpion.grille  = NULL;
+	morpion.config  = resultat->config;
+	morpion.ui      = null_interface_create();
+	morpion.archive = options->archive;
+	if(morpion.archive != NULL) {
+		cases = (int*) malloc(sizeof(int) * resultat->config.longueur * resultat->config.largeur);
+		if(cases == NULL) {
+			perror("Impossible d'allouer les coups d'une partie.");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	for(i = 0; i < options->nb_strategies; i++) {
+		Joueur* joueur = creerJoueurParNom(options->strategies[i], i + 1);
+		if(joueur == NULL) {
+			fprintf(stderr, "Stratégie inconnue : %s\n", options->strategies[i]);
+			exit(EXIT_FAILURE);
+		}
+		if(i == 0) {
+			morpion.liste_joueurs = dernier = joueurs_creer_liste(joueur);
+		} else {
+			joueurs_place_suivant(dernier, joueur);
+			dernier = dernier->suivant;
+		}
+	}
+
+	premier = morpion.liste_joueurs;
+	debut = horloge_secondes();
+
+	for(partie = 0; partie < options->parties; partie++) {
+		ListeJoueurs* courant = premier;
+		int gagnant = 0;
+		int nb_coups = 0;
 
-	srand ( time(NULL) );
+		morpion_reset_grille(&morpion);
 
-	morpion.grille = NULL;
-	morpion.config = morpion_config_parse_options(argc, argv);
-	morpion.ui     = null_interface_create();
+		do {
+			int x, y;
+			Joueur* joueur_actuel = courant->joueur;
+			double avant = horloge_secondes();
 
-	morpion_reset_grille(&morpion);
+			joueur_actuel->place(joueur_actuel, morpion.grille, &x, &y);
+			echantillons_ajouter(&resultat->latences[joueur_actuel->id - 1], horloge_secondes() - avant);
+			resultat->coups += 1;
+			if(cases != NULL) {
+				cases[nb_coups++] = y * morpion.grille->longueur + x;
+			}
 
-	morpion.liste_joueurs = joueurs_creer_liste(creerJoueurRandom(1));
-	joueurs_place_suivant(morpion.liste_joueurs, creerJoueurDefense(2));
+			if(alignePion(morpion.grille, x, y, morpion.config.alignement)) {
+				gagnant = joueur_actuel->id;
+				break;
+			}
+			courant = courant->suivant;
+		} while(!estPleineGrille(morpion.grille));
 
-	morpion_play(&morpion);
+		if(gagnant == 0) {
+			resultat->nulles += 1;
+		} else {
+			resultat->victoires[gagnant - 1] += 1;
+		}
+		if(cases != NULL) {
+			for(i = 0, courant = premier; i < options->nb_strategies; i++, courant = courant->suivant) {
+				joueurs[i] = courant->joueur->id;
+			}
+			archive_ajouter(options->archive, morpion.config, joueurs, options->nb_strategies, gagnant, cases, nb_coups);
+		}
+		premier = premier->suivant;
+	}
+
+	resultat->duree   = horloge_secondes() - debut;
+	resultat->parties = options->parties;
 
 	morpion_free_resources(&morpion);
+	free(cases);
+
+	for(i = 0; i < options->nb_strategies; i++) {
+		Echantillons* latences = &resultat->latences[i];
+		qsort(latences->valeurs, latences->nombre, sizeof(double), comparer_doubles);
+	}
+}
+
+/**
+ * \fn static void benchmark_afficher(BenchmarkOptions* options, BenchmarkResultat* resultat, int premier)
+ * \brief Affiche le résultat d'une configuration, en texte ou en JSON.
+ *
+ * \param options Options du benchmark.
+ * \param resultat Résultat à afficher.
+ * \param premier Non nul pour la première configuration (séparateurs JSON).
+ */
+static void benchmark_afficher(BenchmarkOptions* options, BenchmarkResultat* resultat, int premier) {
+	double duree = resultat->duree > 0 ? resultat->duree : 1e-9;
+	int i;
+
+	if(options->json) {
+		printf("%s\n    {\"longueur\": %d, \"largeur\": %d, \"alignement\": %d, "
+				"\"parties\": %d, \"coups\": %ld, \"nulles\": %d, \"duree_s\": %.6f, "
+				"\"parties_par_s\": %.3f, \"coups_par_s\": %.3f, \"joueurs\": [",
+				premier ? "" : ",",
+				resultat->config.longueur, resultat->config.largeur, resultat->config.alignement,
+				resultat->parties, resultat->coups, resultat->nulles, resultat->duree,
+				resultat->parties / duree, resultat->coups / duree);
+	} else {
+		printf("%dx%d alignement %d : %d parties, %ld coups, %d nulles, %.3f s, "
+				"%.1f parties/s, %.1f coups/s\n",
+				resultat->config.longueur, resultat->config.largeur, resultat->config.alignement,
+				resultat->parties, resultat->coups, resultat->nulles, resultat->duree,
+				resultat->parties / duree, resultat->coups / duree);
+	}
+
+	for(i = 0; i < options->nb_strategies; i++) {
+		Echantillons* latences = &resultat->latences[i];
+		double p50 = echantillons_centile(latences, 50) * 1e6;
+		double p99 = echantillons_centile(latences, 99) * 1e6;
+		double max = echantillons_centile(latences, 100) * 1e6;
+
+		if(options->json) {
+			printf("%s\n      {\"id\": %d, \"strategie\": \"%s\", \"victoires\": %d, "
+					"\"appels\": %d, \"p50_us\": %.3f, \"p99_us\": %.3f, \"max_us\": %.3f}",
+					i == 0 ? "" : ",", i + 1, options->strategies[i], resultat->victoires[i],
+					latences->nombre, p50, p99, max);
+		} else {
+			printf("  joueur %d (%s) : %d victoires, %d appels, "
+					"p50 %.1f us, p99 %.1f us, max %.1f us\n",
+					i + 1, options->strategies[i], resultat->victoires[i],
+					latences->nombre, p50, p99, max);
+		}
+	}
+
+	if(options->json) {
+		printf("\n    ]}");
+	}
+}
+
+/**
+ * \fn int main(int argc, char* argv[])
+ * \brief Point d'entrée du benchmark.
+ *
+ * Parcourt toutes les combinaisons de longueur, largeur et alignement
+ * données en option.
+ *
+ * \param argc Nombre d'arguments de la commande.
+ * \param argv Tableau des arguments.
+ *
+ * \return Code de sortie du programme.
+ */
+int main(int argc, char* argv[]) {
+	BenchmarkOptions options = benchmark_parse_options(argc, argv);
+	int l, h, a, i;
+	int premier = 1;
+
+	srand(options.graine);
+
+	if(options.json) {
+		printf("{\"graine\": %u, \"configurations\": [", options.graine);
+	}
+
+	for(l = 0; l < options.nb_longueurs; l++) {
+		for(h = 0; h < options.nb_largeurs; h++) {
+			for(a = 0; a < options.nb_alignements; a++) {
+				BenchmarkResultat resultat;
+				memset(&resultat, 0, sizeof(resultat));
+
+				resultat.config.longueur   = options.longueurs[l];
+				resultat.config.largeur    = options.largeurs[h] > 0 ? options.largeurs[h] : options.longueurs[l];
+				resultat.config.alignement = options.alignements[a];
+
+				benchmark_configuration(&options, &resultat);
+				benchmark_afficher(&options, &resultat, premier);
+				premier = 0;
+
+				for(i = 0; i < options.nb_strategies; i++) {
+					free(resultat.latences[i].valeurs);
+				}
+			}
+		}
+	}
+
+	if(options.json) {
+		printf("\n]}\n");
+	}
+	if(options.archive != NULL) {
+		archive_fermer(options.archive);
+	}
 
 	return EXIT_SUCCESS;
 }
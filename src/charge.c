@@ -0,0 +1,598 @@
+/**
+ * \file charge.c
+ * \brief Générateur de charge : des milliers de robots jouent contre le serveur.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ *
+ * Les robots jouent par paires, chaque paire dans sa propre partie. Chaque
+ * robot a son propre socket de requêtes, comme un vrai client ; les robots
+ * d'un thread partagent un socket de notifications et un contexte ZeroMQ.
+ *
+ * La paire k joue sa manche m dans la partie premiere + k + m * paires : les
+ * identifiants sont connus d'avance, le thread s'abonne avant de rejoindre la
+ * partie et ne perd aucune notification.
+ *
+ * Chaque appel client_* est chronométré dans les Statistiques du thread, sous
+ * l'opcode de sa requête. Le serveur ouvre un descripteur par robot : penser
+ * à relever ulimit -n des deux côtés au-delà d'un millier de robots.
+ */
+#include <zmq.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "client.h"
+#include "horloge.h"
+#include "protocol.h"
+#include "statistiques.h"
+
+/** Robots au plus par thread, sous la limite de 512 sockets d'un contexte. */
+#define CHARGE_ROBOTS_PAR_THREAD 256
+/** Attente des notifications quand aucun robot ne peut jouer (us). */
+#define CHARGE_ATTENTE_US 1000
+/** Nombre maximal de stratégies données à -s. */
+#define CHARGE_MAX_STRATEGIES 16
+
+/**
+ * \struct ChargeOptions
+ * \brief Options de la ligne de commande.
+ */
+typedef struct ChargeOptions {
+	int joueurs;                                /*!< Nombre de robots, pair. */
+	int threads;                                /*!< Nombre de threads. */
+	int duree;                                  /*!< Durée de la mesure en secondes. */
+	char* strategies[CHARGE_MAX_STRATEGIES];    /*!< Stratégies, attribuées tour à tour. */
+	int nb_strategies;                          /*!< Nombre de stratégies. */
+	int premiere_partie;                        /*!< Identifiant de la première partie. */
+	unsigned long graine;                       /*!< Graine des générateurs aléatoires. */
+} ChargeOptions;
+
+/**
+ * \struct Robot
+ * \brief Un joueur simulé et sa vue de la partie.
+ */
+typedef struct Robot {
+	void* requester;      /*!< Socket de requêtes du robot. */
+	Joueur* joueur;       /*!< Stratégie, avec l'identifiant donné par le serveur. */
+	Grille* grille;       /*!< Copie locale de la grille. */
+	int partie;           /*!< Partie en cours, 0 sans partie. */
+	int version;          /*!< Version de la grille locale. */
+	int courant;          /*!< Joueur qui doit jouer, selon le robot. */
+	int coup_en_attente;  /*!< 1 tant que la notification de son coup n'est pas arrivée. */
+	int termine;          /*!< 1 quand la partie est finie pour le robot. */
+	double activite;      /*!< Date du dernier coup ou de la dernière notification. */
+} Robot;
+
+/**
+ * \struct ChargeTravail
+ * \brief Robots et compteurs d'un thread.
+ */
+typedef struct ChargeTravail {
+	pthread_t thread;             /*!< Thread qui fait jouer les robots. */
+	ChargeOptions* options;       /*!< Options de la commande. */
+	double fin;                   /*!< Date de fin de la mesure. */
+	int total_paires;             /*!< Nombre de paires de tous les threads. */
+	int premiere_paire;           /*!< Rang de la première paire du thread. */
+	int nb_paires;                /*!< Nombre de paires du thread. */
+	Robot* robots;                /*!< Robots du thread, deux par paire. */
+	int* manches;                 /*!< Manche en cours de chaque paire. */
+	void* context;                /*!< Contexte ZeroMQ du thread. */
+	void* subscriber;             /*!< Socket des notifications du thread. */
+	int alignement;               /*!< Pions à aligner, lu dans la configuration. */
+	Statistiques* statistiques;   /*!< Latences des requêtes du thread. */
+	long parties;                 /*!< Parties jouées jusqu'au bout. */
+	long coups;                   /*!< Coups acceptés. */
+	long echecs;                  /*!< JOIN refusés ou sans réponse. */
+	long relances;                /*!< Resynchronisations après un silence. */
+} ChargeTravail;
+
+/**
+ * \fn static void charge_usage(FILE* stream, int exit_code)
+ * \brief Affiche comment utiliser la commande.
+ *
+ * \param stream Le flux où écrire l'aide.
+ * \param exit_code Le code d'erreur à utiliser.
+ */
+static void charge_usage(FILE* stream, int exit_code) {
+	fprintf(stream, "Utilisation : charge options\n");
+	fprintf(stream,
+			" -j --joueurs n          Nombre de robots, deux par partie (1000).\n"
+			" -t --threads n          Nombre minimal de threads (nombre de coeurs).\n"
+			" -d --duree n            Durée de la mesure en secondes (10).\n"
+			" -s --strategies s,...   Stratégies des robots, tour à tour (random,defense).\n"
+	);
+	fprintf(stream,
+			" -p --premiere-partie n  Identifiant de la première partie (1000000).\n"
+			" -g --graine n           Graine des générateurs aléatoires (heure courante).\n"
+			" -h --help               Affiche une aide et quitte le programme.\n"
+	);
+	exit(exit_code);
+}
+
+/**
+ * \fn static ChargeOptions charge_parse_options(int argc, char* argv[])
+ * \brief Lit les options de la ligne de commande.
+ *
+ * \param argc Nombre d'arguments de la commande (du main).
+ * \param argv Tableau des chaines des arguments de la commande (du main).
+ * \return Les options.
+ */
+static ChargeOptions charge_parse_options(int argc, char* argv[]) {
+	int next_option;
+	char* strategie;
+	const char* const short_options = "j:t:d:s:p:g:h";
+
+	const struct option long_options[] = {
+		{ "joueurs",         1, NULL, 'j' },
+		{ "threads",         1, NULL, 't' },
+		{ "duree",           1, NULL, 'd' },
+		{ "strategies",      1, NULL, 's' },
+		{ "premiere-partie", 1, NULL, 'p' },
+		{ "graine",          1, NULL, 'g' },
+		{ "help",            0, NULL, 'h' },
+		{ NULL,              0, NULL,   0 }
+	};
+
+	static char strategies_defaut[] = "random,defense";
+
+	ChargeOptions options;
+	options.joueurs         = 1000;
+	options.threads         = sysconf(_SC_NPROCESSORS_ONLN);
+	options.duree           = 10;
+	options.premiere_partie = 1000000;
+	options.graine          = time(NULL);
+	strategie               = strategies_defaut;
+
+	do {
+		next_option = getopt_long(argc, argv, short_options, long_options, NULL);
+
+		switch (next_option) {
+		case 'j':
+			options.joueurs = atoi(optarg);
+			break;
+		case 't':
+			options.threads = atoi(optarg);
+			break;
+		case 'd':
+			options.duree = atoi(optarg);
+			break;
+		case 's':
+			strategie = optarg;
+			break;
+		case 'p':
+			options.premiere_partie = atoi(optarg);
+			break;
+		case 'g':
+			options.graine = strtoul(optarg, NULL, 10);
+			break;
+		case 'h':
+			charge_usage(stdout, 0);
+			break;
+		case '?':
+			charge_usage(stderr, 1);
+			break;
+		case -1:
+			break;
+		default:
+			abort();
+		}
+	} while (next_option != -1);
+
+	options.nb_strategies = 0;
+	for(strategie = strtok(strategie, ","); strategie != NULL; strategie = strtok(NULL, ",")) {
+		if(options.nb_strategies < CHARGE_MAX_STRATEGIES) {
+			options.strategies[options.nb_strategies++] = strategie;
+		}
+	}
+
+	options.joueurs -= options.joueurs % 2;
+	if(options.nb_strategies == 0 || options.joueurs < 2 || options.threads < 1
+			|| options.duree < 1 || options.premiere_partie < 1) {
+		charge_usage(stderr, 1);
+	}
+
+	return options;
+}
+
+/**
+ * \fn static void charge_mesurer(ChargeTravail* travail, char opcode, double debut)
+ * \brief Compte une requête commencée à la date debut.
+ */
+static void charge_mesurer(ChargeTravail* travail, char opcode, double debut) {
+	statistiques_requete(travail->statistiques, opcode, (uint64_t) ((horloge_secondes() - debut) * 1e9));
+}
+
+/**
+ * \fn static int charge_partie_finie(ChargeTravail* travail, Grille* grille)
+ * \brief Cherche un alignement gagnant ou une grille pleine.
+ *
+ * Le serveur ne déclare pas de gagnant : chaque robot arrête de jouer dès que
+ * sa grille le dit. Parcourt toute la grille, à n'appeler qu'après une
+ * resynchronisation.
+ */
+static int charge_partie_finie(ChargeTravail* travail, Grille* grille) {
+	int x, y;
+
+	if(estPleineGrille(grille)) {
+		return 1;
+	}
+	for(y = 0; y < grille->largeur; y++) {
+		for(x = 0; x < grille->longueur; x++) {
+			if(GRILLE_OCTET(grille, x, y) != 0 && alignePion(grille, x, y, travail->alignement)) {
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+/**
+ * \fn static void charge_relancer(ChargeTravail* travail, Robot* robot)
+ * \brief Redemande le tour et les coups manquants d'un robot.
+ */
+static void charge_relancer(ChargeTravail* travail, Robot* robot) {
+	double debut = horloge_secondes();
+	robot->courant = client_get_player_turn(robot->requester, robot->partie);
+	charge_mesurer(travail, PROTOCOL_GET_TURN, debut);
+
+	debut = horloge_secondes();
+	robot->version = client_sync_grille(robot->grille, robot->requester, robot->partie, robot->version);
+	charge_mesurer(travail, PROTOCOL_GET_COUPS, debut);
+
+	robot->coup_en_attente = 0;
+	robot->termine         = charge_partie_finie(travail, robot->grille);
+	robot->activite        = horloge_secondes();
+}
+
+/**
+ * \fn static void charge_commencer(ChargeTravail* travail, int paire)
+ * \brief Fait rejoindre aux deux robots d'une paire la partie de leur manche.
+ *
+ * Si un des robots ne peut pas rejoindre la partie, la paire est terminée
+ * tout de suite et réessaie à la manche suivante.
+ *
+ * \param travail Travail du thread.
+ * \param paire Rang de la paire dans le thread.
+ */
+static void charge_commencer(ChargeTravail* travail, int paire) {
+	Robot* robots = &travail->robots[2 * paire];
+	int partie = travail->options->premiere_partie + travail->premiere_paire + paire
+			+ travail->manches[paire] * travail->total_paires;
+	int i;
+
+	client_watch_game(travail->subscriber, partie);
+
+	for(i = 0; i < 2; i++) {
+		double debut = horloge_secondes();
+		int rejointe = partie;
+
+		robots[i].joueur->id = client_join(robots[i].requester, &rejointe);
+		charge_mesurer(travail, PROTOCOL_JOIN, debut);
+		robots[i].partie  = robots[i].joueur->id != 0 ? partie : 0;
+		robots[i].termine = 1;
+		if(robots[i].partie == 0) {
+			travail->echecs += 1;
+		}
+	}
+	if(robots[0].partie == 0 || robots[1].partie == 0) {
+		return;
+	}
+
+	for(i = 0; i < 2; i++) {
+		if(robots[i].grille == NULL) {
+			double debut = horloge_secondes();
+			MorpionConfig config = client_get_morpion_config(robots[i].requester, partie);
+
+			charge_mesurer(travail, PROTOCOL_GET_CONFIG, debut);
+			if(config.longueur < 1 || config.largeur < 1) {
+				return;
+			}
+			robots[i].grille    = initGrille(config.longueur, config.largeur);
+			travail->alignement = config.alignement;
+		} else {
+			grille_vider(robots[i].grille);
+		}
+		robots[i].version = 0;
+		charge_relancer(travail, &robots[i]);
+	}
+}
+
+/**
+ * \fn static void charge_terminer(ChargeTravail* travail, int paire, int finie)
+ * \brief Fait quitter leur partie aux deux robots d'une paire.
+ *
+ * \param travail Travail du thread.
+ * \param paire Rang de la paire dans le thread.
+ * \param finie 1 si la partie est allée jusqu'au bout.
+ */
+static void charge_terminer(ChargeTravail* travail, int paire, int finie) {
+	Robot* robots = &travail->robots[2 * paire];
+	int partie = travail->options->premiere_partie + travail->premiere_paire + paire
+			+ travail->manches[paire] * travail->total_paires;
+	int i;
+
+	for(i = 0; i < 2; i++) {
+		if(robots[i].partie != 0) {
+			double debut = horloge_secondes();
+			client_leave(robots[i].requester, robots[i].partie, robots[i].joueur->id);
+			charge_mesurer(travail, PROTOCOL_QUIT, debut);
+		}
+	}
+	if(finie && robots[0].partie != 0 && robots[1].partie != 0) {
+		travail->parties += 1;
+	}
+	robots[0].partie = robots[1].partie = 0;
+
+	client_unwatch_game(travail->subscriber, partie);
+	travail->manches[paire] += 1;
+}
+
+/**
+ * \fn static void charge_jouer(ChargeTravail* travail, Robot* robot)
+ * \brief Fait jouer son coup à un robot dont c'est le tour.
+ */
+static void charge_jouer(ChargeTravail* travail, Robot* robot) {
+	double debut;
+	int x, y, code;
+
+	robot->joueur->place(robot->joueur, robot->grille, &x, &y);
+
+	debut = horloge_secondes();
+	code  = client_play_turn(robot->requester, robot->partie, robot->joueur->id, x, y);
+	charge_mesurer(travail, PROTOCOL_PLAY_TURN, debut);
+	robot->activite = horloge_secondes();
+
+	if(code) {
+		/* Le tour suivant arrive avec la notification du coup. */
+		travail->coups        += 1;
+		robot->courant         = -1;
+		robot->coup_en_attente = 1;
+		robot->termine = alignePion(robot->grille, x, y, travail->alignement) || estPleineGrille(robot->grille);
+	} else {
+		statistiques_coup_refuse(travail->statistiques);
+		retirerPion(robot->grille, x, y);
+		charge_relancer(travail, robot);
+	}
+}
+
+/**
+ * \fn static void charge_notifier(ChargeTravail* travail, Robot* robot, int courant, int auteur, int x, int y, int version)
+ * \brief Applique une notification de sa partie à un robot.
+ *
+ * Même logique que le client interactif : les notifications antérieures à
+ * la grille locale ou au dernier coup du robot ne changent pas le tour.
+ */
+static void charge_notifier(ChargeTravail* travail, Robot* robot, int courant, int auteur, int x, int y, int version) {
+	if(robot->partie == 0 || robot->termine) {
+		return;
+	}
+	robot->activite = horloge_secondes();
+
+	if(auteur == robot->joueur->id) {
+		robot->coup_en_attente = 0;
+	}
+	if(version < robot->version) {
+		return;
+	}
+	if(!robot->coup_en_attente) {
+		robot->courant = courant;
+	}
+	if(auteur == 0 || version == robot->version) {
+		return;
+	}
+	if(version == robot->version + 1) {
+		/* Le coup du robot lui-même est déjà sur sa grille. */
+		placerPion(robot->grille, auteur, x, y);
+		robot->version = version;
+		robot->termine = alignePion(robot->grille, x, y, travail->alignement) || estPleineGrille(robot->grille);
+	} else {
+		double debut = horloge_secondes();
+		robot->version = client_sync_grille(robot->grille, robot->requester, robot->partie, robot->version);
+		charge_mesurer(travail, PROTOCOL_GET_COUPS, debut);
+		robot->termine = charge_partie_finie(travail, robot->grille);
+	}
+}
+
+/**
+ * \fn static void* charge_thread(void* argument)
+ * \brief Fait jouer les robots d'un thread jusqu'à la fin de la mesure.
+ *
+ * \param argument Le ChargeTravail du thread.
+ * \return NULL.
+ */
+static void* charge_thread(void* argument) {
+	ChargeTravail* travail = (ChargeTravail*) argument;
+	int partie, courant, auteur, x, y, version;
+	int paire, i;
+
+	for(paire = 0; paire < travail->nb_paires; paire++) {
+		charge_commencer(travail, paire);
+	}
+
+	while(horloge_secondes() < travail->fin) {
+		double maintenant = horloge_secondes();
+		long attente = CHARGE_ATTENTE_US;
+
+		for(paire = 0; paire < travail->nb_paires; paire++) {
+			Robot* robots = &travail->robots[2 * paire];
+
+			if(robots[0].termine && robots[1].termine) {
+				charge_terminer(travail, paire, 1);
+				charge_commencer(travail, paire);
+				attente = 0;
+				continue;
+			}
+			for(i = 0; i < 2; i++) {
+				Robot* robot = &robots[i];
+
+				if(robot->termine) {
+					continue;
+				}
+				if(robot->courant == robot->joueur->id && !robot->coup_en_attente) {
+					charge_jouer(travail, robot);
+					attente = 0;
+				} else if((maintenant - robot->activite) * 1e6 > CLIENT_RELANCE_US) {
+					/* Notification perdue : on redemande l'état. */
+					travail->relances += 1;
+					charge_relancer(travail, robot);
+				}
+			}
+		}
+
+		while(client_wait_notification(travail->subscriber, attente, &partie, &courant, &auteur, &x, &y, &version)) {
+			paire = (partie - travail->options->premiere_partie) % travail->total_paires - travail->premiere_paire;
+			/* Les notifications d'une manche déjà quittée sont ignorées. */
+			if(paire >= 0 && paire < travail->nb_paires && travail->robots[2 * paire].partie == partie) {
+				charge_notifier(travail, &travail->robots[2 * paire],     courant, auteur, x, y, version);
+				charge_notifier(travail, &travail->robots[2 * paire + 1], courant, auteur, x, y, version);
+			}
+			attente = 0;
+		}
+	}
+
+	for(paire = 0; paire < travail->nb_paires; paire++) {
+		charge_terminer(travail, paire, 0);
+	}
+
+	return NULL;
+}
+
+/**
+ * \fn static void charge_preparer(ChargeOptions* options, ChargeTravail* travail, int numero, int nb_threads)
+ * \brief Connecte les robots d'un thread.
+ *
+ * \param options Options de la commande.
+ * \param travail Travail du thread à préparer.
+ * \param numero Numéro du thread.
+ * \param nb_threads Nombre de threads.
+ */
+static void charge_preparer(ChargeOptions* options, ChargeTravail* travail, int numero, int nb_threads) {
+	int total = options->joueurs / 2;
+	int i;
+
+	memset(travail, 0, sizeof(ChargeTravail));
+	travail->options        = options;
+	travail->total_paires   = total;
+	travail->premiere_paire = numero * (total / nb_threads) + (numero < total % nb_threads ? numero : total % nb_threads);
+	travail->nb_paires      = total / nb_threads + (numero < total % nb_threads ? 1 : 0);
+	travail->robots         = (Robot*) calloc(2 * travail->nb_paires, sizeof(Robot));
+	travail->manches        = (int*) calloc(travail->nb_paires, sizeof(int));
+	travail->statistiques   = statistiques_creer();
+	if(travail->robots == NULL || travail->manches == NULL || travail->statistiques == NULL) {
+		perror("Impossible d'allouer les robots.");
+		exit(EXIT_FAILURE);
+	}
+
+	travail->context = client_initialize_context();
+	/* Abonné à la première partie puis désabonné : les paires choisissent. */
+	travail->subscriber = client_subscribe(travail->context, options->premiere_partie);
+	client_unwatch_game(travail->subscriber, options->premiere_partie);
+
+	for(i = 0; i < 2 * travail->nb_paires; i++) {
+		int rang = 2 * travail->premiere_paire + i;
+		Robot* robot = &travail->robots[i];
+
+		robot->joueur = creerJoueurParNom(options->strategies[rang % options->nb_strategies], 0);
+		if(robot->joueur == NULL) {
+			fprintf(stderr, "Stratégie inconnue : %s\n", options->strategies[rang % options->nb_strategies]);
+			exit(EXIT_FAILURE);
+		}
+		alea_init(&robot->joueur->alea, (uint64_t) options->graine * options->joueurs + rang);
+		robot->requester = client_connect(travail->context);
+	}
+}
+
+/**
+ * \fn static void charge_liberer(ChargeTravail* travail)
+ * \brief Ferme les sockets et libère les robots d'un thread.
+ */
+static void charge_liberer(ChargeTravail* travail) {
+	int i;
+
+	for(i = 0; i < 2 * travail->nb_paires; i++) {
+		zmq_close(travail->robots[i].requester);
+		libererJoueur(travail->robots[i].joueur);
+		if(travail->robots[i].grille != NULL) {
+			libererGrille(travail->robots[i].grille);
+		}
+	}
+	client_quit(travail->context, travail->subscriber);
+	statistiques_liberer(travail->statistiques);
+	free(travail->manches);
+	free(travail->robots);
+}
+
+/**
+ * \fn int main(int argc, char* argv[])
+ * \brief Point d'entrée du générateur de charge.
+ *
+ * \param argc Nombre d'arguments de la commande.
+ * \param argv Tableau des arguments.
+ *
+ * \return Code de sortie du programme.
+ */
+int main(int argc, char* argv[]) {
+	ChargeOptions options = charge_parse_options(argc, argv);
+	ChargeTravail* travaux;
+	ChargeTravail total;
+	Statistiques* statistiques;
+	int nb_threads = (options.joueurs + CHARGE_ROBOTS_PAR_THREAD - 1) / CHARGE_ROBOTS_PAR_THREAD;
+	double debut, duree;
+	int i;
+
+	if(nb_threads < options.threads) {
+		nb_threads = options.threads;
+	}
+	if(nb_threads > options.joueurs / 2) {
+		nb_threads = options.joueurs / 2;
+	}
+
+	travaux      = (ChargeTravail*) malloc(sizeof(ChargeTravail) * nb_threads);
+	statistiques = statistiques_creer();
+	if(travaux == NULL || statistiques == NULL) {
+		perror("Impossible d'allouer les travaux des threads.");
+		exit(EXIT_FAILURE);
+	}
+
+	for(i = 0; i < nb_threads; i++) {
+		charge_preparer(&options, &travaux[i], i, nb_threads);
+	}
+
+	debut = horloge_secondes();
+	for(i = 0; i < nb_threads; i++) {
+		travaux[i].fin = debut + options.duree;
+		if(pthread_create(&travaux[i].thread, NULL, charge_thread, &travaux[i]) != 0) {
+			perror("Impossible de créer un thread.");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	memset(&total, 0, sizeof(total));
+	for(i = 0; i < nb_threads; i++) {
+		pthread_join(travaux[i].thread, NULL);
+		total.parties  += travaux[i].parties;
+		total.coups    += travaux[i].coups;
+		total.echecs   += travaux[i].echecs;
+		total.relances += travaux[i].relances;
+		statistiques_fusionner(statistiques, travaux[i].statistiques);
+		charge_liberer(&travaux[i]);
+	}
+	duree = horloge_secondes() - debut;
+
+	printf("%d robots, %d threads, graine %lu : %.3f s, %ld parties, %ld coups, %.1f coups/s\n",
+			options.joueurs, nb_threads, options.graine, duree,
+			total.parties, total.coups, total.coups / duree);
+	printf("erreurs : %ld JOIN refusés, %llu coups refusés, %ld relances\n",
+			total.echecs, (unsigned long long) statistiques->coups_refuses, total.relances);
+	statistiques_ecrire_latences(statistiques, stdout);
+
+	statistiques_liberer(statistiques);
+	free(travaux);
+
+	return total.echecs == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
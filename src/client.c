@@ -14,7 +14,33 @@
 
 #include <protocol.h>
 
-#include "morpion.h"
+#include "client.h"
+#include "format.h"
+
+/**
+ * \fn static void client_envoyer(void* requester, char opcode, int partie, const void* donnees, size_t taille)
+ * \brief Envoie une requête : opcode, identifiant de partie puis données.
+ *
+ * \param requester Socket ZeroMQ adresser une requête au serveur.
+ * \param opcode Un des PROTOCOL_*.
+ * \param partie Identifiant de la partie.
+ * \param donnees Données qui suivent l'entête, peut être NULL.
+ * \param taille Nombre d'octets des données.
+ */
+static void client_envoyer(void* requester, char opcode, int partie, const void* donnees, size_t taille) {
+	zmq_msg_t request;
+	char* buffer;
+
+	zmq_msg_init_size(&request, 1 + sizeof(int) + taille);
+	buffer = (char*) zmq_msg_data(&request);
+	buffer[0] = opcode;
+	memcpy(buffer + 1, &partie, sizeof(int));
+	if(taille > 0) {
+		memcpy(buffer + 1 + sizeof(int), donnees, taille);
+	}
+	zmq_send(requester, &request, 0);
+	zmq_msg_close(&request);
+}
 
 /**
  * \fn void* client_initialize_context()
@@ -44,33 +70,119 @@ void* client_connect(void* context) {
 }
 
 /**
- * \fn MorpionConfig client_get_morpion_config(void* requester)
+ * \fn void* client_subscribe(void* context, int partie)
+ * \brief S'abonne aux notifications d'une partie.
+ *
+ * \param context Un contexte ZeroMQ déjà initialisé.
+ * \param partie Identifiant de la partie.
+ * \return Pointeur vers le socket ZeroMQ des notifications.
+ */
+void* client_subscribe(void* context, int partie) {
+	void *subscriber = zmq_socket(context, ZMQ_SUB);
+	zmq_connect(subscriber, "tcp://localhost:5556");
+	client_watch_game(subscriber, partie);
+	return subscriber;
+}
+
+/**
+ * \fn void client_watch_game(void* subscriber, int partie)
+ * \brief Ajoute une partie aux notifications reçues par un socket.
+ *
+ * Un même socket peut suivre plusieurs parties : l'identifiant de la partie
+ * est rendu avec chaque notification.
+ *
+ * \param subscriber Socket ZeroMQ des notifications.
+ * \param partie Identifiant de la partie.
+ */
+void client_watch_game(void* subscriber, int partie) {
+	zmq_setsockopt(subscriber, ZMQ_SUBSCRIBE, &partie, sizeof(partie));
+}
+
+/**
+ * \fn void client_unwatch_game(void* subscriber, int partie)
+ * \brief Retire une partie des notifications reçues par un socket.
+ *
+ * \param subscriber Socket ZeroMQ des notifications.
+ * \param partie Identifiant de la partie.
+ */
+void client_unwatch_game(void* subscriber, int partie) {
+	zmq_setsockopt(subscriber, ZMQ_UNSUBSCRIBE, &partie, sizeof(partie));
+}
+
+/**
+ * \fn int client_wait_notification(void* subscriber, long timeout, int* partie, int* joueur_courant, int* auteur, int* x, int* y, int* version)
+ * \brief Attend la prochaine notification des parties suivies.
+ *
+ * \param subscriber Socket ZeroMQ des notifications.
+ * \param timeout Attente maximale en microsecondes, -1 pour attendre sans fin.
+ * \param partie Pointeur pour sauver l'identifiant de la partie notifiée.
+ * \param joueur_courant Pointeur pour sauver le joueur qui doit jouer.
+ * \param auteur Pointeur pour sauver le joueur qui a placé un pion, 0 sinon.
+ * \param x Pointeur pour sauver la position x du pion.
+ * \param y Pointeur pour sauver la position y du pion.
+ * \param version Pointeur pour sauver la version de la grille après le changement.
+ * \return 1 si une notification a été reçue, 0 si le délai est écoulé.
+ */
+int client_wait_notification(void* subscriber, long timeout, int* partie, int* joueur_courant, int* auteur, int* x, int* y, int* version) {
+	zmq_pollitem_t items[1];
+	zmq_msg_t notification;
+	int champs[5];
+	int recue = 0;
+
+	items[0].socket  = subscriber;
+	items[0].fd      = 0;
+	items[0].events  = ZMQ_POLLIN;
+	items[0].revents = 0;
+	if(zmq_poll(items, 1, timeout) <= 0) {
+		return 0;
+	}
+
+	zmq_msg_init(&notification);
+	zmq_recv(subscriber, &notification, 0);
+	if(zmq_msg_size(&notification) >= sizeof(int) + 1 + sizeof(champs)
+			&& ((char*) zmq_msg_data(&notification))[sizeof(int)] == PROTOCOL_NOTIFICATION) {
+		memcpy(partie, zmq_msg_data(&notification), sizeof(int));
+		memcpy(champs, (char*) zmq_msg_data(&notification) + sizeof(int) + 1, sizeof(champs));
+		*joueur_courant = champs[0];
+		*auteur         = champs[1];
+		*x              = champs[2];
+		*y              = champs[3];
+		*version        = champs[4];
+		recue = 1;
+	}
+	zmq_msg_close(&notification);
+#ifdef DEBUG
+	printf("DEBUG: Notification, tour du joueur %d\n", *joueur_courant);
+#endif
+
+	return recue;
+}
+
+/**
+ * \fn MorpionConfig client_get_morpion_config(void* requester, int partie)
  * \brief Récupère la configuration du jeu sur le serveur.
  *
  *  Envoit au serveur une requête PROTOCOL_GET_CONFIG pour lui demander
- *  de retourner un MorpionConfig sérialisé.
+ *  de retourner un MorpionConfig au format de format.h.
  *
  * \param requester Socket ZeroMQ adresser une requête au serveur.
+ * \param partie Identifiant de la partie.
  * \return Structure MorpionConfig avec la configuration du serveur.
  */
-MorpionConfig client_get_morpion_config(void* requester) {
-	MorpionConfig config;
-	char buffer[1];
+MorpionConfig client_get_morpion_config(void* requester, int partie) {
+	MorpionConfig config = { 0, 0, 0 };
 
-	buffer[0] = (char) PROTOCOL_GET_CONFIG;
-	zmq_msg_t request;
-	zmq_msg_init_size(&request, 1);
-	memcpy(zmq_msg_data(&request), buffer,1);
 #ifdef DEBUG
 	printf("DEBUG: Sending GET CONFIG command…\n");
 #endif
-	zmq_send(requester, &request, 0);
-	zmq_msg_close(&request);
+	client_envoyer(requester, (char) PROTOCOL_GET_CONFIG, partie, NULL, 0);
 
 	zmq_msg_t reply;
 	zmq_msg_init(&reply);
 	zmq_recv(requester, &reply, 0);
-	config = morpion_config_deserialize( (char*) zmq_msg_data(&reply) ) ;
+	if(!format_lire_config(&config, (unsigned char*) zmq_msg_data(&reply), zmq_msg_size(&reply))) {
+		fprintf(stderr, "Configuration du serveur illisible.\n");
+	}
 #ifdef DEBUG
 	printf("DEBUG: MorpionConfig.longueur   = %d\n", config.longueur );
 	printf("DEBUG: MorpionConfig.largeur    = %d\n", config.largeur );
@@ -82,7 +194,7 @@ MorpionConfig client_get_morpion_config(void* requester) {
 }
 
 /**
- * \fn int client_join(void* requester)
+ * \fn int client_join(void* requester, int* partie)
  * \brief Rejoint une partie sur le serveur.
  *
  *  Envoit au serveur une requête PROTOCOL_JOIN pour lui demander
@@ -90,29 +202,29 @@ MorpionConfig client_get_morpion_config(void* requester) {
  *  de joueur.
  *
  * \param requester Socket ZeroMQ adresser une requête au serveur.
- * \return L'identifiant joueur du client.
+ * \param partie Identifiant de la partie à rejoindre, 0 pour la première
+ * partie qui attend des joueurs. Reçoit l'identifiant de la partie rejointe.
+ * \return L'identifiant joueur du client, 0 en cas d'échec.
  */
-int client_join(void* requester) {
+int client_join(void* requester, int* partie) {
 	char* login = getenv("USER");
-	char buffer[255];
-	int joueur_id;
-
-	buffer[0] = (char) PROTOCOL_JOIN;
-	strcpy(&buffer[1], login);
+	int joueur_id = 0;
 
-	zmq_msg_t request;
-	zmq_msg_init_size(&request, strlen(login) + 1);
-	memcpy(zmq_msg_data(&request), buffer, strlen(login) + 1);
+	if(login == NULL) {
+		login = "anonyme";
+	}
 #ifdef DEBUG
 	printf("DEBUG: Sending JOIN command…\n");
 #endif
-	zmq_send(requester, &request, 0);
-	zmq_msg_close(&request);
+	client_envoyer(requester, (char) PROTOCOL_JOIN, *partie, login, strlen(login) + 1);
 
 	zmq_msg_t reply;
 	zmq_msg_init(&reply);
 	zmq_recv(requester, &reply, 0);
-	joueur_id = * ( (int*)zmq_msg_data(&reply) );
+	if(zmq_msg_size(&reply) >= 2 * sizeof(int)) {
+		joueur_id = ( (int*)zmq_msg_data(&reply) )[0];
+		*partie   = ( (int*)zmq_msg_data(&reply) )[1];
+	}
 #ifdef DEBUG
 	printf("DEBUG: Joueur ID = %d\n", joueur_id );
 #endif
@@ -122,42 +234,32 @@ int client_join(void* requester) {
 }
 
 /**
- * \fn void client_update_morpion_grille(Grille* grille, void* requester)
+ * \fn void client_update_morpion_grille(Grille* grille, void* requester, int partie)
  * \brief Récupère une grille à jour du serveur.
  *
  *  Envoit au serveur une requête PROTOCOL_GET_GRILLE pour lui demander
  *  une version à jour de la grille de la partie en cours.
- *  La réponse du serveur est désérialisée dans le tableau du paramètre
- *  grille.
+ *  Les pions de la réponse du serveur sont placés sur le paramètre grille.
  *
  * \param grille Grille de morpion, ne doit pas être nulle.
  * \param requester Socket ZeroMQ adresser une requête au serveur.
+ * \param partie Identifiant de la partie.
  */
-void client_update_morpion_grille(Grille* grille, void* requester) {
-	char buffer[1];
-	char* serialized;
-
-	buffer[0] = (char) PROTOCOL_GET_GRILLE;
-	zmq_msg_t request;
-	zmq_msg_init_size(&request, 1);
-	memcpy(zmq_msg_data(&request), buffer,1);
+void client_update_morpion_grille(Grille* grille, void* requester, int partie) {
 #ifdef DEBUG
 	printf("DEBUG: Sending GET GRILLE command…\n");
 #endif
-	zmq_send(requester, &request, 0);
-	zmq_msg_close(&request);
+	client_envoyer(requester, (char) PROTOCOL_GET_GRILLE, partie, NULL, 0);
 
 	zmq_msg_t reply;
 	zmq_msg_init(&reply);
 	zmq_recv(requester, &reply, 0);
-	serialized = (char*) zmq_msg_data(&reply);
-	grille_update_deserialize(grille, serialized);
+	format_lire_grille(grille, (unsigned char*) zmq_msg_data(&reply), zmq_msg_size(&reply));
 	zmq_msg_close(&reply);
 #ifdef DEBUG
 	for(int j = 0; j < grille->largeur; j++) {
 		for(int i = 0; i < grille->longueur; i++) {
-			/*nt* ser = (int*) serialized;*/
-			printf("%d ", grille->tab[j][i]);
+			printf("%d ", GRILLE_OCTET(grille, i, j));
 		}
 		printf("\n");
 	}
@@ -165,7 +267,53 @@ void client_update_morpion_grille(Grille* grille, void* requester) {
 }
 
 /**
- * \fn int client_get_player_turn(void* requester)
+ * \fn int client_sync_grille(Grille* grille, void* requester, int partie, int version)
+ * \brief Met à jour une grille avec les coups joués depuis sa version.
+ *
+ *  Envoit au serveur une requête PROTOCOL_GET_COUPS. Les coups manquants sont
+ *  placés sur la grille ; si le serveur répond par la grille entière, elle
+ *  est lue par ::format_lire_grille.
+ *
+ * \param grille Grille de morpion, ne doit pas être nulle.
+ * \param requester Socket ZeroMQ adresser une requête au serveur.
+ * \param partie Identifiant de la partie.
+ * \param version Version de la grille, c'est à dire nombre de coups déjà placés.
+ * \return La version de la grille à jour, version si le serveur n'a pas répondu.
+ */
+int client_sync_grille(Grille* grille, void* requester, int partie, int version) {
+	size_t taille;
+	char* data;
+
+#ifdef DEBUG
+	printf("DEBUG: Sending GET COUPS command…\n");
+#endif
+	client_envoyer(requester, (char) PROTOCOL_GET_COUPS, partie, &version, sizeof(version));
+
+	zmq_msg_t reply;
+	zmq_msg_init(&reply);
+	zmq_recv(requester, &reply, 0);
+	data   = (char*) zmq_msg_data(&reply);
+	taille = zmq_msg_size(&reply);
+
+	if(taille >= sizeof(int) + 1 && data[sizeof(int)] == PROTOCOL_COUPS_DELTA) {
+		int* coups = (int*) (data + sizeof(int) + 1);
+		size_t i;
+
+		for(i = 0; i < (taille - sizeof(int) - 1) / (2 * sizeof(int)); i++) {
+			placerPion(grille, coups[2*i], coups[2*i + 1] % grille->longueur, coups[2*i + 1] / grille->longueur);
+		}
+		memcpy(&version, data, sizeof(int));
+	} else if(taille >= sizeof(int) + 1 && data[sizeof(int)] == PROTOCOL_COUPS_GRILLE
+			&& format_lire_grille(grille, (unsigned char*) data + sizeof(int) + 1, taille - sizeof(int) - 1)) {
+		memcpy(&version, data, sizeof(int));
+	}
+	zmq_msg_close(&reply);
+
+	return version;
+}
+
+/**
+ * \fn int client_get_player_turn(void* requester, int partie)
  * \brief Récupère l'identifiant du joueur courant.
  *
  *  Envoit au serveur une requête PROTOCOL_GET_TURN pour lui demander
@@ -174,27 +322,23 @@ void client_update_morpion_grille(Grille* grille, void* requester) {
  *  manque un joueur).
  *
  * \param requester Socket ZeroMQ adresser une requête au serveur.
+ * \param partie Identifiant de la partie.
  * \return L'identifiant du joueur qui doit jouer le prochain tour. 0 si personne.
  */
-int client_get_player_turn(void* requester) {
-	char buffer[1];
-	int joueur_id;
+int client_get_player_turn(void* requester, int partie) {
+	int joueur_id = 0;
 
-	buffer[0] = (char) PROTOCOL_GET_TURN;
-
-	zmq_msg_t request;
-	zmq_msg_init_size(&request, 1);
-	memcpy(zmq_msg_data(&request), buffer, 1);
 #ifdef DEBUG
 	printf("DEBUG: Sending GET_TURN command…\n");
 #endif
-	zmq_send(requester, &request, 0);
-	zmq_msg_close(&request);
+	client_envoyer(requester, (char) PROTOCOL_GET_TURN, partie, NULL, 0);
 
 	zmq_msg_t reply;
 	zmq_msg_init(&reply);
 	zmq_recv(requester, &reply, 0);
-	joueur_id = * ( (int*)zmq_msg_data(&reply) );
+	if(zmq_msg_size(&reply) >= sizeof(int)) {
+		joueur_id = * ( (int*)zmq_msg_data(&reply) );
+	}
 #ifdef DEBUG
 	printf("DEBUG: Current turn Joueur ID = %d\n", joueur_id );
 #endif
@@ -204,7 +348,7 @@ int client_get_player_turn(void* requester) {
 }
 
 /**
- * \fn int client_play_turn(void* requester, int joueur_id, int x, int y)
+ * \fn int client_play_turn(void* requester, int partie, int joueur_id, int x, int y)
  * \brief Envoit au serveur la position choisie pour jouer.
  *
  *  Envoit au serveur une requête PROTOCOL_PLAY_TURN avec la position x et y
@@ -212,34 +356,30 @@ int client_get_player_turn(void* requester) {
  *  La position peut être refusée par le serveur.
  *
  * \param requester Socket ZeroMQ adresser une requête au serveur.
+ * \param partie Identifiant de la partie.
  * \param joueur_id L'identifiant du joueur qui joue son tour.
  * \param x La position x de la case.
  * \param y La position y de la case.
  * \return L'entier 1 si la position est acceptée par le serveur, 0 sinon.
  */
-int client_play_turn(void* requester, int joueur_id, int x, int y) {
-	int code;
-	size_t message_len = 3*sizeof(int) + 1;
-	char buffer[message_len];
+int client_play_turn(void* requester, int partie, int joueur_id, int x, int y) {
+	int code = 0;
+	int buffer[3];
 
-	buffer[0] = (char) PROTOCOL_PLAY_TURN;
-	memcpy(&buffer[1 + 0*sizeof(int)], &joueur_id, sizeof(int));
-	memcpy(&buffer[1 + 1*sizeof(int)], &x, sizeof(int));
-	memcpy(&buffer[1 + 2*sizeof(int)], &y, sizeof(int));
-
-	zmq_msg_t request;
-	zmq_msg_init_size(&request, message_len);
-	memcpy(zmq_msg_data(&request), buffer, message_len);
+	buffer[0] = joueur_id;
+	buffer[1] = x;
+	buffer[2] = y;
 #ifdef DEBUG
 	printf("DEBUG: Sending PLAY_TURN command…\n");
 #endif
-	zmq_send(requester, &request, 0);
-	zmq_msg_close(&request);
+	client_envoyer(requester, (char) PROTOCOL_PLAY_TURN, partie, buffer, sizeof(buffer));
 
 	zmq_msg_t reply;
 	zmq_msg_init(&reply);
 	zmq_recv(requester, &reply, 0);
-	code = * ( (int*)zmq_msg_data(&reply) );
+	if(zmq_msg_size(&reply) >= sizeof(int)) {
+		code = * ( (int*)zmq_msg_data(&reply) );
+	}
 #ifdef DEBUG
 	printf("DEBUG: Code = %d\n", code );
 #endif
@@ -248,6 +388,37 @@ int client_play_turn(void* requester, int joueur_id, int x, int y) {
 	return code;
 }
 
+/**
+ * \fn int client_leave(void* requester, int partie, int joueur_id)
+ * \brief Quitte une partie.
+ *
+ *  Envoit au serveur une requête PROTOCOL_QUIT pour retirer le joueur de la
+ *  partie. La partie disparait du serveur quand tous ses joueurs l'ont quittée.
+ *
+ * \param requester Socket ZeroMQ adresser une requête au serveur.
+ * \param partie Identifiant de la partie.
+ * \param joueur_id L'identifiant du joueur qui quitte la partie.
+ * \return 1 si le serveur a retiré le joueur, 0 sinon.
+ */
+int client_leave(void* requester, int partie, int joueur_id) {
+	char code = 0;
+
+#ifdef DEBUG
+	printf("DEBUG: Sending QUIT command…\n");
+#endif
+	client_envoyer(requester, (char) PROTOCOL_QUIT, partie, &joueur_id, sizeof(joueur_id));
+
+	zmq_msg_t reply;
+	zmq_msg_init(&reply);
+	zmq_recv(requester, &reply, 0);
+	if(zmq_msg_size(&reply) >= 1) {
+		code = * (char*) zmq_msg_data(&reply);
+	}
+	zmq_msg_close(&reply);
+
+	return code;
+}
+
 /**
  * \fn void client_quit(void* context, void* requester)
  * \brief Libère les resources réseau.
@@ -260,64 +431,3 @@ void client_quit(void* context, void* requester) {
 	zmq_close(requester);
 	zmq_term(context);
 }
-
-/**
- * \fn int main(int argc, char* argv[])
- * \brief Point d'entrée pour le client du morpion en réseau.
- *
- * \param argc Nombre d'arguments de la commande.
- * \param argv Tableau des arguments.
- *
- * \return Code de sortie du programme.
- */
-int main(int argc, char* argv[]) {
-	void* context   = client_initialize_context();
-	void* requester = client_connect(context);
-
-	int joueur_id   = client_join(requester);
-
-	Morpion morpion;
-	Joueur* joueur = creerJoueurHumain(joueur_id);
-
-	morpion.grille = NULL;
-	morpion.config = client_get_morpion_config(requester);
-	morpion.ui     = text_interface_create();
-	morpion_reset_grille(&morpion);
-
-	client_update_morpion_grille(morpion.grille, requester);
-
-	afficherGrille(morpion.grille);
-
-	int last_joueur_seen = 0;
-	int joueur_actuel_id = 0;
-	do {
-		int x, y;
-
-		while((joueur_actuel_id = client_get_player_turn(requester)) != joueur_id) {
-			if(joueur_actuel_id != last_joueur_seen) {
-				printf("Tour de joueur %d :\n", joueur_actuel_id);
-				client_update_morpion_grille(morpion.grille, requester);
-				afficherGrille(morpion.grille);
-				last_joueur_seen = joueur_actuel_id;
-			}
-			if(joueur_actuel_id == 0) {
-				printf("Attente d'un autre joueur...");
-			}
-			sleep(1);
-		}
-		printf("Tour de joueur %d (c'est votre tour) :\n", joueur_actuel_id);
-		client_update_morpion_grille(morpion.grille, requester);
-		afficherGrille(morpion.grille);
-		joueur->place(joueur, morpion.grille, &x, &y);
-
-		client_play_turn(requester, joueur_id, x, y);
-		afficherGrille(morpion.grille);
-
-		sleep(1);
-	} while(!estPleineGrille(morpion.grille));
-
-
-	client_quit(context, requester);
-
-	return EXIT_SUCCESS;
-}
@@ -0,0 +1,124 @@
+/**
+ * \file client_main.c
+ * \brief Client interactif pour un morpion en réseau.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ */
+
+#include <zmq.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "client.h"
+
+/**
+ * \fn int main(int argc, char* argv[])
+ * \brief Point d'entrée pour le client du morpion en réseau.
+ *
+ * Le premier argument, s'il est présent, est l'identifiant de la partie à
+ * rejoindre. Sans argument, le client rejoint une partie qui attend des
+ * joueurs.
+ *
+ * \param argc Nombre d'arguments de la commande.
+ * \param argv Tableau des arguments.
+ *
+ * \return Code de sortie du programme.
+ */
+int main(int argc, char* argv[]) {
+	void* context   = client_initialize_context();
+	void* requester = client_connect(context);
+	void* subscriber;
+
+	int partie      = argc > 1 ? atoi(argv[1]) : 0;
+	int joueur_id   = client_join(requester, &partie);
+
+	if(joueur_id == 0) {
+		fprintf(stderr, "Impossible de rejoindre la partie %d.\n", partie);
+		client_quit(context, requester);
+		return EXIT_FAILURE;
+	}
+	printf("Joueur %d de la partie %d.\n", joueur_id, partie);
+
+	/* Abonné avant de lire l'état : aucun coup ne peut passer inaperçu. */
+	subscriber = client_subscribe(context, partie);
+
+	Morpion morpion;
+	Joueur* joueur = creerJoueurHumain(joueur_id);
+
+	morpion.grille  = NULL;
+	morpion.config  = client_get_morpion_config(requester, partie);
+	morpion.ui      = text_interface_create();
+	morpion.archive = NULL;
+	morpion_reset_grille(&morpion);
+
+	int version = client_sync_grille(morpion.grille, requester, partie, 0);
+
+	afficherGrille(morpion.grille);
+
+	int joueur_actuel_id = client_get_player_turn(requester, partie);
+	int coup_en_attente  = 0;
+	do {
+		int x, y, partie_notifiee, auteur, courant, version_notifiee;
+
+		while(joueur_actuel_id != joueur_id && !estPleineGrille(morpion.grille)) {
+			if(joueur_actuel_id == 0) {
+				printf("Attente d'un autre joueur...\n");
+			}
+			if(!client_wait_notification(subscriber, CLIENT_RELANCE_US,
+					&partie_notifiee, &courant, &auteur, &x, &y, &version_notifiee)) {
+				/* Notification perdue ou partie calme : on redemande l'état. */
+				joueur_actuel_id = client_get_player_turn(requester, partie);
+				coup_en_attente  = 0;
+				version = client_sync_grille(morpion.grille, requester, partie, version);
+				continue;
+			}
+			if(auteur == joueur_id) {
+				coup_en_attente = 0;
+			}
+			if(version_notifiee < version) {
+				continue;
+			}
+			/* Une notification antérieure à notre dernier coup donne un tour périmé. */
+			if(!coup_en_attente) {
+				joueur_actuel_id = courant;
+			}
+			if(auteur == 0 || version_notifiee == version) {
+				continue;
+			}
+			if(version_notifiee == version + 1) {
+				/* Notre propre coup est déjà sur la grille. */
+				if(placerPion(morpion.grille, auteur, x, y)) {
+					printf("Le joueur %d a placé en (%d, %d).\n", auteur, x, y);
+				}
+				version = version_notifiee;
+			} else {
+				version = client_sync_grille(morpion.grille, requester, partie, version);
+			}
+			afficherGrille(morpion.grille);
+		}
+		if(estPleineGrille(morpion.grille)) {
+			break;
+		}
+
+		printf("Tour de joueur %d (c'est votre tour) :\n", joueur_actuel_id);
+		joueur->place(joueur, morpion.grille, &x, &y);
+
+		if(client_play_turn(requester, partie, joueur_id, x, y)) {
+			/* Le tour suivant arrive avec la notification de notre coup. */
+			joueur_actuel_id = -1;
+			coup_en_attente  = 1;
+		} else {
+			retirerPion(morpion.grille, x, y);
+		}
+		afficherGrille(morpion.grille);
+	} while(!estPleineGrille(morpion.grille));
+
+	client_leave(requester, partie, joueur_id);
+	zmq_close(subscriber);
+	client_quit(context, requester);
+	libererJoueur(joueur);
+	libererGrille(morpion.grille);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,458 @@
+/**
+ * \file format.c
+ * \brief Format binaire versionné des grilles et configurations échangées.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "format.h"
+
+/**
+ * \fn void format_ecrire_u32(unsigned char* tampon, unsigned long valeur)
+ * \brief Écrit un entier de 32 bits en petit-boutiste.
+ *
+ * \param tampon Au moins 4 octets.
+ * \param valeur Entier à écrire.
+ */
+void format_ecrire_u32(unsigned char* tampon, unsigned long valeur) {
+	tampon[0] = (unsigned char) (valeur & 0xFF);
+	tampon[1] = (unsigned char) ((valeur >> 8) & 0xFF);
+	tampon[2] = (unsigned char) ((valeur >> 16) & 0xFF);
+	tampon[3] = (unsigned char) ((valeur >> 24) & 0xFF);
+}
+
+/**
+ * \fn void format_ecrire_u64(unsigned char* tampon, uint64_t valeur)
+ * \brief Écrit un entier de 64 bits en petit-boutiste.
+ *
+ * \param tampon Au moins 8 octets.
+ * \param valeur Entier à écrire.
+ */
+void format_ecrire_u64(unsigned char* tampon, uint64_t valeur) {
+	format_ecrire_u32(tampon, (unsigned long) (valeur & 0xFFFFFFFFUL));
+	format_ecrire_u32(tampon + 4, (unsigned long) (valeur >> 32));
+}
+
+/**
+ * \fn unsigned long format_lire_u32(const unsigned char* message)
+ * \brief Lit un entier de 32 bits en petit-boutiste.
+ *
+ * \param message Au moins 4 octets.
+ * \return L'entier lu.
+ */
+unsigned long format_lire_u32(const unsigned char* message) {
+	return (unsigned long) message[0]
+		| ((unsigned long) message[1] << 8)
+		| ((unsigned long) message[2] << 16)
+		| ((unsigned long) message[3] << 24);
+}
+
+/**
+ * \fn size_t format_taille_varint(unsigned long valeur)
+ * \brief Nombre d'octets d'un varint.
+ *
+ * \param valeur Entier à écrire.
+ * \return Le nombre d'octets, au plus ::FORMAT_VARINT_MAX.
+ */
+size_t format_taille_varint(unsigned long valeur) {
+	size_t taille = 1;
+	while(valeur >= 0x80) {
+		valeur >>= 7;
+		taille++;
+	}
+	return taille;
+}
+
+/**
+ * \fn size_t format_ecrire_varint(unsigned char* tampon, unsigned long valeur)
+ * \brief Écrit un varint et retourne son nombre d'octets.
+ *
+ * \param tampon Assez d'octets pour le varint.
+ * \param valeur Entier à écrire.
+ * \return Le nombre d'octets écrits.
+ */
+size_t format_ecrire_varint(unsigned char* tampon, unsigned long valeur) {
+	size_t taille = 0;
+	while(valeur >= 0x80) {
+		tampon[taille++] = (unsigned char) ((valeur & 0x7F) | 0x80);
+		valeur >>= 7;
+	}
+	tampon[taille++] = (unsigned char) valeur;
+	return taille;
+}
+
+/**
+ * \fn size_t format_lire_varint(const unsigned char* message, size_t taille, unsigned long* valeur)
+ * \brief Lit un varint.
+ *
+ * \param message Octets à lire.
+ * \param taille Nombre d'octets disponibles.
+ * \param valeur Pointeur pour sauver l'entier lu.
+ * \return Le nombre d'octets lus, 0 si le varint est tronqué ou trop long.
+ */
+size_t format_lire_varint(const unsigned char* message, size_t taille, unsigned long* valeur) {
+	size_t lus = 0;
+
+	*valeur = 0;
+	while(lus < taille && lus < FORMAT_VARINT_MAX) {
+		*valeur |= (unsigned long) (message[lus] & 0x7F) << (7 * lus);
+		if((message[lus++] & 0x80) == 0) {
+			return lus;
+		}
+	}
+	return 0;
+}
+
+/**
+ * \fn static void format_ecrire_entete(unsigned char* tampon, int type, int encodage, size_t suite)
+ * \brief Écrit l'entête d'un message.
+ */
+static void format_ecrire_entete(unsigned char* tampon, int type, int encodage, size_t suite) {
+	tampon[0] = FORMAT_MAGIQUE;
+	tampon[1] = FORMAT_VERSION;
+	tampon[2] = (unsigned char) type;
+	tampon[3] = (unsigned char) encodage;
+	format_ecrire_u32(tampon + 4, (unsigned long) suite);
+}
+
+/**
+ * \fn static int format_verifier_entete(const unsigned char* message, size_t taille, int type)
+ * \brief Vérifie l'entête d'un message et sa longueur.
+ */
+static int format_verifier_entete(const unsigned char* message, size_t taille, int type) {
+	return taille >= FORMAT_ENTETE
+		&& message[0] == FORMAT_MAGIQUE
+		&& message[1] == FORMAT_VERSION
+		&& message[2] == type
+		&& format_lire_u32(message + 4) == taille - FORMAT_ENTETE;
+}
+
+/**
+ * \fn size_t format_taille_max_grille(int longueur, int largeur)
+ * \brief Taille de tampon suffisante pour écrire une grille, quel que soit l'encodage.
+ *
+ * \param longueur Longueur de la grille.
+ * \param largeur Largeur de la grille.
+ * \return Le nombre d'octets.
+ */
+size_t format_taille_max_grille(int longueur, int largeur) {
+	return FORMAT_ENTETE + 4 + 4 + (size_t) longueur * largeur * 2 * FORMAT_VARINT_MAX;
+}
+
+/**
+ * \fn static int format_case(Grille* grille, int indice)
+ * \brief Identifiant du joueur sur la case d'indice y * longueur + x, 0 si elle est vide.
+ */
+static int format_case(Grille* grille, int indice) {
+	return GRILLE_OCTET(grille, indice % grille->longueur, indice / grille->longueur);
+}
+
+/**
+ * \fn long format_ecrire_grille(Grille* grille, int encodage, unsigned char* tampon, size_t taille)
+ * \brief Écrit une grille dans un tampon fourni, sans allocation.
+ *
+ * Avec ::FORMAT_CASES_AUTO, l'encodage le plus court parmi ceux qui peuvent
+ * représenter les identifiants présents est choisi.
+ *
+ * \param grille Grille à écrire.
+ * \param encodage Un des FORMAT_CASES_*.
+ * \param tampon Tampon où écrire le message.
+ * \param taille Taille du tampon.
+ * \return Le nombre d'octets écrits, -1 si le tampon est trop petit ou si
+ * l'encodage ne peut pas représenter les identifiants présents.
+ */
+long format_ecrire_grille(Grille* grille, int encodage, unsigned char* tampon, size_t taille) {
+	int cases = grille->longueur * grille->largeur;
+	int maximum = 0;
+	int precedent = -1;
+	size_t taille_creux = 4;
+	size_t suite, ecrits;
+	unsigned char* cellules;
+	int i;
+
+	for(i = 0; i < cases; i++) {
+		int joueur = format_case(grille, i);
+		if(joueur != 0) {
+			if(joueur > maximum) {
+				maximum = joueur;
+			}
+			taille_creux += format_taille_varint((unsigned long) (i - precedent - 1))
+				+ format_taille_varint((unsigned long) joueur);
+			precedent = i;
+		}
+	}
+
+	if(encodage == FORMAT_CASES_AUTO) {
+		encodage = FORMAT_CASES_CREUX;
+		if(maximum <= 3 && (size_t) (cases + 3) / 4 <= taille_creux) {
+			encodage = FORMAT_CASES_2BITS;
+		} else if(maximum <= 255 && (size_t) cases <= taille_creux) {
+			encodage = FORMAT_CASES_OCTET;
+		}
+	}
+
+	switch(encodage) {
+	case FORMAT_CASES_2BITS:
+		if(maximum > 3) {
+			return -1;
+		}
+		suite = 4 + (cases + 3) / 4;
+		break;
+	case FORMAT_CASES_OCTET:
+		if(maximum > 255) {
+			return -1;
+		}
+		suite = 4 + cases;
+		break;
+	case FORMAT_CASES_CREUX:
+		suite = 4 + taille_creux;
+		break;
+	default:
+		return -1;
+	}
+	if(FORMAT_ENTETE + suite > taille) {
+		return -1;
+	}
+
+	format_ecrire_entete(tampon, FORMAT_GRILLE, encodage, suite);
+	tampon[FORMAT_ENTETE + 0] = (unsigned char) (grille->longueur & 0xFF);
+	tampon[FORMAT_ENTETE + 1] = (unsigned char) ((grille->longueur >> 8) & 0xFF);
+	tampon[FORMAT_ENTETE + 2] = (unsigned char) (grille->largeur & 0xFF);
+	tampon[FORMAT_ENTETE + 3] = (unsigned char) ((grille->largeur >> 8) & 0xFF);
+	cellules = tampon + FORMAT_ENTETE + 4;
+
+	switch(encodage) {
+	case FORMAT_CASES_2BITS:
+		for(i = 0; i < (cases + 3) / 4; i++) {
+			cellules[i] = 0;
+		}
+		for(i = 0; i < cases; i++) {
+			cellules[i / 4] |= (unsigned char) (format_case(grille, i) << (2 * (i % 4)));
+		}
+		break;
+	case FORMAT_CASES_OCTET:
+		for(i = 0; i < cases; i++) {
+			cellules[i] = (unsigned char) format_case(grille, i);
+		}
+		break;
+	default:
+		format_ecrire_u32(cellules, (unsigned long) (cases - grille->libres));
+		ecrits = 4;
+		precedent = -1;
+		for(i = 0; i < cases; i++) {
+			int joueur = format_case(grille, i);
+			if(joueur != 0) {
+				ecrits += format_ecrire_varint(cellules + ecrits, (unsigned long) (i - precedent - 1));
+				ecrits += format_ecrire_varint(cellules + ecrits, (unsigned long) joueur);
+				precedent = i;
+			}
+		}
+		break;
+	}
+
+	return (long) (FORMAT_ENTETE + suite);
+}
+
+/**
+ * \struct LecteurCases
+ * \brief Parcours des pions d'une grille encodée, dans l'ordre des cases.
+ */
+typedef struct LecteurCases {
+	const unsigned char* cellules; /*!< Cases encodées. */
+	size_t taille;                 /*!< Octets des cases encodées. */
+	int encodage;                  /*!< Un des FORMAT_CASES_*. */
+	int cases;                     /*!< Nombre de cases de la grille. */
+	int indice;                    /*!< Dernière case lue. */
+	size_t position;               /*!< Prochain octet à lire (encodage creux). */
+	unsigned long restants;        /*!< Pions restant à lire (encodage creux). */
+} LecteurCases;
+
+/**
+ * \fn static int format_pion_suivant(LecteurCases* lecteur, int* indice, int* joueur)
+ * \brief Lit le prochain pion.
+ *
+ * Un identifiant de joueur au delà de ::GRILLE_JOUEUR_MAX, que ::placerPion
+ * refuserait, rend le message invalide.
+ *
+ * \return 1 si un pion a été lu, 0 à la fin des cases, -1 si le message est invalide.
+ */
+static int format_pion_suivant(LecteurCases* lecteur, int* indice, int* joueur) {
+	if(lecteur->encodage == FORMAT_CASES_CREUX) {
+		unsigned long ecart, valeur;
+		size_t lus;
+
+		if(lecteur->restants == 0) {
+			return 0;
+		}
+		lecteur->restants--;
+		lus = format_lire_varint(lecteur->cellules + lecteur->position, lecteur->taille - lecteur->position, &ecart);
+		if(lus == 0) {
+			return -1;
+		}
+		lecteur->position += lus;
+		lus = format_lire_varint(lecteur->cellules + lecteur->position, lecteur->taille - lecteur->position, &valeur);
+		if(lus == 0 || valeur == 0 || valeur > GRILLE_JOUEUR_MAX
+				|| ecart >= (unsigned long) (lecteur->cases - lecteur->indice - 1)) {
+			return -1;
+		}
+		lecteur->position += lus;
+		lecteur->indice += (int) ecart + 1;
+		*indice = lecteur->indice;
+		*joueur = (int) valeur;
+		return 1;
+	}
+
+	while(++lecteur->indice < lecteur->cases) {
+		int i = lecteur->indice;
+		int valeur = lecteur->encodage == FORMAT_CASES_2BITS
+			? (lecteur->cellules[i / 4] >> (2 * (i % 4))) & 3
+			: lecteur->cellules[i];
+		if(valeur > GRILLE_JOUEUR_MAX) {
+			return -1;
+		}
+		if(valeur != 0) {
+			*indice = i;
+			*joueur = valeur;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * \fn static int format_lecteur_initialiser(LecteurCases* lecteur, int encodage, const unsigned char* cellules, size_t taille, int cases)
+ * \brief Prépare la lecture des cases et vérifie leur taille.
+ */
+static int format_lecteur_initialiser(LecteurCases* lecteur, int encodage,
+		const unsigned char* cellules, size_t taille, int cases) {
+	lecteur->cellules = cellules;
+	lecteur->taille   = taille;
+	lecteur->encodage = encodage;
+	lecteur->cases    = cases;
+	lecteur->indice   = -1;
+	lecteur->position = 4;
+	lecteur->restants = 0;
+
+	switch(encodage) {
+	case FORMAT_CASES_2BITS:
+		return taille == (size_t) (cases + 3) / 4;
+	case FORMAT_CASES_OCTET:
+		return taille == (size_t) cases;
+	case FORMAT_CASES_CREUX:
+		if(taille < 4) {
+			return 0;
+		}
+		lecteur->restants = format_lire_u32(cellules);
+		return lecteur->restants <= (unsigned long) cases;
+	default:
+		return 0;
+	}
+}
+
+/**
+ * \fn int format_lire_grille(Grille* grille, const unsigned char* message, size_t taille)
+ * \brief Met à jour une grille à partir d'un message.
+ *
+ * Les nouveaux pions sont placés par ::placerPion. Si un pion a disparu ou
+ * changé de joueur, la grille est vidée puis entièrement replacée. La grille
+ * n'est pas modifiée si le message est invalide.
+ *
+ * \param grille Grille aux dimensions du message.
+ * \param message Message écrit par ::format_ecrire_grille.
+ * \param taille Taille du message.
+ * \return 1 si la grille a été lue, 0 si le message est invalide.
+ */
+int format_lire_grille(Grille* grille, const unsigned char* message, size_t taille) {
+	int cases = grille->longueur * grille->largeur;
+	int pions = cases - grille->libres;
+	int communs = 0;
+	int differente = 0;
+	LecteurCases lecteur;
+	int indice, joueur, lu;
+
+	if(!format_verifier_entete(message, taille, FORMAT_GRILLE) || taille < FORMAT_ENTETE + 4) {
+		return 0;
+	}
+	if((message[FORMAT_ENTETE] | (message[FORMAT_ENTETE + 1] << 8)) != grille->longueur
+			|| (message[FORMAT_ENTETE + 2] | (message[FORMAT_ENTETE + 3] << 8)) != grille->largeur) {
+		return 0;
+	}
+
+	/* Première lecture : valider et comparer avec la grille. */
+	if(!format_lecteur_initialiser(&lecteur, message[3], message + FORMAT_ENTETE + 4,
+				taille - FORMAT_ENTETE - 4, cases)) {
+		return 0;
+	}
+	while((lu = format_pion_suivant(&lecteur, &indice, &joueur)) > 0) {
+		int present = format_case(grille, indice);
+		if(present == joueur) {
+			communs++;
+		} else if(present != 0) {
+			differente = 1;
+		}
+	}
+	if(lu < 0) {
+		return 0;
+	}
+
+	if(differente || communs != pions) {
+		grille_vider(grille);
+	}
+
+	format_lecteur_initialiser(&lecteur, message[3], message + FORMAT_ENTETE + 4,
+			taille - FORMAT_ENTETE - 4, cases);
+	while(format_pion_suivant(&lecteur, &indice, &joueur) > 0) {
+		if(format_case(grille, indice) == 0) {
+			placerPion(grille, joueur, indice % grille->longueur, indice / grille->longueur);
+		}
+	}
+
+	return 1;
+}
+
+/**
+ * \fn long format_ecrire_config(MorpionConfig config, unsigned char* tampon, size_t taille)
+ * \brief Écrit une configuration dans un tampon fourni, sans allocation.
+ *
+ * \param config Configuration à écrire.
+ * \param tampon Tampon où écrire le message.
+ * \param taille Taille du tampon, au moins ::FORMAT_TAILLE_CONFIG.
+ * \return Le nombre d'octets écrits, -1 si le tampon est trop petit.
+ */
+long format_ecrire_config(MorpionConfig config, unsigned char* tampon, size_t taille) {
+	if(taille < FORMAT_TAILLE_CONFIG) {
+		return -1;
+	}
+
+	format_ecrire_entete(tampon, FORMAT_CONFIG, 0, FORMAT_TAILLE_CONFIG - FORMAT_ENTETE);
+	format_ecrire_u32(tampon + FORMAT_ENTETE + 0, (unsigned long) config.longueur);
+	format_ecrire_u32(tampon + FORMAT_ENTETE + 4, (unsigned long) config.largeur);
+	format_ecrire_u32(tampon + FORMAT_ENTETE + 8, (unsigned long) config.alignement);
+
+	return FORMAT_TAILLE_CONFIG;
+}
+
+/**
+ * \fn int format_lire_config(MorpionConfig* config, const unsigned char* message, size_t taille)
+ * \brief Lit une configuration.
+ *
+ * \param config Pointeur pour sauver la configuration lue.
+ * \param message Message écrit par ::format_ecrire_config.
+ * \param taille Taille du message.
+ * \return 1 si la configuration a été lue, 0 si le message est invalide.
+ */
+int format_lire_config(MorpionConfig* config, const unsigned char* message, size_t taille) {
+	if(taille != FORMAT_TAILLE_CONFIG || !format_verifier_entete(message, taille, FORMAT_CONFIG)) {
+		return 0;
+	}
+
+	config->longueur   = (int) format_lire_u32(message + FORMAT_ENTETE + 0);
+	config->largeur    = (int) format_lire_u32(message + FORMAT_ENTETE + 4);
+	config->alignement = (int) format_lire_u32(message + FORMAT_ENTETE + 8);
+
+	return 1;
+}
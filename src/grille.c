@@ -11,6 +11,269 @@
 #include <string.h>
 
 #include "grille.h"
+#include "alea.h"
+
+/** Composante x de chaque direction, dans l'ordre GRILLE_HORIZONTALE, ... */
+static const int direction_dx[GRILLE_NB_DIRECTIONS] = { 1, 0, 1,  1 };
+/** Composante y de chaque direction, dans l'ordre GRILLE_HORIZONTALE, ... */
+static const int direction_dy[GRILLE_NB_DIRECTIONS] = { 0, 1, 1, -1 };
+
+/**
+ * \fn static int grille_bits_plan(int longueur, int largeur, int direction)
+ * \brief Calcule le nombre de bits d'un plan de bitboard.
+ *
+ * \param longueur La longueur de la grille.
+ * \param largeur La largeur de la grille.
+ * \param direction Une des directions GRILLE_HORIZONTALE, ..., GRILLE_DIAGONALE2.
+ * \return Le nombre de bits du plan, bits de garde compris.
+ */
+static int grille_bits_plan(int longueur, int largeur, int direction) {
+	switch(direction) {
+	case GRILLE_HORIZONTALE:
+		return largeur * (longueur + 1);
+	case GRILLE_VERTICALE:
+		return longueur * (largeur + 1);
+	default:
+		return (longueur + largeur - 1) * (largeur + 1);
+	}
+}
+
+/**
+ * \fn static int grille_bit(Grille* grille, int direction, int x, int y)
+ * \brief Position du bit de la case (x,y) dans le plan d'une direction.
+ *
+ * Dans chaque plan, les cases qui se suivent dans la direction du plan ont
+ * des bits consécutifs :
+ * - horizontale : une ligne par valeur de y ;
+ * - verticale : une colonne par valeur de x ;
+ * - diagonale (1,1) : une diagonale par valeur de x-y, indexée par y ;
+ * - diagonale (1,-1) : une diagonale par valeur de x+y, indexée par y.
+ *
+ * \param grille La grille.
+ * \param direction La direction du plan.
+ * \param x La position x de la case.
+ * \param y La position y de la case.
+ * \return La position du bit relative au premier mot du plan.
+ */
+static int grille_bit(Grille* grille, int direction, int x, int y) {
+	switch(direction) {
+	case GRILLE_HORIZONTALE:
+		return y * (grille->longueur + 1) + x;
+	case GRILLE_VERTICALE:
+		return x * (grille->largeur + 1) + y;
+	case GRILLE_DIAGONALE1:
+		return (x - y + grille->largeur - 1) * (grille->largeur + 1) + y;
+	default:
+		return (x + y) * (grille->largeur + 1) + y;
+	}
+}
+
+/**
+ * \fn static uint64_t* grille_plans_joueur(Grille* grille, int J)
+ * \brief Retourne le bitboard d'un joueur, l'alloue si besoin.
+ *
+ * \param grille La grille.
+ * \param J Identifiant du joueur (> 0).
+ * \return Le bitboard du joueur.
+ */
+static uint64_t* grille_plans_joueur(Grille* grille, int J) {
+	if(J >= grille->nb_plans) {
+		int i;
+		int nb_plans = J + 1;
+		uint64_t** plans = (uint64_t**) realloc(grille->plans, sizeof(uint64_t*)*nb_plans);
+		if(plans == NULL) {
+			perror("Impossible d'allouer les bitboards de la grille.");
+			exit(EXIT_FAILURE);
+		}
+		for(i = grille->nb_plans; i < nb_plans; i++) {
+			plans[i] = NULL;
+		}
+		grille->plans    = plans;
+		grille->nb_plans = nb_plans;
+	}
+
+	if(grille->plans[J] == NULL) {
+		grille->plans[J] = (uint64_t*) calloc(grille->mots_plans, sizeof(uint64_t));
+		if(grille->plans[J] == NULL) {
+			perror("Impossible d'allouer le bitboard d'un joueur.");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	return grille->plans[J];
+}
+
+/**
+ * \fn uint64_t grille_cle_zobrist(int indice, int J)
+ * \brief Clé de Zobrist d'un pion du joueur J sur une case.
+ *
+ * La clé d'une position est le XOR des clés de ses pions. Les clés sont
+ * dérivées de l'indice de la case (y * longueur + x) et du joueur, sans
+ * table : elles sont les mêmes d'un processus à l'autre.
+ *
+ * \param indice Indice de la case.
+ * \param J Identifiant du joueur.
+ * \return La clé du pion.
+ */
+uint64_t grille_cle_zobrist(int indice, int J) {
+	return alea_melanger(((uint64_t) indice << 16) ^ (uint64_t) J);
+}
+
+/**
+ * \fn static void grille_basculer_bits(Grille* grille, int J, int x, int y)
+ * \brief Inverse les bits de la case (x,y) dans les 4 plans d'un joueur.
+ *
+ * La clé de Zobrist de la grille est mise à jour en même temps, ainsi que
+ * celles de ses images si les symétries sont suivies.
+ *
+ * \param grille La grille.
+ * \param J Identifiant du joueur.
+ * \param x La position x de la case.
+ * \param y La position y de la case.
+ */
+static void grille_basculer_bits(Grille* grille, int J, int x, int y) {
+	uint64_t* plans = grille_plans_joueur(grille, J);
+	int d, s;
+
+	for(d = 0; d < GRILLE_NB_DIRECTIONS; d++) {
+		int bit = grille->decalage[d] * 64 + grille_bit(grille, d, x, y);
+		plans[bit >> 6] ^= (uint64_t) 1 << (bit & 63);
+	}
+	grille->zobrist ^= grille_cle_zobrist(y * grille->longueur + x, J);
+
+	if(grille->nb_symetries > 0) {
+		const int* images = &grille->images[(y * grille->longueur + x) * GRILLE_SYMETRIES_MAX];
+		for(s = 1; s < grille->nb_symetries; s++) {
+			grille->zobrist_symetries[s] ^= grille_cle_zobrist(images[s], J);
+		}
+	}
+}
+
+/**
+ * \fn int grille_nb_symetries(int longueur, int largeur)
+ * \brief Nombre de symétries d'une grille.
+ *
+ * Les réflexions horizontale et verticale et la rotation d'un demi-tour
+ * gardent toute grille ; une grille carrée est aussi gardée par les
+ * rotations d'un quart de tour et les réflexions diagonales.
+ *
+ * \param longueur Longueur de la grille.
+ * \param largeur Largeur de la grille.
+ * \return 8 si la grille est carrée, 4 sinon.
+ */
+int grille_nb_symetries(int longueur, int largeur) {
+	return longueur == largeur ? 8 : 4;
+}
+
+/**
+ * \fn int grille_symetrie_case(int longueur, int largeur, int symetrie, int indice)
+ * \brief Image d'une case par une symétrie.
+ *
+ * Une symétrie est une combinaison des bits GRILLE_SYMETRIE_* : les miroirs
+ * sont appliqués d'abord, puis la transposition. 0 est l'identité. Les
+ * symétries avec ::GRILLE_SYMETRIE_TRANSPOSEE ne valent que pour une grille
+ * carrée.
+ *
+ * \param longueur Longueur de la grille.
+ * \param largeur Largeur de la grille.
+ * \param symetrie Symétrie, inférieure à ::grille_nb_symetries.
+ * \param indice Indice (y * longueur + x) de la case.
+ * \return L'indice de la case image.
+ */
+int grille_symetrie_case(int longueur, int largeur, int symetrie, int indice) {
+	int x = indice % longueur;
+	int y = indice / longueur;
+	int u = symetrie & GRILLE_SYMETRIE_MIROIR_X ? longueur - 1 - x : x;
+	int v = symetrie & GRILLE_SYMETRIE_MIROIR_Y ? largeur - 1 - y : y;
+
+	return symetrie & GRILLE_SYMETRIE_TRANSPOSEE ? u * longueur + v : v * longueur + u;
+}
+
+/**
+ * \fn int grille_symetrie_inverse(int symetrie)
+ * \brief Symétrie qui ramène chaque image à sa case.
+ *
+ * Les miroirs et les rotations d'un demi-tour sont leur propre inverse.
+ * Avec la transposition, les deux miroirs échangent leurs rôles.
+ *
+ * \param symetrie Symétrie à inverser.
+ * \return La symétrie inverse.
+ */
+int grille_symetrie_inverse(int symetrie) {
+	if(!(symetrie & GRILLE_SYMETRIE_TRANSPOSEE)) {
+		return symetrie;
+	}
+	return GRILLE_SYMETRIE_TRANSPOSEE
+			| (symetrie & GRILLE_SYMETRIE_MIROIR_X ? GRILLE_SYMETRIE_MIROIR_Y : 0)
+			| (symetrie & GRILLE_SYMETRIE_MIROIR_Y ? GRILLE_SYMETRIE_MIROIR_X : 0);
+}
+
+/**
+ * \fn void grille_suivre_symetries(Grille * grille)
+ * \brief Calcule les clés des images de la position et les tient ensuite à jour.
+ *
+ * Le premier appel parcourt toute la grille, les suivants ne font rien.
+ * Chaque coup coûte ensuite une clé de Zobrist par symétrie.
+ *
+ * \param grille La grille à suivre.
+ */
+void grille_suivre_symetries(Grille * grille) {
+	int cases = grille->longueur * grille->largeur;
+	int nombre = grille_nb_symetries(grille->longueur, grille->largeur);
+	int i, s;
+
+	if(grille->nb_symetries > 0) {
+		return;
+	}
+
+	grille->images = (int*) malloc(sizeof(int) * cases * GRILLE_SYMETRIES_MAX);
+	if(grille->images == NULL) {
+		perror("Impossible d'allouer les symétries de la grille.");
+		exit(EXIT_FAILURE);
+	}
+
+	memset(grille->zobrist_symetries, 0, sizeof(grille->zobrist_symetries));
+	for(i = 0; i < cases; i++) {
+		int J = GRILLE_OCTET(grille, i % grille->longueur, i / grille->longueur);
+		for(s = 0; s < nombre; s++) {
+			int image = grille_symetrie_case(grille->longueur, grille->largeur, s, i);
+			grille->images[i * GRILLE_SYMETRIES_MAX + s] = image;
+			if(s > 0 && J != 0) {
+				grille->zobrist_symetries[s] ^= grille_cle_zobrist(image, J);
+			}
+		}
+	}
+	grille->nb_symetries = nombre;
+}
+
+/**
+ * \fn uint64_t grille_cle_canonique(Grille * grille, int* symetrie)
+ * \brief Clé commune à une position et à toutes ses images.
+ *
+ * La clé canonique est la plus petite des clés des images de la position.
+ * Un coup c de la position correspond au coup
+ * grille_symetrie_case(longueur, largeur, *symetrie, c) de la forme
+ * canonique, et ::grille_symetrie_inverse fait le chemin inverse. Les
+ * symétries sont suivies à partir du premier appel.
+ *
+ * \param grille La position.
+ * \param symetrie Pointeur pour sauver la symétrie qui donne la forme canonique.
+ * \return La clé canonique.
+ */
+uint64_t grille_cle_canonique(Grille * grille, int* symetrie) {
+	uint64_t minimum = grille->zobrist;
+	int s;
+
+	grille_suivre_symetries(grille);
+	*symetrie = 0;
+	for(s = 1; s < grille->nb_symetries; s++) {
+		if(grille->zobrist_symetries[s] < minimum) {
+			minimum   = grille->zobrist_symetries[s];
+			*symetrie = s;
+		}
+	}
+	return minimum;
+}
 
 /**
  * \fn Grille* initGrille(int x, int y)
@@ -18,48 +281,80 @@
  *
  * Alloue une Grille de taille x*y et initialise le contenu de la grille
  * et les caractériques longueur, largeur et le compteur de cases libres.
+ * L'alignement vaut par défaut la plus petite dimension, le Morpion le
+ * remplace par celui de sa configuration.
  *
- * Le tableau est initialisé en 2 malloc pour être plus efficace en
- * sérialisation.
- * http://www.clubnix.fr/allocation_dynamique_2_dimensions_C
+ * La structure, tous les tableaux indexés par case et le plateau d'octets
+ * bordé sont pris dans un seul bloc : une grille ne coûte qu'un malloc et un
+ * free. Seuls les bitboards des joueurs et les suivis optionnels sont alloués
+ * à part, à la demande.
  *
  * \param x La longueur de la grille.
  * \param y La largeur de la grille.
  * \return Pointeur vers la Grille allouée, retourne NULL en cas d'échec.
  */
 Grille* initGrille(int x, int y) {
-	int *tabdata;
-	int i;
+	uint8_t* octets;
+	int i, d, mots;
+	/* Rangées alignées d'au moins une case de bordure. */
+	int pas = (x + 1 + GRILLE_ALIGNEMENT_RANGEE - 1) / GRILLE_ALIGNEMENT_RANGEE * GRILLE_ALIGNEMENT_RANGEE;
+	/* Une rangée de bordure de chaque côté, précédée de quoi lire la case (-1,-1). */
+	size_t taille_plateau = GRILLE_ALIGNEMENT_RANGEE + (size_t) pas * (y + 2);
 
-	Grille* grille = (Grille*) malloc(sizeof(Grille));
+	/* Grille, puis lignes, annulation, cases_libres, rang_libre et le plateau. */
+	size_t taille_entiers = sizeof(Grille) + sizeof(int)*x*y*(GRILLE_NB_DIRECTIONS + GRILLE_NB_DIRECTIONS*2 + 2);
+	Grille* grille = (Grille*) calloc(1, taille_entiers + GRILLE_ALIGNEMENT_RANGEE - 1 + taille_plateau);
 	if(grille == NULL) {
 		perror("Impossible d'allouer la grille.");
 		return NULL;
 	}
 
-	grille->tab = (int **)malloc(sizeof(int*)*y);
-	if(grille->tab == NULL) {
-		perror("Impossible d'allouer les colonnes de la grille");
-		free(grille);
-		return NULL;
-	}
+	grille->lignes       = (int*) (grille + 1);
+	grille->annulation   = grille->lignes + x*y*GRILLE_NB_DIRECTIONS;
+	grille->cases_libres = grille->annulation + x*y*GRILLE_NB_DIRECTIONS*2;
+	grille->rang_libre   = grille->cases_libres + x*y;
 
-	tabdata = (int *)malloc(sizeof(int)*x*y);
-	if(grille->tab == NULL) {
-		perror("Impossible d'allouer les lignes de la grille");
-		free(grille->tab);
-		free(grille);
-		return NULL;
-	}
+	octets = (uint8_t*) grille + taille_entiers;
+	octets += (GRILLE_ALIGNEMENT_RANGEE - (uintptr_t) octets % GRILLE_ALIGNEMENT_RANGEE) % GRILLE_ALIGNEMENT_RANGEE;
+	memset(octets, GRILLE_BORD, taille_plateau);
+	grille->pas     = pas;
+	grille->plateau = octets + GRILLE_ALIGNEMENT_RANGEE + pas;
 
 	for(i = 0 ; i < y ; i++){
-		grille->tab[i] = &tabdata[i*x];
+		memset(&GRILLE_OCTET(grille, 0, i), 0, x);
+	}
+	for(i = 0 ; i < x*y ; i++){
+		grille->cases_libres[i] = i;
+		grille->rang_libre[i]   = i;
 	}
-	memset(tabdata, 0, sizeof(int)*x*y);
 
 	grille->longueur = x;
 	grille->largeur  = y;
 	grille->libres   = x*y;
+	grille->premiere_libre = 0;
+	grille->alignement = x < y ? x : y;
+
+	/* Chaque plan est entouré d'un mot nul pour lire les fenêtres sans test. */
+	for(d = 0, mots = 0; d < GRILLE_NB_DIRECTIONS; d++) {
+		grille->decalage[d] = mots + 1;
+		mots += (grille_bits_plan(x, y, d) + 63) / 64 + 2;
+	}
+	grille->mots_plans = mots;
+	grille->plans      = NULL;
+	grille->nb_plans   = 0;
+	grille->zobrist    = 0;
+	grille->suivi_menaces = 0;
+	grille->menaces    = NULL;
+	grille->nb_menaces = 0;
+	grille->distance_candidats = 0;
+	grille->proximite     = NULL;
+	grille->candidats     = NULL;
+	grille->rang_candidat = NULL;
+	grille->nb_candidats  = 0;
+	grille->candidats_suspendus = 0;
+	grille->nb_symetries  = 0;
+	grille->images        = NULL;
+	memset(grille->zobrist_symetries, 0, sizeof(grille->zobrist_symetries));
 
 	return grille;
 }
@@ -71,38 +366,575 @@ Grille* initGrille(int x, int y) {
  * \param grille Pointeur vers la Grille à libérer.
  */
 void libererGrille(Grille * grille) {
-	free(grille->tab[0]);
-	free(grille->tab);
+	int i;
+	for(i = 0; i < grille->nb_plans; i++) {
+		free(grille->plans[i]);
+	}
+	free(grille->plans);
+	for(i = 0; i < grille->nb_menaces; i++) {
+		free(grille->menaces[i].valeur);
+		free(grille->menaces[i].cases);
+	}
+	free(grille->menaces);
+	free(grille->proximite);
+	free(grille->images);
 	free(grille);
 }
 
+/**
+ * \fn static int grille_proprietaire(Grille* grille, int x, int y)
+ * \brief Identifiant du joueur sur une case, 0 si vide, ::GRILLE_BORD juste hors de la grille.
+ *
+ * La case doit être dans la grille ou dans sa bordure, à une case du bord au plus.
+ */
+static int grille_proprietaire(Grille* grille, int x, int y) {
+	return GRILLE_OCTET(grille, x, y);
+}
+
+/**
+ * \fn static int grille_ligne_voisine(Grille* grille, int J, int x, int y, int d, int sens)
+ * \brief Longueur de la ligne du joueur J qui touche la case (x,y).
+ *
+ * Si la case voisine dans la direction d et le sens donné appartient au
+ * joueur J, elle est l'extrémité d'une ligne et sa longueur est exacte.
+ *
+ * \param grille La grille.
+ * \param J Identifiant du joueur.
+ * \param x La position x de la case.
+ * \param y La position y de la case.
+ * \param d La direction.
+ * \param sens 1 ou -1.
+ * \return La longueur de la ligne voisine, 0 s'il n'y en a pas.
+ */
+static int grille_ligne_voisine(Grille* grille, int J, int x, int y, int d, int sens) {
+	int vx = x + sens * direction_dx[d];
+	int vy = y + sens * direction_dy[d];
+
+	if(grille_proprietaire(grille, vx, vy) != J) {
+		return 0;
+	}
+	return grille->lignes[(vy * grille->longueur + vx) * GRILLE_NB_DIRECTIONS + d];
+}
+
+/**
+ * \fn static void grille_fixer_ligne(Grille* grille, int x, int y, int d, int distance, int longueur)
+ * \brief Écrit une longueur de ligne sur la case à une distance de (x,y).
+ */
+static void grille_fixer_ligne(Grille* grille, int x, int y, int d, int distance, int longueur) {
+	int cx = x + distance * direction_dx[d];
+	int cy = y + distance * direction_dy[d];
+
+	grille->lignes[(cy * grille->longueur + cx) * GRILLE_NB_DIRECTIONS + d] = longueur;
+}
+
+/**
+ * \fn static void grille_retirer_libre(Grille* grille, int indice)
+ * \brief Retire une case de l'ensemble des cases libres.
+ *
+ * La dernière case libre prend la place de la case retirée.
+ */
+static void grille_retirer_libre(Grille* grille, int indice) {
+	int rang    = grille->rang_libre[indice];
+	int derniere = grille->cases_libres[grille->libres - 1];
+
+	grille->cases_libres[rang] = derniere;
+	grille->rang_libre[derniere] = rang;
+	grille->libres -= 1;
+}
+
+/**
+ * \fn static void grille_ajouter_libre(Grille* grille, int indice)
+ * \brief Ajoute une case à la fin de l'ensemble des cases libres.
+ */
+static void grille_ajouter_libre(Grille* grille, int indice) {
+	grille->cases_libres[grille->libres] = indice;
+	grille->rang_libre[indice] = grille->libres;
+	grille->libres += 1;
+	if(indice < grille->premiere_libre) {
+		grille->premiere_libre = indice;
+	}
+}
+
+/**
+ * \fn int grille_premiere_case_libre(Grille * grille)
+ * \brief Cherche la première case libre, ligne par ligne.
+ *
+ * Les cases avant premiere_libre sont toutes occupées : la recherche repart
+ * de là et ne parcourt que les cases occupées depuis le dernier appel, ou
+ * depuis qu'une case plus haut a été libérée.
+ *
+ * \param grille Grille qui ne doit pas être pleine.
+ * \return L'indice (y * longueur + x) de la première case libre.
+ */
+int grille_premiere_case_libre(Grille * grille) {
+	int indice = grille->premiere_libre;
+
+	while(GRILLE_OCTET(grille, indice % grille->longueur, indice / grille->longueur) != 0) {
+		indice++;
+	}
+	grille->premiere_libre = indice;
+	return indice;
+}
+
+/**
+ * \fn int grille_case_libre_aleatoire(Grille * grille, Alea* alea)
+ * \brief Tire uniformément une case libre.
+ *
+ * \param grille Grille qui ne doit pas être pleine.
+ * \param alea Générateur aléatoire.
+ * \return L'indice (y * longueur + x) d'une case libre.
+ */
+int grille_case_libre_aleatoire(Grille * grille, Alea* alea) {
+	return grille->cases_libres[alea_borne(alea, grille->libres)];
+}
+
+/**
+ * \fn static MenacesJoueur* grille_menaces_joueur(Grille* grille, int J)
+ * \brief Retourne les menaces d'un joueur, les alloue si besoin.
+ *
+ * \param grille La grille.
+ * \param J Identifiant du joueur (> 0).
+ * \return Les menaces du joueur.
+ */
+static MenacesJoueur* grille_menaces_joueur(Grille* grille, int J) {
+	int cases = grille->longueur * grille->largeur;
+	MenacesJoueur* m;
+
+	if(J >= grille->nb_menaces) {
+		int nb_menaces = J + 1;
+		MenacesJoueur* menaces = (MenacesJoueur*) realloc(grille->menaces, sizeof(MenacesJoueur)*nb_menaces);
+		if(menaces == NULL) {
+			perror("Impossible d'allouer les menaces de la grille.");
+			exit(EXIT_FAILURE);
+		}
+		memset(&menaces[grille->nb_menaces], 0, sizeof(MenacesJoueur)*(nb_menaces - grille->nb_menaces));
+		grille->menaces    = menaces;
+		grille->nb_menaces = nb_menaces;
+	}
+
+	m = &grille->menaces[J];
+	if(m->valeur == NULL) {
+		m->valeur = (int*) calloc(cases, sizeof(int));
+		m->cases  = (int*) malloc(sizeof(int)*cases);
+		if(m->valeur == NULL || m->cases == NULL) {
+			perror("Impossible d'allouer les menaces d'un joueur.");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	return m;
+}
+
+/**
+ * \fn static int grille_rang_menace(MenacesJoueur* m, int indice)
+ * \brief Position où la case d'indice donné est ou serait rangée dans m->cases.
+ */
+static int grille_rang_menace(MenacesJoueur* m, int indice) {
+	int debut = 0;
+	int fin   = m->nb_cases;
+
+	while(debut < fin) {
+		int milieu = (debut + fin) / 2;
+		if(m->cases[milieu] < indice) {
+			debut = milieu + 1;
+		} else {
+			fin = milieu;
+		}
+	}
+	return debut;
+}
+
+/**
+ * \fn static void grille_evaluer_menace(Grille* grille, MenacesJoueur* m, int J, int indice)
+ * \brief Recalcule la menace du joueur J sur une case.
+ *
+ * La case entre dans l'ensemble des cases menacées si elle est vide et que
+ * J y ferait une ligne d'au moins 2 pions, elle en sort sinon.
+ */
+static void grille_evaluer_menace(Grille* grille, MenacesJoueur* m, int J, int indice) {
+	int x = indice % grille->longueur;
+	int y = indice / grille->longueur;
+	int valeur = 0;
+
+	if(GRILLE_OCTET(grille, x, y) == 0) {
+		valeur = grille_meilleure_ligne(grille, J, x, y);
+		if(valeur < 2) {
+			valeur = 0;
+		}
+	}
+
+	if(valeur != 0 && m->valeur[indice] == 0) {
+		int rang = grille_rang_menace(m, indice);
+		memmove(&m->cases[rang + 1], &m->cases[rang], sizeof(int) * (m->nb_cases - rang));
+		m->cases[rang] = indice;
+		m->nb_cases += 1;
+	} else if(valeur == 0 && m->valeur[indice] != 0) {
+		int rang = grille_rang_menace(m, indice);
+		m->nb_cases -= 1;
+		memmove(&m->cases[rang], &m->cases[rang + 1], sizeof(int) * (m->nb_cases - rang));
+	}
+	m->valeur[indice] = valeur;
+}
+
+/**
+ * \fn static void grille_menaces_case(Grille* grille, int J, int x, int y, const int* avant, const int* apres)
+ * \brief Met à jour les menaces après un changement sur la case (x,y).
+ *
+ * La case change pour tous les joueurs. Pour le joueur J qui y a placé ou
+ * retiré un pion, seules les cases au bout des lignes qui passent par (x,y)
+ * voient leur longueur changer.
+ *
+ * \param grille La grille, avec les lignes déjà à jour.
+ * \param J Joueur du pion placé ou retiré.
+ * \param x Position x de la case.
+ * \param y Position y de la case.
+ * \param avant Longueur des lignes de J avant (x,y), par direction.
+ * \param apres Longueur des lignes de J après (x,y), par direction.
+ */
+static void grille_menaces_case(Grille* grille, int J, int x, int y,
+		const int* avant, const int* apres) {
+	MenacesJoueur* m = grille_menaces_joueur(grille, J);
+	int indice = y * grille->longueur + x;
+	int q, d;
+
+	m->pions += GRILLE_OCTET(grille, x, y) != 0 ? 1 : -1;
+
+	for(q = 1; q < grille->nb_menaces; q++) {
+		if(grille->menaces[q].valeur != NULL) {
+			grille_evaluer_menace(grille, &grille->menaces[q], q, indice);
+		}
+	}
+
+	for(d = 0; d < GRILLE_NB_DIRECTIONS; d++) {
+		int bx = x - (avant[d] + 1) * direction_dx[d];
+		int by = y - (avant[d] + 1) * direction_dy[d];
+		int ax = x + (apres[d] + 1) * direction_dx[d];
+		int ay = y + (apres[d] + 1) * direction_dy[d];
+
+		if(GRILLE_OCTET(grille, bx, by) != GRILLE_BORD) {
+			grille_evaluer_menace(grille, m, J, by * grille->longueur + bx);
+		}
+		if(GRILLE_OCTET(grille, ax, ay) != GRILLE_BORD) {
+			grille_evaluer_menace(grille, m, J, ay * grille->longueur + ax);
+		}
+	}
+}
+
+/**
+ * \fn void grille_suivre_menaces(Grille * grille)
+ * \brief Calcule les menaces de chaque joueur et les tient ensuite à jour.
+ *
+ * Le premier appel parcourt toute la grille, les suivants ne font rien.
+ *
+ * \param grille La grille à suivre.
+ */
+void grille_suivre_menaces(Grille * grille) {
+	int cases = grille->longueur * grille->largeur;
+	int i, q;
+
+	if(grille->suivi_menaces) {
+		return;
+	}
+	grille->suivi_menaces = 1;
+
+	for(i = 0; i < cases; i++) {
+		int J = GRILLE_OCTET(grille, i % grille->longueur, i / grille->longueur);
+		if(J != 0) {
+			grille_menaces_joueur(grille, J)->pions += 1;
+		}
+	}
+	for(q = 1; q < grille->nb_menaces; q++) {
+		if(grille->menaces[q].valeur != NULL) {
+			for(i = 0; i < cases; i++) {
+				grille_evaluer_menace(grille, &grille->menaces[q], q, i);
+			}
+		}
+	}
+}
+
+/**
+ * \fn int grille_premier_pion(Grille * grille, int J)
+ * \brief Cherche le premier pion d'un joueur, ligne par ligne.
+ *
+ * Le plan horizontal du bitboard range les cases dans l'ordre des lignes :
+ * la recherche avance de 64 cases à la fois.
+ *
+ * \param grille La grille.
+ * \param J Identifiant du joueur.
+ * \return L'indice (y * longueur + x) du premier pion de J, -1 s'il n'en a pas.
+ */
+int grille_premier_pion(Grille * grille, int J) {
+	int mots = (grille_bits_plan(grille->longueur, grille->largeur, GRILLE_HORIZONTALE) + 63) / 64;
+	uint64_t* plan;
+	int i, bit;
+
+	if(J <= 0 || J >= grille->nb_plans || grille->plans[J] == NULL) {
+		return -1;
+	}
+
+	plan = grille->plans[J] + grille->decalage[GRILLE_HORIZONTALE];
+	for(i = 0; i < mots; i++) {
+		if(plan[i] != 0) {
+			bit = 0;
+			while((plan[i] >> bit & 1) == 0) {
+				bit++;
+			}
+			bit += i * 64;
+			return bit / (grille->longueur + 1) * grille->longueur
+				+ bit % (grille->longueur + 1);
+		}
+	}
+
+	return -1;
+}
+
+/**
+ * \fn static void grille_candidats_carre(Grille* grille, int x, int y, int sens)
+ * \brief Compte ou décompte un pion dans le carré qui l'entoure.
+ *
+ * Chaque case du carré entre dans les candidats si elle est vide et proche
+ * d'un pion, elle en sort sinon.
+ *
+ * \param grille La grille, dont la case (x,y) est déjà à jour.
+ * \param x Position x du pion.
+ * \param y Position y du pion.
+ * \param sens 1 si le pion a été placé, -1 s'il a été retiré.
+ */
+static void grille_candidats_carre(Grille* grille, int x, int y, int sens) {
+	int distance = grille->distance_candidats;
+	int i, j;
+
+	for(j = y - distance; j <= y + distance; j++) {
+		if(j < 0 || j >= grille->largeur) {
+			continue;
+		}
+		for(i = x - distance; i <= x + distance; i++) {
+			int indice = j * grille->longueur + i;
+			int candidat;
+
+			if(i < 0 || i >= grille->longueur) {
+				continue;
+			}
+			grille->proximite[indice] += sens;
+			candidat = GRILLE_OCTET(grille, i, j) == 0 && grille->proximite[indice] > 0;
+
+			if(candidat && grille->rang_candidat[indice] < 0) {
+				grille->candidats[grille->nb_candidats] = indice;
+				grille->rang_candidat[indice] = grille->nb_candidats;
+				grille->nb_candidats += 1;
+			} else if(!candidat && grille->rang_candidat[indice] >= 0) {
+				int dernier = grille->candidats[grille->nb_candidats - 1];
+				grille->candidats[grille->rang_candidat[indice]] = dernier;
+				grille->rang_candidat[dernier] = grille->rang_candidat[indice];
+				grille->rang_candidat[indice] = -1;
+				grille->nb_candidats -= 1;
+			}
+		}
+	}
+}
+
+/**
+ * \fn void grille_suivre_candidats(Grille * grille, int distance)
+ * \brief Calcule les coups candidats et les tient ensuite à jour.
+ *
+ * Les candidats sont recalculés si la distance change.
+ *
+ * \param grille La grille à suivre.
+ * \param distance Distance maximale d'un candidat à un pion (>= 1).
+ */
+void grille_suivre_candidats(Grille * grille, int distance) {
+	int cases = grille->longueur * grille->largeur;
+	int i;
+
+	if(grille->distance_candidats == distance) {
+		return;
+	}
+
+	if(grille->proximite == NULL) {
+		/* proximite, candidats et rang_candidat partagent un bloc. */
+		grille->proximite = (int*) malloc(sizeof(int)*cases*3);
+		if(grille->proximite == NULL) {
+			perror("Impossible d'allouer les coups candidats de la grille.");
+			exit(EXIT_FAILURE);
+		}
+		grille->candidats     = grille->proximite + cases;
+		grille->rang_candidat = grille->candidats + cases;
+	}
+
+	memset(grille->proximite, 0, sizeof(int)*cases);
+	for(i = 0; i < cases; i++) {
+		grille->rang_candidat[i] = -1;
+	}
+	grille->nb_candidats = 0;
+	grille->distance_candidats = distance;
+
+	for(i = 0; i < cases; i++) {
+		int x = i % grille->longueur;
+		int y = i / grille->longueur;
+		if(GRILLE_OCTET(grille, x, y) != 0) {
+			grille_candidats_carre(grille, x, y, 1);
+		}
+	}
+}
+
+/**
+ * \fn int grille_candidat(Grille * grille, int rang)
+ * \brief Parcourt les coups candidats.
+ *
+ * Les candidats sont dans un ordre quelconque, qui change quand on joue :
+ * ils doivent être recopiés avant d'être essayés.
+ *
+ *     for(rang = 0; (indice = grille_candidat(grille, rang)) >= 0; rang++)
+ *
+ * \param grille Grille dont les candidats sont suivis.
+ * \param rang Rang du candidat, à partir de 0.
+ * \return L'indice (y * longueur + x) du candidat, -1 après le dernier.
+ */
+int grille_candidat(Grille * grille, int rang) {
+	return rang < grille->nb_candidats ? grille->candidats[rang] : -1;
+}
+
+/**
+ * \fn Grille* copierGrille(Grille * source)
+ * \brief Alloue une copie indépendante d'une grille.
+ *
+ * Les pions de la source sont replacés un par un : la copie a les mêmes
+ * pions, lignes et clé, mais ses pions ne peuvent être retirés que dans
+ * l'ordre inverse des coups joués sur la copie. Les menaces, les
+ * candidats et les symétries ne sont pas suivis sur la copie.
+ *
+ * \param source Grille à copier.
+ * \return La copie, NULL en cas d'échec.
+ */
+Grille* copierGrille(Grille * source) {
+	Grille* copie = initGrille(source->longueur, source->largeur);
+	int i, j;
+
+	if(copie == NULL) {
+		return NULL;
+	}
+
+	copie->alignement = source->alignement;
+	for(j = 0; j < source->largeur; j++) {
+		for(i = 0; i < source->longueur; i++) {
+			if(GRILLE_OCTET(source, i, j) != 0) {
+				placerPion(copie, GRILLE_OCTET(source, i, j), i, j);
+			}
+		}
+	}
+
+	return copie;
+}
+
 /**
  * \fn int placerPion(Grille * grille, int J, int x, int y)
  * \brief Place un pion d'un jour à une position donnée de la grille.
  *
  * Essaye de placer un pion du joueur numero J sur la case (x,y) de la grille,
  * qui doit être vide. La fonction renvoie 1 si tout s'est bien passé, 0 si
- * la case est occupée ou n'existe pas.
+ * la case est occupée ou n'existe pas. Un identifiant hors de 1 à
+ * ::GRILLE_JOUEUR_MAX ne tient pas dans le plateau d'octets et est refusé.
  *
  * \param grille Grille qui doit recevoir le pion.
  * \param J Identifiant du joueur qui veut placer un pion.
  * \param x Position x de la case.de la grille.
  * \param y Position y de la case de la grille.
- * \return 1 si tout c'est bien passé, 0 si la case est occupée ou n'existe pas.
+ * \return 1 si tout c'est bien passé, 0 si la case est occupée ou n'existe pas,
+ * ou si l'identifiant est invalide.
  */
 int placerPion(Grille * grille, int J, int x, int y)
 {
 	char hors_jeu_longueur = 0 > x || x >= grille->longueur;
 	char hors_jeu_largeur  = 0 > y || y >= grille->largeur;
 	char hors_jeu = hors_jeu_longueur||hors_jeu_largeur;
-	char case_non_vide = hors_jeu ? 0 : grille->tab[y][x] != 0;
+	char case_non_vide = hors_jeu ? 0 : GRILLE_OCTET(grille, x, y) != 0;
+	int avants[GRILLE_NB_DIRECTIONS], apress[GRILLE_NB_DIRECTIONS];
+	int d;
 
-	if(hors_jeu_longueur||hors_jeu_largeur||case_non_vide) {
+	if(hors_jeu_longueur||hors_jeu_largeur||case_non_vide||J < 1||J > GRILLE_JOUEUR_MAX) {
 		return 0;
 	}
 
-	grille->tab[y][x] = J;
-	grille->libres -= 1;
+	/* Fusionne les lignes voisines et met à jour leurs extrémités. */
+	for(d = 0; d < GRILLE_NB_DIRECTIONS; d++) {
+		int avant   = grille_ligne_voisine(grille, J, x, y, d, -1);
+		int apres   = grille_ligne_voisine(grille, J, x, y, d,  1);
+		int total   = avant + apres + 1;
+		int* sauve  = &grille->annulation[((y * grille->longueur + x) * GRILLE_NB_DIRECTIONS + d) * 2];
+
+		sauve[0] = avants[d] = avant;
+		sauve[1] = apress[d] = apres;
+		grille_fixer_ligne(grille, x, y, d, -avant, total);
+		grille_fixer_ligne(grille, x, y, d,  apres, total);
+		grille_fixer_ligne(grille, x, y, d,      0, total);
+	}
+
+	GRILLE_OCTET(grille, x, y) = (uint8_t) J;
+	grille_retirer_libre(grille, y * grille->longueur + x);
+	grille_basculer_bits(grille, J, x, y);
+	if(grille->suivi_menaces) {
+		grille_menaces_case(grille, J, x, y, avants, apress);
+	}
+	if(grille->distance_candidats > 0 && !grille->candidats_suspendus) {
+		grille_candidats_carre(grille, x, y, 1);
+	}
+
+	return 1;
+}
+
+/**
+ * \fn int retirerPion(Grille * grille, int x, int y)
+ * \brief Retire le pion d'une case de la grille.
+ *
+ * Annule un ::placerPion, pour les stratégies qui essayent des coups.
+ * Les pions doivent être retirés dans l'ordre inverse où ils ont été placés
+ * pour que les longueurs de lignes restent exactes.
+ *
+ * \param grille Grille dont il faut retirer le pion.
+ * \param x Position x de la case.
+ * \param y Position y de la case.
+ * \return 1 si un pion a été retiré, 0 si la case est vide ou n'existe pas.
+ */
+int retirerPion(Grille * grille, int x, int y)
+{
+	char hors_jeu = 0 > x || x >= grille->longueur || 0 > y || y >= grille->largeur;
+	int avants[GRILLE_NB_DIRECTIONS], apress[GRILLE_NB_DIRECTIONS];
+	int J, d;
+
+	if(hors_jeu || GRILLE_OCTET(grille, x, y) == 0) {
+		return 0;
+	}
+	J = GRILLE_OCTET(grille, x, y);
+
+	/* Redécoupe la ligne en ses deux parties d'avant le pion. */
+	for(d = 0; d < GRILLE_NB_DIRECTIONS; d++) {
+		int* sauve = &grille->annulation[((y * grille->longueur + x) * GRILLE_NB_DIRECTIONS + d) * 2];
+		int avant  = sauve[0];
+		int apres  = sauve[1];
+
+		avants[d] = avant;
+		apress[d] = apres;
+
+		if(avant > 0) {
+			grille_fixer_ligne(grille, x, y, d, -avant, avant);
+			grille_fixer_ligne(grille, x, y, d,     -1, avant);
+		}
+		if(apres > 0) {
+			grille_fixer_ligne(grille, x, y, d, apres, apres);
+			grille_fixer_ligne(grille, x, y, d,     1, apres);
+		}
+		grille_fixer_ligne(grille, x, y, d, 0, 0);
+	}
+
+	grille_basculer_bits(grille, J, x, y);
+	GRILLE_OCTET(grille, x, y) = 0;
+	grille_ajouter_libre(grille, y * grille->longueur + x);
+	if(grille->suivi_menaces) {
+		grille_menaces_case(grille, J, x, y, avants, apress);
+	}
+	if(grille->distance_candidats > 0 && !grille->candidats_suspendus) {
+		grille_candidats_carre(grille, x, y, -1);
+	}
 
 	return 1;
 }
@@ -126,7 +958,9 @@ int estPleineGrille(Grille * grille) {
  * et un sens donné par dx et dy.
  * La position initiale est donnée par x et y et cherche jusqu'à n pions.
  *
- * Le paramètre n n'est utile que pour la performance.
+ * Le paramètre n n'est utile que pour la performance. La case de départ
+ * doit contenir un pion et dx, dy valoir -1, 0 ou 1 : la boucle lit le
+ * plateau d'octets sans vérifier les bornes et s'arrête sur la bordure.
  *
  * \param grille La grille où on compte les pions.
  * \param x La position x de la case de départ.
@@ -137,24 +971,15 @@ int estPleineGrille(Grille * grille) {
  * \return Le nombre de cases du même joueur dans la direction (forcément >= 1).
  */
 int compterDirection(Grille * grille, int x, int y, int n, int dx, int dy) {
-	int id_joueur_case_depart = grille->tab[y][x];
+	const uint8_t* octet = &GRILLE_OCTET(grille, x, y);
+	int pas = dy * grille->pas + dx;
+	uint8_t id_joueur_case_depart = *octet;
 	int count = 0;
 
-	char hors_jeu_longueur, hors_jeu_largeur;
-
-	while(
-			hors_jeu_longueur = (x < 0) || (x >= grille->longueur),
-			hors_jeu_largeur  = (y < 0) || (y >= grille->largeur),
-
-			!hors_jeu_longueur && !hors_jeu_largeur && (count <= n)
-			&&	(grille->tab[y][x] == id_joueur_case_depart)
-	) {
+	/* La bordure arrête la boucle comme un pion d'un autre joueur. */
+	while(count <= n && *octet == id_joueur_case_depart) {
 		count +=  1;
-		x     += dx;
-		y     += dy;
-#ifdef DEBUG
-		printf("DEBUG: Count (%d, %d) %d, \n", i, j, count);
-#endif
+		octet += pas;
 	}
 
 	return count;
@@ -189,6 +1014,46 @@ int compterLigne(Grille * grille, int x, int y, int n, int dx, int dy) {
 }
 
 
+/**
+ * \fn static int grille_fenetre_aligne(Grille* grille, uint64_t* plans, int direction, int x, int y, int n)
+ * \brief Vérifie un alignement de n bits autour d'une case dans un plan.
+ *
+ * Lit les 2n-1 bits centrés sur la case dans une fenêtre de 64 bits, puis
+ * réduit la fenêtre par décalages et ET successifs : après réduction, le bit i
+ * est à 1 si les n bits à partir de i sont à 1. Toute séquence de n bits de la
+ * fenêtre contient la case centrale.
+ *
+ * \param grille La grille.
+ * \param plans Le bitboard du joueur.
+ * \param direction La direction du plan.
+ * \param x La position x de la case centrale.
+ * \param y La position y de la case centrale.
+ * \param n Le nombre de pions à aligner (<= GRILLE_ALIGNEMENT_MAX_BITBOARD).
+ * \return 1 s'il y a un alignement de n pions, 0 sinon.
+ */
+static int grille_fenetre_aligne(Grille* grille, uint64_t* plans, int direction, int x, int y, int n) {
+	int debut = grille->decalage[direction] * 64 + grille_bit(grille, direction, x, y) - (n - 1);
+	int largeur_fenetre = 2 * n - 1;
+	int decalage = debut & 63;
+	int longueur = 1;
+	uint64_t fenetre = plans[debut >> 6] >> decalage;
+
+	if(decalage != 0) {
+		fenetre |= plans[(debut >> 6) + 1] << (64 - decalage);
+	}
+	if(largeur_fenetre < 64) {
+		fenetre &= ((uint64_t) 1 << largeur_fenetre) - 1;
+	}
+
+	while(longueur < n && fenetre != 0) {
+		int pas = longueur < n - longueur ? longueur : n - longueur;
+		fenetre &= fenetre >> pas;
+		longueur += pas;
+	}
+
+	return fenetre != 0;
+}
+
 /**
  * \fn int alignePion(Grille * grille, int x, int y, int n)
  * \brief Vérifie s'il y a un alignement de n pions à une position donnée
@@ -198,7 +1063,11 @@ int compterLigne(Grille * grille, int x, int y, int n, int dx, int dy) {
  * S'il n'y a pas de pion sur la case, 0 est retourné.
  *
  * L'alignement va être vérifié selon la ligne horizontale, verticale et sur
- * les deux diagonales.
+ * les deux diagonales. La longueur de ligne de la case est lue directement
+ * si elle suffit ou si la case est une extrémité de la ligne (cas du dernier
+ * pion posé). Sinon la case est à l'intérieur d'une ligne et l'alignement
+ * est vérifié dans le bitboard du joueur, ou case par case pour un n
+ * supérieur à GRILLE_ALIGNEMENT_MAX_BITBOARD.
  *
  * \param grille La grille à regarder.
  * \param x La position x du pion à partir duquel on cherche un alignement.
@@ -208,27 +1077,81 @@ int compterLigne(Grille * grille, int x, int y, int n, int dx, int dy) {
  * \return 1 s'il y a un alignement de n pions, 0 sinon.
  */
 int alignePion(Grille * grille, int x, int y, int n) {
-	int comptage_ligne_horizontale = compterLigne(grille, x, y, n, 1, 0);
-	int comptage_ligne_verticale   = compterLigne(grille, x, y, n, 0, 1);
-	int comptage_ligne_diagonale1  = compterLigne(grille, x, y, n, 1, 1);
-	int comptage_ligne_diagonale2  = compterLigne(grille, x, y, n, 1, -1);
+	int J = GRILLE_OCTET(grille, x, y);
+	int* lignes = &grille->lignes[(y * grille->longueur + x) * GRILLE_NB_DIRECTIONS];
+	int d;
 
-	char alignement_gagnant_present =
-			   comptage_ligne_horizontale >= n
-			|| comptage_ligne_verticale   >= n
-			|| comptage_ligne_diagonale1  >= n
-			|| comptage_ligne_diagonale2  >= n;
+	if(J == 0) {
+		return 0;
+	}
 
-	char alignement_vide = grille->tab[y][x] == 0;
+	for(d = 0; d < GRILLE_NB_DIRECTIONS; d++) {
+		int dx = direction_dx[d];
+		int dy = direction_dy[d];
+		char extremite =
+			   grille_proprietaire(grille, x - dx, y - dy) != J
+			|| grille_proprietaire(grille, x + dx, y + dy) != J;
+
+		if(lignes[d] >= n) {
+			return 1;
+		}
+		if(extremite) {
+			continue;
+		}
+		if(n > GRILLE_ALIGNEMENT_MAX_BITBOARD) {
+			if(compterLigne(grille, x, y, n, dx, dy) >= n) {
+				return 1;
+			}
+		} else if(grille_fenetre_aligne(grille, grille_plans_joueur(grille, J), d, x, y, n)) {
+			return 1;
+		}
+	}
 
-#ifdef DEBUG
-	printf("H  : %d\n", comptage_ligne_horizontale);
-	printf("V  : %d\n", comptage_ligne_verticale);
-	printf("D1 : %d\n", comptage_ligne_diagonale1);
-	printf("D2 : %d\n", comptage_ligne_diagonale2);
-#endif
+	return 0;
+}
 
-	return alignement_gagnant_present && !alignement_vide;
+/**
+ * \fn int grille_ligne_potentielle(Grille * grille, int J, int x, int y, int direction)
+ * \brief Longueur de la ligne qu'aurait le joueur J en jouant sur (x,y).
+ *
+ * La case doit être vide. Le calcul est en temps constant grâce aux longueurs
+ * stockées aux extrémités des lignes voisines.
+ *
+ * \param grille La grille à regarder.
+ * \param J Identifiant du joueur.
+ * \param x La position x de la case vide.
+ * \param y La position y de la case vide.
+ * \param direction Une des directions GRILLE_HORIZONTALE, ..., GRILLE_DIAGONALE2.
+ * \return La longueur de la ligne qui passerait par la case (>= 1).
+ */
+int grille_ligne_potentielle(Grille * grille, int J, int x, int y, int direction) {
+	return grille_ligne_voisine(grille, J, x, y, direction, -1)
+		+ grille_ligne_voisine(grille, J, x, y, direction,  1)
+		+ 1;
+}
+
+/**
+ * \fn int grille_meilleure_ligne(Grille * grille, int J, int x, int y)
+ * \brief Plus longue ligne qu'aurait le joueur J en jouant sur (x,y).
+ *
+ * \param grille La grille à regarder.
+ * \param J Identifiant du joueur.
+ * \param x La position x de la case vide.
+ * \param y La position y de la case vide.
+ * \return La plus longue des lignes qui passeraient par la case (>= 1).
+ */
+int grille_meilleure_ligne(Grille * grille, int J, int x, int y) {
+	int d;
+	int meilleure = 0;
+
+	for(d = 0; d < GRILLE_NB_DIRECTIONS; d++) {
+		int longueur = grille_ligne_potentielle(grille, J, x, y, d);
+		if(longueur > meilleure) {
+			meilleure = longueur;
+		}
+	}
+
+	return meilleure;
 }
 
 /**
@@ -267,7 +1190,7 @@ void afficherGrille(Grille * grille) {
 	for(j = 0; j < grille->largeur; j++) {
 		printf("|");
 		for(i = 0; i < grille->longueur; i++) {
-			switch(grille->tab[j][i]) {
+			switch(GRILLE_OCTET(grille, i, j)) {
 			case 0:
 				printf(" ");
 				break;
@@ -278,7 +1201,7 @@ void afficherGrille(Grille * grille) {
 				printf("O");
 				break;
 			default:
-				printf("%c", 'a' + grille->tab[j][i] - 3);
+				printf("%c", 'a' + GRILLE_OCTET(grille, i, j) - 3);
 				break;
 			}
 		}
@@ -288,39 +1211,46 @@ void afficherGrille(Grille * grille) {
 }
 
 /**
- * \fn char* grille_serialize(Grille* grille)
- * \brief Sérialise le contenu du tableau de la grille.
+ * \fn void grille_vider(Grille* grille)
+ * \brief Retire tous les pions de la grille sans la réallouer.
  *
- * Cette fonction doit être utilisé pour récupérer une chaine d'octets à envoyer
- * sur le réseau.
+ * Les menaces, les candidats et les symétries restent suivis s'ils l'étaient.
  *
- * \param grille La grille à sérialiser.
- *
- * \warning Il ne faut PAS free cette serialisation !!
- * \warning Cette sérialisation est dépendante de l'endianness de l'architecture.
- *
- * \todo Faire une implémentation indépendante de l'endianness.
- *
- * \return Pointeur vers la suite d'octets sérialisés.
+ * \param grille Grille à vider.
  */
-char* grille_serialize(Grille* grille) {
-	return (char*) grille->tab[0];
-}
+void grille_vider(Grille* grille) {
+	int cases = grille->longueur * grille->largeur;
+	int i;
 
-/**
- * \fn void grille_update_deserialize(Grille* grille, char* serialized)
- * \brief Met à jour une grille à partir d'une serialisation de données de grille.
- *
- * \param grille Grille à mettre à jour.
- * \param serialized Chaine d'octets serialisée par grille_serialize.
- */
-void grille_update_deserialize(Grille* grille, char* serialized) {
-	int* element = (int*) serialized;
-	int i, j;
-	for (j = 0; j < grille->largeur; j++) {
-		for (i = 0; i < grille->longueur; i++) {
-			grille->tab[j][i] = element[i + j * grille->longueur];
+	for(i = 0; i < grille->largeur; i++) {
+		memset(&GRILLE_OCTET(grille, 0, i), 0, grille->longueur);
+	}
+	memset(grille->lignes, 0, sizeof(int) * cases * GRILLE_NB_DIRECTIONS);
+	for(i = 0; i < cases; i++) {
+		grille->cases_libres[i] = i;
+		grille->rang_libre[i]   = i;
+	}
+	for(i = 0; i < grille->nb_plans; i++) {
+		if(grille->plans[i] != NULL) {
+			memset(grille->plans[i], 0, sizeof(uint64_t) * grille->mots_plans);
+		}
+	}
+	for(i = 0; i < grille->nb_menaces; i++) {
+		if(grille->menaces[i].valeur != NULL) {
+			memset(grille->menaces[i].valeur, 0, sizeof(int) * cases);
+			grille->menaces[i].nb_cases = 0;
+			grille->menaces[i].pions    = 0;
+		}
+	}
+	if(grille->distance_candidats > 0) {
+		memset(grille->proximite, 0, sizeof(int) * cases);
+		for(i = 0; i < cases; i++) {
+			grille->rang_candidat[i] = -1;
 		}
-		printf("\n");
+		grille->nb_candidats = 0;
 	}
+	grille->libres = cases;
+	grille->premiere_libre = 0;
+	grille->zobrist = 0;
+	memset(grille->zobrist_symetries, 0, sizeof(grille->zobrist_symetries));
 }
@@ -0,0 +1,28 @@
+/**
+ * \file horloge.c
+ * \brief Mesure du temps pour les stratégies et les benchmarks.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ */
+
+/* clock_gettime n'est pas dans ANSI C. */
+#define _POSIX_C_SOURCE 199309L
+
+#include <time.h>
+
+#include "horloge.h"
+
+/**
+ * \fn double horloge_secondes(void)
+ * \brief Temps d'une horloge monotone, en secondes.
+ *
+ * L'origine est arbitraire, seules les différences ont un sens.
+ *
+ * \return Le temps en secondes.
+ */
+double horloge_secondes(void) {
+	struct timespec maintenant;
+	clock_gettime(CLOCK_MONOTONIC, &maintenant);
+	return maintenant.tv_sec + maintenant.tv_nsec * 1e-9;
+}
@@ -8,10 +8,17 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "joueur.h"
 #include "grille.h"
 #include "strategies.h"
+#include "reserve.h"
+
+/** Éléments de ListeJoueurs de tous les threads, recyclés. */
+static Reserve joueurs_elements = RESERVE_INITIALISEUR(sizeof(ListeJoueurs));
+/** Joueurs de tous les threads, recyclés. */
+static Reserve joueurs_reserve = RESERVE_INITIALISEUR(sizeof(Joueur));
 
 /**
  * \fn ListeJoueurs* joueurs_creer_liste(Joueur* joueur)
@@ -24,7 +31,7 @@
  * \return Un élément de ListeJoueurs, seul élément de la liste.
  */
 ListeJoueurs* joueurs_creer_liste(Joueur* joueur) {
-	ListeJoueurs* liste_circulaire = (ListeJoueurs*) malloc(sizeof(ListeJoueurs));
+	ListeJoueurs* liste_circulaire = (ListeJoueurs*) reserve_prendre(&joueurs_elements);
 	if(liste_circulaire == NULL) {
 		perror("Impossible d'allouer la liste des joueurs.");
 		exit(EXIT_FAILURE);
@@ -48,6 +55,16 @@ void joueurs_place_suivant(ListeJoueurs* liste, Joueur* joueur) {
 	liste->suivant   = nouveau;
 }
 
+/**
+ * \fn void joueurs_liberer_element(ListeJoueurs* element)
+ * \brief Libère un élément retiré de sa liste, sans son joueur.
+ *
+ * \param element Élément créé par ::joueurs_creer_liste ou ::joueurs_place_suivant.
+ */
+void joueurs_liberer_element(ListeJoueurs* element) {
+	reserve_rendre(&joueurs_elements, element);
+}
+
 /**
  * \fn void joueurs_liberer_liste(ListeJoueurs* liste)
  * \brief Libère les Joueurs et les éléments de la liste.
@@ -62,8 +79,8 @@ void joueurs_liberer_liste(ListeJoueurs* liste) {
 
 	/* Cas spécial un seul élément */
 	if(liste == liste->suivant) {
-		free(liste->joueur);
-		free(liste);
+		libererJoueur(liste->joueur);
+		joueurs_liberer_element(liste);
 		return;
 	}
 
@@ -73,30 +90,64 @@ void joueurs_liberer_liste(ListeJoueurs* liste) {
 			liste = suivant
 	) {
 		suivant = liste->suivant;
-		free(liste->joueur);
-		free(liste);
+		libererJoueur(liste->joueur);
+		joueurs_liberer_element(liste);
 	}
 }
 
 /**
- * \fn Joueur* creerJoueurHumain(int id)
- * \brief Crée un joueur avec la stratégie manuelle.
+ * \fn void libererJoueur(Joueur* joueur)
+ * \brief Libère un joueur et les resources de sa stratégie.
+ *
+ * \param joueur Joueur à libérer.
+ */
+void libererJoueur(Joueur* joueur) {
+	transposition_liberer(joueur->table);
+	reserve_rendre(&joueurs_reserve, joueur);
+}
+
+/**
+ * \fn static Joueur* joueur_allouer(int id, void (*place)(Joueur*, Grille*, int*, int*))
+ * \brief Alloue un joueur avec une stratégie et les paramètres par défaut.
+ *
+ * Le générateur du joueur est initialisé par rand() et il n'a ni budget ni
+ * table de transposition. Il consulte les solutions exactes et les livres
+ * d'ouvertures du processus (voir ::solution_partage et ::livre_partage).
  *
  * \param id Identifiant du joueur.
- * \return Joueur avec stratégie manuelle.
+ * \param place Fonction de stratégie.
+ * \return Le joueur alloué.
  */
-Joueur* creerJoueurHumain(int id) {
-	Joueur* joueur = (Joueur*) malloc(sizeof(Joueur));
+static Joueur* joueur_allouer(int id, void (*place)(Joueur*, Grille*, int*, int*)) {
+	Joueur* joueur = (Joueur*) reserve_prendre(&joueurs_reserve);
 	if(joueur == NULL) {
 		perror("Impossible d'allouer le joueur");
 		exit(EXIT_FAILURE);
 	}
-	joueur->id = id;
-	joueur->place = strategie_manuelle;
+	joueur->id    = id;
+	joueur->place = place;
+	alea_init(&joueur->alea, rand());
+	joueur->budget_ms         = 0;
+	joueur->budget_iterations = 0;
+	joueur->nb_threads        = 1;
+	joueur->table             = NULL;
+	joueur->livre             = livre_partage();
+	joueur->solution          = solution_partage();
 
 	return joueur;
 }
 
+/**
+ * \fn Joueur* creerJoueurHumain(int id)
+ * \brief Crée un joueur avec la stratégie manuelle.
+ *
+ * \param id Identifiant du joueur.
+ * \return Joueur avec stratégie manuelle.
+ */
+Joueur* creerJoueurHumain(int id) {
+	return joueur_allouer(id, strategie_manuelle);
+}
+
 /**
  * \fn Joueur* creerJoueurRandom(int id)
  * \brief Crée un joueur avec la stratégie aléatoire.
@@ -105,15 +156,7 @@ Joueur* creerJoueurHumain(int id) {
  * \return Joueur avec stratégie aléatoire.
  */
 Joueur* creerJoueurRandom(int id) {
-	Joueur* joueur = (Joueur*) malloc(sizeof(Joueur));
-	if(joueur == NULL) {
-		perror("Impossible d'allouer le joueur");
-		exit(EXIT_FAILURE);
-	}
-	joueur->id = id;
-	joueur->place = strategie_random;
-
-	return joueur;
+	return joueur_allouer(id, strategie_random);
 }
 
 /**
@@ -124,13 +167,84 @@ Joueur* creerJoueurRandom(int id) {
  * \return Joueur avec stratégie défense.
  */
 Joueur* creerJoueurDefense(int id) {
-	Joueur* joueur = (Joueur*) malloc(sizeof(Joueur));
-	if(joueur == NULL) {
-		perror("Impossible d'allouer le joueur");
+	return joueur_allouer(id, strategie_defense);
+}
+
+/**
+ * \fn Joueur* creerJoueurAlphaBeta(int id)
+ * \brief Crée un joueur avec la stratégie alpha-beta.
+ *
+ * Le joueur réfléchit au plus STRATEGIE_ALPHABETA_BUDGET_MS millisecondes
+ * par coup et garde une table de transposition de
+ * STRATEGIE_TRANSPOSITION_OCTETS octets d'un coup à l'autre.
+ *
+ * \param id Identifiant du joueur.
+ * \return Joueur avec stratégie alpha-beta.
+ */
+Joueur* creerJoueurAlphaBeta(int id) {
+	Joueur* joueur = joueur_allouer(id, strategie_alphabeta);
+	joueur->budget_ms = STRATEGIE_ALPHABETA_BUDGET_MS;
+	joueur->table = transposition_creer(STRATEGIE_TRANSPOSITION_OCTETS, TRANSPOSITION_POLITIQUE_PROFONDEUR);
+	if(joueur->table == NULL) {
 		exit(EXIT_FAILURE);
 	}
-	joueur->id = id;
-	joueur->place = strategie_defense;
 
 	return joueur;
 }
+
+/**
+ * \fn Joueur* creerJoueurMCTS(int id)
+ * \brief Crée un joueur avec la stratégie Monte Carlo Tree Search.
+ *
+ * Le joueur réfléchit au plus STRATEGIE_MCTS_BUDGET_MS millisecondes par
+ * coup, sur autant de threads que de coeurs (Joueur::nb_threads à 0).
+ *
+ * \param id Identifiant du joueur.
+ * \return Joueur avec stratégie MCTS.
+ */
+Joueur* creerJoueurMCTS(int id) {
+	Joueur* joueur = joueur_allouer(id, strategie_mcts);
+	joueur->budget_ms  = STRATEGIE_MCTS_BUDGET_MS;
+	joueur->nb_threads = 0;
+
+	return joueur;
+}
+
+/**
+ * \struct StrategieConnue
+ * \brief Associe un nom de stratégie à la fonction qui crée le joueur.
+ */
+typedef struct StrategieConnue {
+	const char* nom;          /*!< Nom de la stratégie. */
+	Joueur* (*creer)(int id); /*!< Fonction de création du joueur. */
+} StrategieConnue;
+
+/** Stratégies utilisables par ::creerJoueurParNom. */
+static const StrategieConnue strategies_connues[] = {
+	{ "humain",    creerJoueurHumain    },
+	{ "random",    creerJoueurRandom    },
+	{ "defense",   creerJoueurDefense   },
+	{ "alphabeta", creerJoueurAlphaBeta },
+	{ "mcts",      creerJoueurMCTS      },
+	{ NULL,        NULL                 }
+};
+
+/**
+ * \fn Joueur* creerJoueurParNom(const char* nom, int id)
+ * \brief Crée un joueur à partir du nom de sa stratégie.
+ *
+ * \param nom Nom de la stratégie ("humain", "random", "defense", "alphabeta", "mcts").
+ * \param id Identifiant du joueur.
+ * \return Joueur avec la stratégie demandée, NULL si elle est inconnue.
+ */
+Joueur* creerJoueurParNom(const char* nom, int id) {
+	const StrategieConnue* strategie;
+
+	for(strategie = strategies_connues; strategie->nom != NULL; strategie++) {
+		if(strcmp(strategie->nom, nom) == 0) {
+			return strategie->creer(id);
+		}
+	}
+
+	return NULL;
+}
@@ -0,0 +1,279 @@
+/**
+ * \file journal.c
+ * \brief Journal des parties du serveur, pour les retrouver après un arrêt.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "journal.h"
+
+/**
+ * \fn static int journal_ecrire_tout(int fd, const unsigned char* donnees, size_t taille)
+ * \brief Écrit tous les octets, même si write s'interrompt.
+ *
+ * \return 1 si tout est écrit, 0 sinon.
+ */
+static int journal_ecrire_tout(int fd, const unsigned char* donnees, size_t taille) {
+	while(taille > 0) {
+		ssize_t ecrits = write(fd, donnees, taille);
+		if(ecrits < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+			return 0;
+		}
+		donnees += ecrits;
+		taille  -= (size_t) ecrits;
+	}
+	return 1;
+}
+
+/**
+ * \fn static long journal_relire(int fd, MorpionConfig config, void (*rejouer)(void*, const EnregistrementJournal*), void* contexte)
+ * \brief Rejoue un journal existant à travers une projection en mémoire.
+ *
+ * Les enregistrements sont lus en place, sans copie. La lecture s'arrête au
+ * premier enregistrement incomplet ou de type inconnu : c'est la trace d'un
+ * arrêt pendant une écriture.
+ *
+ * \return La taille du journal valide en octets, -1 si le journal est illisible
+ * ou d'une autre configuration.
+ */
+static long journal_relire(int fd, MorpionConfig config,
+		void (*rejouer)(void*, const EnregistrementJournal*), void* contexte) {
+	struct stat etat;
+	const unsigned char* carte;
+	const EnteteJournal* entete;
+	const EnregistrementJournal* enregistrement;
+	size_t nombre, i;
+
+	if(fstat(fd, &etat) < 0) {
+		perror("Impossible de lire la taille du journal.");
+		return -1;
+	}
+	if((size_t) etat.st_size < sizeof(EnteteJournal)) {
+		return 0;
+	}
+
+	carte = (const unsigned char*) mmap(NULL, etat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if(carte == MAP_FAILED) {
+		perror("Impossible de projeter le journal en mémoire.");
+		return -1;
+	}
+	madvise((void*) carte, etat.st_size, MADV_SEQUENTIAL);
+
+	entete = (const EnteteJournal*) carte;
+	if(entete->magique != JOURNAL_MAGIQUE || entete->version != JOURNAL_VERSION) {
+		fprintf(stderr, "Journal illisible : format ou version inconnus.\n");
+		munmap((void*) carte, etat.st_size);
+		return -1;
+	}
+	if(entete->longueur != config.longueur || entete->largeur != config.largeur
+			|| entete->alignement != config.alignement) {
+		fprintf(stderr, "Journal écrit pour des parties %dx%d alignement %d : "
+				"relancer le serveur avec cette configuration.\n",
+				entete->longueur, entete->largeur, entete->alignement);
+		munmap((void*) carte, etat.st_size);
+		return -1;
+	}
+
+	enregistrement = (const EnregistrementJournal*) (carte + sizeof(EnteteJournal));
+	nombre = (etat.st_size - sizeof(EnteteJournal)) / sizeof(EnregistrementJournal);
+	for(i = 0; i < nombre; i++) {
+		if(enregistrement[i].type < JOURNAL_JOIN || enregistrement[i].type > JOURNAL_ATTENTE) {
+			break;
+		}
+		rejouer(contexte, &enregistrement[i]);
+	}
+
+	munmap((void*) carte, etat.st_size);
+
+	return (long) (sizeof(EnteteJournal) + i * sizeof(EnregistrementJournal));
+}
+
+/**
+ * \fn static void* journal_thread_ecriture(void* argument)
+ * \brief Écrit et synchronise les tampons pleins jusqu'à la fermeture.
+ */
+static void* journal_thread_ecriture(void* argument) {
+	Journal* journal = (Journal*) argument;
+
+	pthread_mutex_lock(&journal->verrou);
+	while(1) {
+		unsigned char* tampon;
+		size_t taille;
+
+		while(journal->rempli == 0 && journal->actif) {
+			pthread_cond_wait(&journal->donnees, &journal->verrou);
+		}
+		if(journal->rempli == 0) {
+			break;
+		}
+
+		/* Échange des tampons : les écrivains continuent pendant l'écriture. */
+		tampon = journal->tampons[journal->courant];
+		taille = journal->rempli;
+		journal->courant = 1 - journal->courant;
+		journal->rempli  = 0;
+		pthread_cond_broadcast(&journal->place);
+		pthread_mutex_unlock(&journal->verrou);
+
+		if(!journal_ecrire_tout(journal->fd, tampon, taille) || fdatasync(journal->fd) < 0) {
+			perror("Impossible d'écrire le journal.");
+		}
+
+		pthread_mutex_lock(&journal->verrou);
+		journal->enregistrements  += taille / sizeof(EnregistrementJournal);
+		journal->synchronisations += 1;
+	}
+	pthread_mutex_unlock(&journal->verrou);
+
+	return NULL;
+}
+
+/**
+ * \fn Journal* journal_ouvrir(const char* chemin, MorpionConfig config, void (*rejouer)(void*, const EnregistrementJournal*), void* contexte)
+ * \brief Rejoue un journal puis l'ouvre pour y ajouter la suite.
+ *
+ * Le journal est créé s'il n'existe pas. Un enregistrement interrompu par un
+ * arrêt brutal est effacé avant les nouveaux.
+ *
+ * \param chemin Fichier du journal.
+ * \param config Configuration des parties du serveur.
+ * \param rejouer Fonction appelée pour chaque enregistrement du journal, dans l'ordre.
+ * \param contexte Premier argument de rejouer.
+ * \return Le journal, NULL s'il est illisible ou d'une autre configuration.
+ */
+Journal* journal_ouvrir(const char* chemin, MorpionConfig config,
+		void (*rejouer)(void* contexte, const EnregistrementJournal* enregistrement), void* contexte) {
+	Journal* journal;
+	long taille;
+
+	journal = (Journal*) calloc(1, sizeof(Journal));
+	if(journal == NULL) {
+		perror("Impossible d'allouer le journal.");
+		return NULL;
+	}
+	journal->fd = open(chemin, O_RDWR | O_CREAT, 0644);
+	if(journal->fd < 0) {
+		perror("Impossible d'ouvrir le journal.");
+		free(journal);
+		return NULL;
+	}
+
+	taille = journal_relire(journal->fd, config, rejouer, contexte);
+	if(taille < 0) {
+		close(journal->fd);
+		free(journal);
+		return NULL;
+	}
+
+	if(taille == 0) {
+		EnteteJournal entete;
+
+		memset(&entete, 0, sizeof(entete));
+		entete.magique    = JOURNAL_MAGIQUE;
+		entete.version    = JOURNAL_VERSION;
+		entete.longueur   = config.longueur;
+		entete.largeur    = config.largeur;
+		entete.alignement = config.alignement;
+		if(ftruncate(journal->fd, 0) < 0
+				|| !journal_ecrire_tout(journal->fd, (unsigned char*) &entete, sizeof(entete))) {
+			perror("Impossible d'écrire l'entête du journal.");
+			close(journal->fd);
+			free(journal);
+			return NULL;
+		}
+		taille = sizeof(entete);
+	}
+	if(ftruncate(journal->fd, taille) < 0 || lseek(journal->fd, taille, SEEK_SET) < 0
+			|| fsync(journal->fd) < 0) {
+		perror("Impossible de préparer le journal.");
+		close(journal->fd);
+		free(journal);
+		return NULL;
+	}
+
+	journal->tampons[0] = (unsigned char*) malloc(JOURNAL_TAILLE_TAMPON);
+	journal->tampons[1] = (unsigned char*) malloc(JOURNAL_TAILLE_TAMPON);
+	if(journal->tampons[0] == NULL || journal->tampons[1] == NULL) {
+		perror("Impossible d'allouer les tampons du journal.");
+		exit(EXIT_FAILURE);
+	}
+	journal->actif = 1;
+	pthread_mutex_init(&journal->verrou, NULL);
+	pthread_cond_init(&journal->donnees, NULL);
+	pthread_cond_init(&journal->place, NULL);
+
+	if(pthread_create(&journal->thread, NULL, journal_thread_ecriture, journal) != 0) {
+		perror("Impossible de lancer le thread du journal.");
+		exit(EXIT_FAILURE);
+	}
+
+	return journal;
+}
+
+/**
+ * \fn void journal_ecrire(Journal* journal, int type, int partie, int joueur, int x, int y)
+ * \brief Ajoute un enregistrement au prochain groupe écrit.
+ *
+ * Ne bloque que si les deux tampons sont pleins, c'est à dire si le disque
+ * ne suit pas.
+ *
+ * \param journal Journal ouvert.
+ * \param type Un des JOURNAL_*.
+ * \param partie Identifiant de la partie.
+ * \param joueur Joueur qui arrive, joue ou part.
+ * \param x Position x du coup, 0 sinon.
+ * \param y Position y du coup, 0 sinon.
+ */
+void journal_ecrire(Journal* journal, int type, int partie, int joueur, int x, int y) {
+	EnregistrementJournal enregistrement;
+
+	enregistrement.type   = type;
+	enregistrement.partie = partie;
+	enregistrement.joueur = joueur;
+	enregistrement.x      = x;
+	enregistrement.y      = y;
+
+	pthread_mutex_lock(&journal->verrou);
+	while(journal->rempli + sizeof(enregistrement) > JOURNAL_TAILLE_TAMPON) {
+		pthread_cond_wait(&journal->place, &journal->verrou);
+	}
+	memcpy(journal->tampons[journal->courant] + journal->rempli, &enregistrement, sizeof(enregistrement));
+	journal->rempli += sizeof(enregistrement);
+	pthread_cond_signal(&journal->donnees);
+	pthread_mutex_unlock(&journal->verrou);
+}
+
+/**
+ * \fn void journal_fermer(Journal* journal)
+ * \brief Écrit les derniers enregistrements et ferme le journal.
+ *
+ * \param journal Journal ouvert, sans autre thread qui écrit.
+ */
+void journal_fermer(Journal* journal) {
+	pthread_mutex_lock(&journal->verrou);
+	journal->actif = 0;
+	pthread_cond_signal(&journal->donnees);
+	pthread_mutex_unlock(&journal->verrou);
+	pthread_join(journal->thread, NULL);
+
+	pthread_cond_destroy(&journal->place);
+	pthread_cond_destroy(&journal->donnees);
+	pthread_mutex_destroy(&journal->verrou);
+	close(journal->fd);
+	free(journal->tampons[0]);
+	free(journal->tampons[1]);
+	free(journal);
+}
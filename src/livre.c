@@ -0,0 +1,265 @@
+/**
+ * \file livre.c
+ * \brief Livre d'ouvertures précalculé, lu par projection en mémoire.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "livre.h"
+
+/** Livres de MORPION_LIVRE, ouverts une fois par ::livre_partage. */
+static Livre* livre_partages = NULL;
+/** Garantit une seule ouverture des livres partagés. */
+static pthread_once_t livre_partages_ouverts = PTHREAD_ONCE_INIT;
+
+/**
+ * \fn uint64_t livre_cle(Grille* grille, int joueur, int* symetrie)
+ * \brief Clé d'une position, indépendante des identifiants des joueurs et des symétries.
+ *
+ * \param grille Position.
+ * \param joueur Identifiant du joueur au trait.
+ * \param symetrie Pointeur pour sauver la symétrie qui donne la forme canonique.
+ * \return La clé de la position, voir livre.h.
+ */
+uint64_t livre_cle(Grille* grille, int joueur, int* symetrie) {
+	int cases = grille->longueur * grille->largeur;
+	int nombre = grille_nb_symetries(grille->longueur, grille->largeur);
+	uint64_t cles[GRILLE_SYMETRIES_MAX] = {0};
+	int i, s;
+
+	for(i = 0; i < cases; i++) {
+		int J = GRILLE_OCTET(grille, i % grille->longueur, i / grille->longueur);
+		if(J != 0) {
+			J = J == joueur ? 1 : 2;
+			for(s = 0; s < nombre; s++) {
+				cles[s] ^= grille_cle_zobrist(grille_symetrie_case(grille->longueur, grille->largeur, s, i), J);
+			}
+		}
+	}
+
+	*symetrie = 0;
+	for(s = 1; s < nombre; s++) {
+		if(cles[s] < cles[*symetrie]) {
+			*symetrie = s;
+		}
+	}
+	return cles[*symetrie];
+}
+
+/**
+ * \fn Livre* livre_ouvrir(const char* chemin)
+ * \brief Projette un livre en mémoire, en lecture seule.
+ *
+ * \param chemin Fichier du livre.
+ * \return Le livre, NULL s'il est illisible.
+ */
+Livre* livre_ouvrir(const char* chemin) {
+	Livre* livre;
+	struct stat etat;
+	void* carte;
+	int fd = open(chemin, O_RDONLY);
+
+	if(fd < 0 || fstat(fd, &etat) < 0) {
+		perror("Impossible d'ouvrir le livre d'ouvertures.");
+		if(fd >= 0) {
+			close(fd);
+		}
+		return NULL;
+	}
+	if((size_t) etat.st_size < sizeof(EnteteLivre)) {
+		fprintf(stderr, "Livre d'ouvertures %s illisible : fichier trop court.\n", chemin);
+		close(fd);
+		return NULL;
+	}
+
+	carte = mmap(NULL, etat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(carte == MAP_FAILED) {
+		perror("Impossible de projeter le livre d'ouvertures en mémoire.");
+		return NULL;
+	}
+	madvise(carte, etat.st_size, MADV_RANDOM);
+
+	livre = (Livre*) malloc(sizeof(Livre));
+	if(livre == NULL) {
+		perror("Impossible d'allouer le livre d'ouvertures.");
+		munmap(carte, etat.st_size);
+		return NULL;
+	}
+	livre->entete  = (const EnteteLivre*) carte;
+	livre->entrees = (const EntreeLivre*) (livre->entete + 1);
+	livre->taille  = etat.st_size;
+	livre->suivant = NULL;
+
+	if(livre->entete->magique != LIVRE_MAGIQUE || livre->entete->version != LIVRE_VERSION
+			|| livre->entete->nombre != (livre->taille - sizeof(EnteteLivre)) / sizeof(EntreeLivre)) {
+		fprintf(stderr, "Livre d'ouvertures %s illisible : format, version ou taille inconnus.\n", chemin);
+		livre_fermer(livre);
+		return NULL;
+	}
+
+	return livre;
+}
+
+/**
+ * \fn void livre_fermer(Livre* livre)
+ * \brief Ferme un livre ouvert par ::livre_ouvrir.
+ *
+ * \param livre Livre ouvert, que plus aucun joueur ne consulte.
+ */
+void livre_fermer(Livre* livre) {
+	munmap((void*) livre->entete, livre->taille);
+	free(livre);
+}
+
+/**
+ * \fn int livre_chercher(const Livre* livre, Grille* grille, int joueur)
+ * \brief Cherche le coup du livre pour une position.
+ *
+ * Les livres suivants sont consultés si le premier n'est pas de la
+ * configuration de la grille. Hors du livre, seul le nombre de pions est
+ * regardé : la recherche ne coûte rien passé l'ouverture.
+ *
+ * \param livre Premier livre à consulter, peut être NULL.
+ * \param grille Position.
+ * \param joueur Identifiant du joueur au trait.
+ * \return L'indice de la case à jouer, -1 si la position n'est pas dans le livre.
+ */
+int livre_chercher(const Livre* livre, Grille* grille, int joueur) {
+	int cases = grille->longueur * grille->largeur;
+	int pions = cases - grille->libres;
+
+	for(; livre != NULL; livre = livre->suivant) {
+		const EnteteLivre* entete = livre->entete;
+		uint64_t cle;
+		size_t debut, fin;
+		int symetrie;
+
+		if(entete->longueur != grille->longueur || entete->largeur != grille->largeur
+				|| entete->alignement != grille->alignement) {
+			continue;
+		}
+		if(pions > entete->profondeur) {
+			return -1;
+		}
+
+		cle   = livre_cle(grille, joueur, &symetrie);
+		debut = 0;
+		fin   = entete->nombre;
+		while(debut < fin) {
+			size_t milieu = debut + (fin - debut) / 2;
+			if(livre->entrees[milieu].cle < cle) {
+				debut = milieu + 1;
+			} else {
+				fin = milieu;
+			}
+		}
+		if(debut < entete->nombre && livre->entrees[debut].cle == cle) {
+			const EntreeLivre* entree = &livre->entrees[debut];
+			int coup = entree->coup < cases ? grille_symetrie_case(grille->longueur, grille->largeur,
+					grille_symetrie_inverse(symetrie), entree->coup) : -1;
+			/* Une collision de clés ne doit jamais faire jouer une case prise. */
+			if(entree->pions == pions && coup >= 0
+					&& GRILLE_OCTET(grille, coup % grille->longueur, coup / grille->longueur) == 0) {
+				return coup;
+			}
+		}
+		return -1;
+	}
+
+	return -1;
+}
+
+/**
+ * \fn static void livre_ouvrir_partages(void)
+ * \brief Ouvre les livres de MORPION_LIVRE, séparés par des ':'.
+ */
+static void livre_ouvrir_partages(void) {
+	char* chemins = getenv("MORPION_LIVRE");
+	Livre** dernier = &livre_partages;
+	char* copie;
+	char* chemin;
+	char* reste;
+	int nombre = 0;
+
+	if(chemins == NULL || (copie = strdup(chemins)) == NULL) {
+		return;
+	}
+	for(chemin = strtok_r(copie, ":", &reste); chemin != NULL && nombre < LIVRE_MAX;
+			chemin = strtok_r(NULL, ":", &reste)) {
+		Livre* livre = livre_ouvrir(chemin);
+		if(livre != NULL) {
+			*dernier = livre;
+			dernier  = &livre->suivant;
+			nombre++;
+		}
+	}
+	free(copie);
+}
+
+/**
+ * \fn const Livre* livre_partage(void)
+ * \brief Livres d'ouvertures du processus.
+ *
+ * Les fichiers de la variable d'environnement MORPION_LIVRE, séparés par des
+ * ':', sont ouverts au premier appel et le restent jusqu'à la fin du
+ * processus : tous les joueurs de tous les threads les partagent.
+ *
+ * \return Le premier livre, NULL si MORPION_LIVRE n'en donne aucun.
+ */
+const Livre* livre_partage(void) {
+	pthread_once(&livre_partages_ouverts, livre_ouvrir_partages);
+	return livre_partages;
+}
+
+/**
+ * \fn static int livre_comparer(const void* a, const void* b)
+ * \brief Compare deux entrées par clé pour qsort.
+ */
+static int livre_comparer(const void* a, const void* b) {
+	uint64_t cle_a = ((const EntreeLivre*) a)->cle;
+	uint64_t cle_b = ((const EntreeLivre*) b)->cle;
+
+	return cle_a < cle_b ? -1 : cle_a > cle_b;
+}
+
+/**
+ * \fn int livre_ecrire(const char* chemin, const EnteteLivre* entete, EntreeLivre* entrees)
+ * \brief Trie les entrées d'un livre et l'écrit.
+ *
+ * \param chemin Fichier du livre, remplacé s'il existe.
+ * \param entete Entête du livre, EnteteLivre::nombre donne le nombre d'entrées.
+ * \param entrees Entrées, dans n'importe quel ordre, sans clé en double.
+ * \return 1 si le livre est écrit, 0 sinon.
+ */
+int livre_ecrire(const char* chemin, const EnteteLivre* entete, EntreeLivre* entrees) {
+	FILE* fichier = fopen(chemin, "wb");
+	size_t nombre = (size_t) entete->nombre;
+
+	if(fichier == NULL) {
+		perror("Impossible de créer le livre d'ouvertures.");
+		return 0;
+	}
+	qsort(entrees, nombre, sizeof(EntreeLivre), livre_comparer);
+	if(fwrite(entete, sizeof(EnteteLivre), 1, fichier) != 1
+			|| fwrite(entrees, sizeof(EntreeLivre), nombre, fichier) != nombre) {
+		perror("Impossible d'écrire le livre d'ouvertures.");
+		fclose(fichier);
+		return 0;
+	}
+	if(fclose(fichier) != 0) {
+		perror("Impossible d'écrire le livre d'ouvertures.");
+		return 0;
+	}
+	return 1;
+}
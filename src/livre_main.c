@@ -0,0 +1,433 @@
+/**
+ * \file livre_main.c
+ * \brief Construit le livre d'ouvertures d'une configuration.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ *
+ * Les positions sont parcourues profondeur par profondeur depuis la grille
+ * vide. Le coup de chaque position est choisi par une stratégie de
+ * recherche, avec un budget bien plus grand qu'en partie. Les positions de
+ * la profondeur suivante sont celles après ce coup et après les autres coups
+ * plausibles : toutes les cases pour les premières profondeurs
+ * (-c --completes), puis les cases voisines d'un pion. Les positions déjà
+ * atteintes par un autre ordre de coups, ou symétriques d'une autre, ne
+ * sont cherchées qu'une fois.
+ *
+ * Les threads se partagent les positions d'une profondeur au fur et à
+ * mesure, chacun avec sa grille et ses joueurs.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "morpion.h"
+#include "livre.h"
+#include "horloge.h"
+
+#define LIVRE_PROFONDEUR_MAX 16 /**< Nombre maximal de premiers coups couverts par un livre. */
+
+/**
+ * \struct LivreOptions
+ * \brief Options de la ligne de commande.
+ */
+typedef struct LivreOptions {
+	MorpionConfig config;   /*!< Configuration du livre. */
+	int profondeur;         /*!< Nombre de premiers coups couverts par le livre. */
+	int completes;          /*!< Profondeurs où toutes les cases sont explorées. */
+	char* strategie;        /*!< Stratégie qui choisit les coups. */
+	int budget_ms;          /*!< Temps de réflexion par position. */
+	int threads;            /*!< Nombre de threads. */
+	char* sortie;           /*!< Fichier du livre. */
+} LivreOptions;
+
+/**
+ * \struct PositionLivre
+ * \brief Une position à chercher, donnée par ses coups.
+ */
+typedef struct PositionLivre {
+	uint64_t cle;                        /*!< Clé de la position, voir livre.h. */
+	int coups[LIVRE_PROFONDEUR_MAX];     /*!< Cases jouées, les joueurs 1 et 2 en alternance. */
+} PositionLivre;
+
+/**
+ * \struct LivreNiveau
+ * \brief Positions d'une profondeur, partagées entre les threads.
+ */
+typedef struct LivreNiveau {
+	const LivreOptions* options;   /*!< Options de la génération. */
+	int pions;                     /*!< Nombre de pions des positions. */
+	PositionLivre* positions;      /*!< Positions à chercher. */
+	long nombre;                   /*!< Nombre de positions. */
+	long prochaine;                /*!< Prochaine position à distribuer. */
+	EntreeLivre* entrees;          /*!< Entrée de chaque position, même rang. */
+} LivreNiveau;
+
+/**
+ * \struct LivreTravail
+ * \brief Grille, joueurs et positions suivantes d'un thread.
+ */
+typedef struct LivreTravail {
+	pthread_t thread;              /*!< Thread qui cherche. */
+	LivreNiveau* niveau;           /*!< Profondeur en cours. */
+	Grille* grille;                /*!< Grille du thread. */
+	Joueur* joueurs[2];            /*!< Joueurs 1 et 2. */
+	PositionLivre* suivantes;      /*!< Positions de la profondeur suivante. */
+	long nb_suivantes;             /*!< Nombre de positions suivantes. */
+	long capacite;                 /*!< Taille allouée de suivantes. */
+} LivreTravail;
+
+/**
+ * \fn static void livre_usage(FILE* stream, int exit_code)
+ * \brief Affiche comment utiliser la commande.
+ *
+ * \param stream Le flux où écrire l'aide.
+ * \param exit_code Le code d'erreur à utiliser.
+ */
+static void livre_usage(FILE* stream, int exit_code) {
+	fprintf(stream, "Utilisation : livre options -o fichier\n");
+	fprintf(stream,
+			" -o --sortie fichier     Fichier du livre, remplacé s'il existe.\n"
+			" -y --hauteur n          Fixe la hauteur du plateau à n cases.\n"
+			" -x --largeur n          Fixe la largeur du plateau à n cases.\n"
+			" -a --alignement n       Fixe à n le nombre de pions à aligner pour gagner.\n"
+	);
+	fprintf(stream,
+			" -p --profondeur n       Nombre de premiers coups d'une partie couverts par le livre (3).\n"
+			" -c --completes n        Profondeurs où toutes les cases sont explorées (1).\n"
+			" -s --strategie s        Stratégie qui choisit les coups (alphabeta).\n"
+			" -b --budget n           Temps de réflexion par position en ms (100).\n"
+			" -t --threads n          Nombre de threads (nombre de coeurs).\n"
+			" -h --help               Affiche une aide et quitte le programme.\n"
+	);
+	exit(exit_code);
+}
+
+/**
+ * \fn static LivreOptions livre_parse_options(int argc, char* argv[])
+ * \brief Lit les options de la ligne de commande.
+ *
+ * \param argc Nombre d'arguments de la commande (du main).
+ * \param argv Tableau des chaines des arguments de la commande (du main).
+ * \return Les options.
+ */
+static LivreOptions livre_parse_options(int argc, char* argv[]) {
+	int next_option;
+	const char* const short_options = "o:y:x:a:p:c:s:b:t:h";
+
+	const struct option long_options[] = {
+		{ "sortie",     1, NULL, 'o' },
+		{ "hauteur",    1, NULL, 'y' },
+		{ "largeur",    1, NULL, 'x' },
+		{ "alignement", 1, NULL, 'a' },
+		{ "profondeur", 1, NULL, 'p' },
+		{ "completes",  1, NULL, 'c' },
+		{ "strategie",  1, NULL, 's' },
+		{ "budget",     1, NULL, 'b' },
+		{ "threads",    1, NULL, 't' },
+		{ "help",       0, NULL, 'h' },
+		{ NULL,         0, NULL,   0 }
+	};
+
+	static char strategie_defaut[] = "alphabeta";
+
+	LivreOptions options;
+	options.config.longueur   = MORPION_DEFAULT_LONGUEUR;
+	options.config.largeur    = MORPION_DEFAULT_LARGEUR;
+	options.config.alignement = MORPION_DEFAULT_ALIGNEMENT;
+	options.profondeur        = 3;
+	options.completes         = 1;
+	options.strategie         = strategie_defaut;
+	options.budget_ms         = 100;
+	options.threads           = sysconf(_SC_NPROCESSORS_ONLN);
+	options.sortie            = NULL;
+
+	do {
+		next_option = getopt_long(argc, argv, short_options, long_options, NULL);
+
+		switch (next_option) {
+		case 'o':
+			options.sortie = optarg;
+			break;
+		case 'x':
+			options.config.longueur = atoi(optarg);
+			break;
+		case 'y':
+			options.config.largeur = atoi(optarg);
+			break;
+		case 'a':
+			options.config.alignement = atoi(optarg);
+			break;
+		case 'p':
+			options.profondeur = atoi(optarg);
+			break;
+		case 'c':
+			options.completes = atoi(optarg);
+			break;
+		case 's':
+			options.strategie = optarg;
+			break;
+		case 'b':
+			options.budget_ms = atoi(optarg);
+			break;
+		case 't':
+			options.threads = atoi(optarg);
+			break;
+		case 'h':
+			livre_usage(stdout, 0);
+			break;
+		case '?':
+			livre_usage(stderr, 1);
+			break;
+		case -1:
+			break;
+		default:
+			abort();
+		}
+	} while (next_option != -1);
+
+	if(options.sortie == NULL || options.threads < 1 || options.profondeur < 1
+			|| options.profondeur > LIVRE_PROFONDEUR_MAX
+			|| options.profondeur > options.config.longueur * options.config.largeur) {
+		livre_usage(stderr, 1);
+	}
+
+	return options;
+}
+
+/**
+ * \fn static void livre_ajouter_suivante(LivreTravail* travail, const PositionLivre* position, int pions, int coup)
+ * \brief Ajoute la position suivante après un coup à celles du thread.
+ *
+ * \param travail Travail du thread, sa grille contient la position.
+ * \param position Position avant le coup.
+ * \param pions Nombre de pions de la position.
+ * \param coup Case jouée par le joueur au trait.
+ */
+static void livre_ajouter_suivante(LivreTravail* travail, const PositionLivre* position, int pions, int coup) {
+	Grille* grille = travail->grille;
+	int joueur = pions % 2 + 1;
+	PositionLivre* suivante;
+	int symetrie;
+
+	if(travail->nb_suivantes == travail->capacite) {
+		long capacite = travail->capacite > 0 ? 2 * travail->capacite : 1024;
+		PositionLivre* positions = (PositionLivre*) realloc(travail->suivantes, sizeof(PositionLivre) * capacite);
+		if(positions == NULL) {
+			perror("Impossible d'allouer les positions suivantes.");
+			exit(EXIT_FAILURE);
+		}
+		travail->suivantes = positions;
+		travail->capacite  = capacite;
+	}
+
+	suivante = &travail->suivantes[travail->nb_suivantes++];
+	memcpy(suivante->coups, position->coups, sizeof(int) * pions);
+	suivante->coups[pions] = coup;
+
+	placerPion(grille, joueur, coup % grille->longueur, coup / grille->longueur);
+	suivante->cle = livre_cle(grille, 3 - joueur, &symetrie);
+	retirerPion(grille, coup % grille->longueur, coup / grille->longueur);
+}
+
+/**
+ * \fn static int livre_voisine(Grille* grille, int indice)
+ * \brief Vrai si une case touche un pion, diagonales comprises.
+ */
+static int livre_voisine(Grille* grille, int indice) {
+	int x = indice % grille->longueur;
+	int y = indice / grille->longueur;
+	int dx, dy;
+
+	for(dy = -1; dy <= 1; dy++) {
+		for(dx = -1; dx <= 1; dx++) {
+			if(x + dx >= 0 && x + dx < grille->longueur && y + dy >= 0 && y + dy < grille->largeur
+					&& GRILLE_OCTET(grille, x + dx, y + dy) != 0) {
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+/**
+ * \fn static void* livre_thread(void* argument)
+ * \brief Cherche les positions d'une profondeur jusqu'à ce qu'il n'en reste plus.
+ */
+static void* livre_thread(void* argument) {
+	LivreTravail* travail = (LivreTravail*) argument;
+	LivreNiveau* niveau = travail->niveau;
+	Grille* grille = travail->grille;
+	int cases = grille->longueur * grille->largeur;
+	int pions = niveau->pions;
+	long rang;
+
+	while((rang = __atomic_fetch_add(&niveau->prochaine, 1, __ATOMIC_RELAXED)) < niveau->nombre) {
+		PositionLivre* position = &niveau->positions[rang];
+		Joueur* joueur = travail->joueurs[pions % 2];
+		int k, x, y, coup, symetrie;
+
+		grille_vider(grille);
+		for(k = 0; k < pions; k++) {
+			placerPion(grille, k % 2 + 1, position->coups[k] % grille->longueur, position->coups[k] / grille->longueur);
+		}
+		livre_cle(grille, pions % 2 + 1, &symetrie);
+
+		joueur->place(joueur, grille, &x, &y);
+		retirerPion(grille, x, y);
+		coup = y * grille->longueur + x;
+
+		niveau->entrees[rang].cle     = position->cle;
+		niveau->entrees[rang].coup    = grille_symetrie_case(grille->longueur, grille->largeur, symetrie, coup);
+		niveau->entrees[rang].pions   = pions;
+		niveau->entrees[rang].reserve = 0;
+
+		if(pions + 1 >= niveau->options->profondeur) {
+			continue;
+		}
+		livre_ajouter_suivante(travail, position, pions, coup);
+		for(k = 0; k < cases; k++) {
+			if(k != coup && GRILLE_OCTET(grille, k % grille->longueur, k / grille->longueur) == 0 && (pions < niveau->options->completes || livre_voisine(grille, k))) {
+				livre_ajouter_suivante(travail, position, pions, k);
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * \fn static int livre_comparer_positions(const void* a, const void* b)
+ * \brief Compare deux positions par clé pour qsort.
+ */
+static int livre_comparer_positions(const void* a, const void* b) {
+	uint64_t cle_a = ((const PositionLivre*) a)->cle;
+	uint64_t cle_b = ((const PositionLivre*) b)->cle;
+
+	return cle_a < cle_b ? -1 : cle_a > cle_b;
+}
+
+/**
+ * \fn int main(int argc, char* argv[])
+ * \brief Point d'entrée du générateur de livres d'ouvertures.
+ *
+ * \param argc Nombre d'arguments de la commande.
+ * \param argv Tableau des arguments.
+ *
+ * \return Code de sortie du programme.
+ */
+int main(int argc, char* argv[]) {
+	LivreOptions options = livre_parse_options(argc, argv);
+	LivreTravail* travaux;
+	LivreNiveau niveau;
+	EnteteLivre entete;
+	EntreeLivre* entrees = NULL;
+	double debut = horloge_secondes();
+	int i, j;
+
+	travaux = (LivreTravail*) malloc(sizeof(LivreTravail) * options.threads);
+	niveau.positions = (PositionLivre*) calloc(1, sizeof(PositionLivre));
+	if(travaux == NULL || niveau.positions == NULL) {
+		perror("Impossible d'allouer les travaux des threads.");
+		exit(EXIT_FAILURE);
+	}
+	for(i = 0; i < options.threads; i++) {
+		travaux[i].grille = initGrille(options.config.longueur, options.config.largeur);
+		if(travaux[i].grille == NULL) {
+			exit(EXIT_FAILURE);
+		}
+		travaux[i].grille->alignement = options.config.alignement;
+		for(j = 0; j < 2; j++) {
+			Joueur* joueur = creerJoueurParNom(options.strategie, j + 1);
+			if(joueur == NULL) {
+				fprintf(stderr, "Stratégie inconnue : %s\n", options.strategie);
+				exit(EXIT_FAILURE);
+			}
+			joueur->budget_ms  = options.budget_ms;
+			joueur->nb_threads = 1;
+			joueur->livre      = NULL;
+			travaux[i].joueurs[j] = joueur;
+		}
+		travaux[i].suivantes = NULL;
+		travaux[i].capacite  = 0;
+	}
+
+	memset(&entete, 0, sizeof(entete));
+	entete.magique    = LIVRE_MAGIQUE;
+	entete.version    = LIVRE_VERSION;
+	entete.longueur   = options.config.longueur;
+	entete.largeur    = options.config.largeur;
+	entete.alignement = options.config.alignement;
+	entete.profondeur = options.profondeur - 1;
+
+	niveau.options = &options;
+	niveau.nombre  = 1;
+	for(niveau.pions = 0; niveau.pions < options.profondeur && niveau.nombre > 0; niveau.pions++) {
+		long nombre;
+
+		entrees = (EntreeLivre*) realloc(entrees, sizeof(EntreeLivre) * (entete.nombre + niveau.nombre));
+		if(entrees == NULL) {
+			perror("Impossible d'allouer les entrées du livre.");
+			exit(EXIT_FAILURE);
+		}
+		niveau.entrees   = entrees + entete.nombre;
+		niveau.prochaine = 0;
+
+		for(i = 0; i < options.threads; i++) {
+			travaux[i].niveau       = &niveau;
+			travaux[i].nb_suivantes = 0;
+			if(pthread_create(&travaux[i].thread, NULL, livre_thread, &travaux[i]) != 0) {
+				perror("Impossible de créer un thread.");
+				exit(EXIT_FAILURE);
+			}
+		}
+		nombre = 0;
+		for(i = 0; i < options.threads; i++) {
+			pthread_join(travaux[i].thread, NULL);
+			nombre += travaux[i].nb_suivantes;
+		}
+		entete.nombre += niveau.nombre;
+		printf("%d pions : %ld positions, %.1f s\n", niveau.pions, niveau.nombre, horloge_secondes() - debut);
+
+		/* Positions suivantes de tous les threads, sans doublons. */
+		niveau.positions = (PositionLivre*) realloc(niveau.positions, sizeof(PositionLivre) * (nombre > 0 ? nombre : 1));
+		if(niveau.positions == NULL) {
+			perror("Impossible d'allouer les positions suivantes.");
+			exit(EXIT_FAILURE);
+		}
+		nombre = 0;
+		for(i = 0; i < options.threads; i++) {
+			memcpy(niveau.positions + nombre, travaux[i].suivantes, sizeof(PositionLivre) * travaux[i].nb_suivantes);
+			nombre += travaux[i].nb_suivantes;
+		}
+		qsort(niveau.positions, nombre, sizeof(PositionLivre), livre_comparer_positions);
+		niveau.nombre = 0;
+		for(j = 0; j < nombre; j++) {
+			if(niveau.nombre == 0 || niveau.positions[j].cle != niveau.positions[niveau.nombre - 1].cle) {
+				niveau.positions[niveau.nombre++] = niveau.positions[j];
+			}
+		}
+	}
+
+	if(!livre_ecrire(options.sortie, &entete, entrees)) {
+		exit(EXIT_FAILURE);
+	}
+	printf("%dx%d alignement %d : %lu positions jusqu'à %d pions, %.1f s\n",
+			options.config.longueur, options.config.largeur, options.config.alignement,
+			(unsigned long) entete.nombre, entete.profondeur, horloge_secondes() - debut);
+
+	for(i = 0; i < options.threads; i++) {
+		libererGrille(travaux[i].grille);
+		libererJoueur(travaux[i].joueurs[0]);
+		libererJoueur(travaux[i].joueurs[1]);
+		free(travaux[i].suivantes);
+	}
+	free(travaux);
+	free(niveau.positions);
+	free(entrees);
+
+	return EXIT_SUCCESS;
+}
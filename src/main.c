@@ -10,10 +10,13 @@
 
 #include "morpion.h"
 #include "user_interface.h"
+#include "archive.h"
 /**
  * \fn int main(int argc, char* argv[])
  * \brief Point d'entrée pour le jeu morpion.
  *
+ * Si MORPION_ARCHIVE est défini, la partie est ajoutée à cette archive.
+ *
  * \param argc Nombre d'arguments de la commande.
  * \param argv Tableau des arguments.
  *
@@ -21,18 +24,23 @@
  */
 int main(int argc, char* argv[]) {
 	Morpion morpion;
+	char* archive = getenv("MORPION_ARCHIVE");
 
 	srand ( time(NULL) );
 
-	morpion.grille = NULL;
-	morpion.config = morpion_config_parse_options(argc, argv);
-	morpion.ui     = text_interface_create();
+	morpion.grille  = NULL;
+	morpion.config  = morpion_config_parse_options(argc, argv);
+	morpion.ui      = text_interface_create();
+	morpion.archive = archive != NULL ? archive_ouvrir(archive) : NULL;
 
 	morpion_reset_grille(&morpion);
 	morpion_add_players(&morpion);
 	morpion_play(&morpion);
 
 	morpion_free_resources(&morpion);
+	if(morpion.archive != NULL) {
+		archive_fermer(morpion.archive);
+	}
 
 	return EXIT_SUCCESS;
 }
@@ -0,0 +1,359 @@
+/**
+ * \file mcts.c
+ * \brief Stratégie Monte Carlo Tree Search (UCT) sur plusieurs threads.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ *
+ * La parallélisation se fait à la racine : chaque thread construit son
+ * propre arbre sur sa propre copie de la grille, avec son propre générateur
+ * aléatoire. Les threads ne partagent rien pendant la recherche, les visites
+ * des coups de la racine sont additionnées à la fin et le coup le plus
+ * visité est joué.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "strategies.h"
+#include "horloge.h"
+
+#define MCTS_NOEUDS_MAX   (1 << 18) /**< Nombre maximal de noeuds par arbre. */
+#define MCTS_VOISINAGE    1         /**< Distance maximale d'un coup développé à un pion. */
+#define MCTS_EXPLORATION  1.0       /**< Constante d'exploration de UCT. */
+#define MCTS_THREADS_MAX  64        /**< Nombre maximal de threads. */
+
+/**
+ * \struct NoeudMCTS
+ * \brief Noeud de l'arbre de recherche.
+ *
+ * Les enfants d'un noeud sont contigus dans le tableau de noeuds de l'arbre.
+ * Les gains sont comptés pour le joueur qui a joué le coup menant au noeud.
+ */
+typedef struct NoeudMCTS {
+	int coup;           /*!< Indice de la case jouée pour arriver au noeud. */
+	int premier_enfant; /*!< Indice du premier enfant, -1 si non développé. */
+	int nb_enfants;     /*!< Nombre d'enfants. */
+	int visites;        /*!< Nombre de simulations passées par le noeud. */
+	double gains;       /*!< Somme des résultats (1 victoire, 0.5 nulle). */
+} NoeudMCTS;
+
+/**
+ * \struct ArbreMCTS
+ * \brief Arbre et état de recherche d'un thread.
+ */
+typedef struct ArbreMCTS {
+	pthread_t thread;      /*!< Thread qui construit l'arbre. */
+	Grille* grille;        /*!< Copie de la grille propre au thread. */
+	int joueurs[2];        /*!< Identifiants : 0 pour nous, 1 pour l'adversaire. */
+	NoeudMCTS* noeuds;     /*!< Noeuds de l'arbre, la racine est le noeud 0. */
+	int nb_noeuds;         /*!< Nombre de noeuds utilisés. */
+	int* chemin;           /*!< Noeuds parcourus pendant une simulation. */
+	int* coups_joues;      /*!< Cases jouées pendant une simulation, pour les retirer. */
+	Alea alea;             /*!< Générateur aléatoire du thread. */
+	double echeance;       /*!< Heure à laquelle la recherche doit s'arrêter. */
+	long iterations_max;   /*!< Nombre maximal de simulations, 0 sans limite. */
+	long iterations;       /*!< Nombre de simulations faites. */
+} ArbreMCTS;
+
+/**
+ * \fn static void mcts_developper(ArbreMCTS* arbre, int noeud)
+ * \brief Crée les enfants d'un noeud, un par case vide proche d'un pion.
+ *
+ * Sur une grille vide, le seul enfant est la case centrale. Si l'arbre est
+ * plein, le noeud reste une feuille.
+ *
+ * \param arbre Arbre du thread.
+ * \param noeud Noeud à développer, correspondant à la position de la grille.
+ */
+static void mcts_developper(ArbreMCTS* arbre, int noeud) {
+	Grille* grille = arbre->grille;
+	int premier = arbre->nb_noeuds;
+	int rang, indice;
+
+	if(arbre->nb_noeuds + grille->libres > MCTS_NOEUDS_MAX) {
+		return;
+	}
+
+	if(grille->libres == grille->longueur * grille->largeur) {
+		NoeudMCTS* enfant = &arbre->noeuds[arbre->nb_noeuds++];
+		enfant->coup = (grille->largeur / 2) * grille->longueur + grille->longueur / 2;
+		enfant->premier_enfant = -1;
+		enfant->nb_enfants = 0;
+		enfant->visites = 0;
+		enfant->gains = 0;
+	}
+
+	for(rang = 0; (indice = grille_candidat(grille, rang)) >= 0; rang++) {
+		NoeudMCTS* enfant = &arbre->noeuds[arbre->nb_noeuds++];
+		enfant->coup = indice;
+		enfant->premier_enfant = -1;
+		enfant->nb_enfants = 0;
+		enfant->visites = 0;
+		enfant->gains = 0;
+	}
+
+	if(arbre->nb_noeuds > premier) {
+		arbre->noeuds[noeud].premier_enfant = premier;
+		arbre->noeuds[noeud].nb_enfants = arbre->nb_noeuds - premier;
+	}
+}
+
+/**
+ * \fn static int mcts_selectionner(ArbreMCTS* arbre, int noeud)
+ * \brief Choisit l'enfant à explorer selon UCT.
+ *
+ * Un enfant jamais visité est toujours choisi en premier.
+ *
+ * \param arbre Arbre du thread.
+ * \param noeud Noeud développé.
+ * \return L'indice de l'enfant choisi.
+ */
+static int mcts_selectionner(ArbreMCTS* arbre, int noeud) {
+	NoeudMCTS* parent = &arbre->noeuds[noeud];
+	double log_visites = log((double) parent->visites + 1);
+	double meilleure_valeur = -1;
+	int meilleur = parent->premier_enfant;
+	int i;
+
+	for(i = parent->premier_enfant; i < parent->premier_enfant + parent->nb_enfants; i++) {
+		NoeudMCTS* enfant = &arbre->noeuds[i];
+		double valeur;
+
+		if(enfant->visites == 0) {
+			return i;
+		}
+
+		valeur = enfant->gains / enfant->visites
+			+ MCTS_EXPLORATION * sqrt(log_visites / enfant->visites);
+		if(valeur > meilleure_valeur) {
+			meilleure_valeur = valeur;
+			meilleur = i;
+		}
+	}
+
+	return meilleur;
+}
+
+/**
+ * \fn static int mcts_jouer(ArbreMCTS* arbre, int* nb_coups, int coup, int J)
+ * \brief Joue un coup sur la grille du thread et vérifie s'il gagne.
+ *
+ * \return 1 si le coup fait gagner le joueur J, 0 sinon.
+ */
+static int mcts_jouer(ArbreMCTS* arbre, int* nb_coups, int coup, int J) {
+	Grille* grille = arbre->grille;
+	int x = coup % grille->longueur;
+	int y = coup / grille->longueur;
+
+	placerPion(grille, J, x, y);
+	arbre->coups_joues[(*nb_coups)++] = coup;
+
+	return alignePion(grille, x, y, grille->alignement);
+}
+
+/**
+ * \fn static void mcts_iteration(ArbreMCTS* arbre)
+ * \brief Fait une simulation : sélection, développement, partie aléatoire, rétro-propagation.
+ *
+ * \param arbre Arbre du thread.
+ */
+static void mcts_iteration(ArbreMCTS* arbre) {
+	Grille* grille = arbre->grille;
+	int profondeur = 0;
+	int nb_coups = 0;
+	int noeud = 0;
+	int cote = 0;
+	int gagnant = 0;
+	int coups_arbre;
+	int i;
+
+	arbre->chemin[profondeur++] = noeud;
+
+	/* Sélection et développement. */
+	while(!estPleineGrille(grille)) {
+		if(arbre->noeuds[noeud].premier_enfant < 0) {
+			if(arbre->noeuds[noeud].visites == 0 && noeud != 0) {
+				break;
+			}
+			mcts_developper(arbre, noeud);
+			if(arbre->noeuds[noeud].premier_enfant < 0) {
+				break;
+			}
+		}
+
+		noeud = mcts_selectionner(arbre, noeud);
+		arbre->chemin[profondeur++] = noeud;
+		if(mcts_jouer(arbre, &nb_coups, arbre->noeuds[noeud].coup, arbre->joueurs[cote])) {
+			gagnant = arbre->joueurs[cote];
+			break;
+		}
+		cote = 1 - cote;
+	}
+
+	/* Partie aléatoire jusqu'à la fin, sans tenir à jour les candidats. */
+	coups_arbre = nb_coups;
+	grille->candidats_suspendus = 1;
+	while(gagnant == 0 && !estPleineGrille(grille)) {
+		int coup = grille_case_libre_aleatoire(grille, &arbre->alea);
+
+		if(mcts_jouer(arbre, &nb_coups, coup, arbre->joueurs[cote])) {
+			gagnant = arbre->joueurs[cote];
+		}
+		cote = 1 - cote;
+	}
+
+	/* Le noeud i du chemin a été atteint par un coup du joueur (i-1) % 2. */
+	for(i = 0; i < profondeur; i++) {
+		NoeudMCTS* n = &arbre->noeuds[arbre->chemin[i]];
+		n->visites += 1;
+		if(i > 0) {
+			int auteur = arbre->joueurs[(i - 1) % 2];
+			n->gains += gagnant == auteur ? 1.0 : gagnant == 0 ? 0.5 : 0.0;
+		}
+	}
+
+	while(nb_coups > 0) {
+		int coup;
+
+		if(nb_coups == coups_arbre) {
+			grille->candidats_suspendus = 0;
+		}
+		coup = arbre->coups_joues[--nb_coups];
+		retirerPion(grille, coup % grille->longueur, coup / grille->longueur);
+	}
+	grille->candidats_suspendus = 0;
+
+	arbre->iterations += 1;
+}
+
+/**
+ * \fn static void* mcts_thread(void* argument)
+ * \brief Construit l'arbre d'un thread jusqu'au budget.
+ *
+ * \param argument L'ArbreMCTS du thread.
+ * \return NULL.
+ */
+static void* mcts_thread(void* argument) {
+	ArbreMCTS* arbre = (ArbreMCTS*) argument;
+
+	do {
+		mcts_iteration(arbre);
+	} while((arbre->iterations_max == 0 || arbre->iterations < arbre->iterations_max)
+			&& (arbre->echeance == 0 || horloge_secondes() < arbre->echeance));
+
+	return NULL;
+}
+
+/**
+ * \fn void strategie_mcts(Joueur* joueur, Grille* grille, int* x, int* y)
+ * \brief Stratégie Monte Carlo Tree Search (UCT), parallélisée à la racine.
+ *
+ * Dans la solution exacte ou le livre d'ouvertures, leur coup est joué sans
+ * recherche. Sinon la recherche s'arrête à l'échéance Joueur::budget_ms ou
+ * après Joueur::budget_iterations simulations réparties entre les threads,
+ * au premier des deux atteint. Sans aucun budget, une seule simulation par
+ * thread est faite. Joueur::nb_threads à 0 utilise un thread par coeur.
+ *
+ * \param joueur Joueur qui a la stratégie.
+ * \param grille Grille sur laquelle il faut jouer.
+ * \param x Pointeur pour sauver la position x de la case choisie.
+ * \param y Pointeur pour sauver la position y de la case choisie.
+ */
+void strategie_mcts(Joueur* joueur, Grille* grille, int* x, int* y) {
+	int cases = grille->longueur * grille->largeur;
+	int nb_threads = joueur->nb_threads > 0 ? joueur->nb_threads : sysconf(_SC_NPROCESSORS_ONLN);
+	double echeance = joueur->budget_ms > 0 ? horloge_secondes() + joueur->budget_ms / 1000.0 : 0;
+	int adversaire = strategie_adversaire(grille, joueur->id);
+	ArbreMCTS arbres[MCTS_THREADS_MAX];
+	long* visites;
+	int meilleur_coup = -1;
+	int t, i;
+
+	if(strategie_coup_connu(joueur, grille, x, y)) {
+		return;
+	}
+	if(nb_threads < 1) {
+		nb_threads = 1;
+	}
+	if(nb_threads > MCTS_THREADS_MAX) {
+		nb_threads = MCTS_THREADS_MAX;
+	}
+
+	visites = (long*) calloc(cases, sizeof(long));
+	if(visites == NULL) {
+		perror("Impossible d'allouer les visites de la recherche MCTS.");
+		exit(EXIT_FAILURE);
+	}
+
+	for(t = 0; t < nb_threads; t++) {
+		ArbreMCTS* arbre = &arbres[t];
+
+		arbre->grille      = copierGrille(grille);
+		arbre->joueurs[0]  = joueur->id;
+		arbre->joueurs[1]  = adversaire;
+		arbre->noeuds      = (NoeudMCTS*) malloc(sizeof(NoeudMCTS) * MCTS_NOEUDS_MAX);
+		arbre->chemin      = (int*) malloc(sizeof(int) * (cases + 1));
+		arbre->coups_joues = (int*) malloc(sizeof(int) * (cases + 1));
+		if(arbre->grille == NULL || arbre->noeuds == NULL || arbre->chemin == NULL || arbre->coups_joues == NULL) {
+			perror("Impossible d'allouer un arbre de recherche MCTS.");
+			exit(EXIT_FAILURE);
+		}
+		grille_suivre_candidats(arbre->grille, MCTS_VOISINAGE);
+
+		arbre->nb_noeuds = 1;
+		arbre->noeuds[0].coup = -1;
+		arbre->noeuds[0].premier_enfant = -1;
+		arbre->noeuds[0].nb_enfants = 0;
+		arbre->noeuds[0].visites = 0;
+		arbre->noeuds[0].gains = 0;
+
+		alea_init(&arbre->alea, ((uint64_t) alea_suivant(&joueur->alea) << 32) | t);
+		arbre->echeance       = echeance;
+		arbre->iterations_max = joueur->budget_iterations > 0
+				? (joueur->budget_iterations + nb_threads - 1) / nb_threads : 0;
+		if(echeance == 0 && arbre->iterations_max == 0) {
+			arbre->iterations_max = 1;
+		}
+		arbre->iterations = 0;
+
+		if(pthread_create(&arbre->thread, NULL, mcts_thread, arbre) != 0) {
+			perror("Impossible de créer un thread MCTS.");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	for(t = 0; t < nb_threads; t++) {
+		ArbreMCTS* arbre = &arbres[t];
+		NoeudMCTS* racine;
+
+		pthread_join(arbre->thread, NULL);
+
+		racine = &arbre->noeuds[0];
+		for(i = racine->premier_enfant; racine->premier_enfant >= 0 && i < racine->premier_enfant + racine->nb_enfants; i++) {
+			visites[arbre->noeuds[i].coup] += arbre->noeuds[i].visites;
+		}
+
+		libererGrille(arbre->grille);
+		free(arbre->noeuds);
+		free(arbre->chemin);
+		free(arbre->coups_joues);
+	}
+
+	for(i = 0; i < cases; i++) {
+		if(GRILLE_OCTET(grille, i % grille->longueur, i / grille->longueur) == 0
+				&& (meilleur_coup < 0 || visites[i] > visites[meilleur_coup])) {
+			meilleur_coup = i;
+		}
+	}
+	free(visites);
+
+	*x = meilleur_coup % grille->longueur;
+	*y = meilleur_coup / grille->longueur;
+
+	placerPion(grille, joueur->id, *x, *y);
+}
@@ -16,6 +16,7 @@
 #include "lib.h"
 #include "grille.h"
 #include "joueur.h"
+#include "archive.h"
 
 /**
  * \fn MorpionConfig morpion_config_parse_options (int argc, char* argv[])
@@ -72,19 +73,29 @@ MorpionConfig morpion_config_parse_options(int argc, char* argv[]) {
 
 /**
  * \fn void morpion_reset_grille(Morpion* morpion)
- * \brief Réalloue la grille dans les dimensions précisés par la configuration.
+ * \brief Remet à zéro la grille dans les dimensions précisés par la configuration.
  *
- * \param morpion Morpion dont la grille doit être réallouée.
+ * Une grille qui a déjà ces dimensions est vidée sur place par
+ * ::grille_vider, sans rien réallouer ; sinon elle est réallouée.
+ *
+ * \param morpion Morpion dont la grille doit être remise à zéro.
  */
 void morpion_reset_grille(Morpion* morpion) {
-	if(morpion->grille != NULL) {
-		libererGrille(morpion->grille);
+	Grille* grille = morpion->grille;
+
+	if(grille != NULL && grille->longueur == morpion->config.longueur
+			&& grille->largeur == morpion->config.largeur) {
+		grille_vider(grille);
+	} else {
+		if(grille != NULL) {
+			libererGrille(grille);
+		}
+		morpion->grille = initGrille(
+			morpion->config.longueur,
+			morpion->config.largeur
+		);
 	}
-
-	morpion->grille = initGrille(
-		morpion->config.longueur,
-		morpion->config.largeur
-	);
+	morpion->grille->alignement = morpion->config.alignement;
 }
 
 /**
@@ -113,7 +124,7 @@ void morpion_add_players(Morpion* morpion) {
 }
 
 /**
- * \fn void morpion_play(Morpion* morpion)
+ * \fn int morpion_play(Morpion* morpion)
  * \brief Lance la boucle de jeu.
  *
  * Boucle de jeu :
@@ -125,9 +136,29 @@ void morpion_add_players(Morpion* morpion) {
  * - Vérifier si le nouveau pion est dans un alignement (si oui on arrête le jeu).
  * - On passe au joueur suivant.
  *
+ * La partie est ajoutée à l'archive du morpion s'il en a une.
+ *
  * \param morpion Morpion à jouer.
+ * \return L'identifiant du gagnant, 0 si la partie est nulle.
  */
-void morpion_play(Morpion* morpion) {
+int morpion_play(Morpion* morpion) {
+	int joueurs[ARCHIVE_MAX_JOUEURS];
+	int nb_joueurs = 0;
+	int* cases = NULL;
+	int nb_coups = 0;
+	int gagnant = 0;
+
+	if(morpion->archive != NULL) {
+		ListeJoueurs* element = morpion->liste_joueurs;
+		do {
+			if(nb_joueurs < ARCHIVE_MAX_JOUEURS) {
+				joueurs[nb_joueurs] = element->joueur->id;
+			}
+			nb_joueurs++;
+			element = element->suivant;
+		} while(element != morpion->liste_joueurs);
+		cases = (int*) malloc(sizeof(int) * morpion->grille->longueur * morpion->grille->largeur);
+	}
 
 	morpion->ui.update_grille(morpion->grille);
 
@@ -139,57 +170,22 @@ void morpion_play(Morpion* morpion) {
 		joueur_actuel->place(joueur_actuel, morpion->grille, &x, &y);
 		morpion->ui.log("Le joueur %d a placé en (%d, %d).\n", joueur_actuel->id, x, y);
 		morpion->ui.update_grille(morpion->grille);
+		if(cases != NULL) {
+			cases[nb_coups++] = y * morpion->grille->longueur + x;
+		}
 		if(alignePion(morpion->grille, x, y, morpion->config.alignement)) {
 			morpion->ui.log("Le joueur %d a gagné !\n", joueur_actuel->id);
+			gagnant = joueur_actuel->id;
 			break;
 		}
 
 		morpion->liste_joueurs = morpion->liste_joueurs->suivant;
 	} while(!estPleineGrille(morpion->grille));
 
-}
-
-/**
- * \fn char* morpion_config_serialize(MorpionConfig config)
- * \brief Sérialise une MorpionConfig.
- *
- * Cette fonction doit être utilisé pour récupérer une chaine d'octets à envoyer
- * sur le réseau.
- *
- * \param config La MorpionConfig à sérialiser.
- *
- * \warning Il FAUT free cette serialisation !!
- * \warning Cette sérialisation est dépendante de l'endianness de l'architecture.
- *
- * \todo Faire une implémentation indépendante de l'endianness.
- *
- * \return Pointeur vers la suite d'octets sérialisés.
- */
-char* morpion_config_serialize(MorpionConfig config) {
-	char* buffer = (char*) malloc(sizeof(MorpionConfig));
-	if(buffer == NULL) {
-		perror("Impossible d'allouer une suite d'octets pour la sérialisation.");
-		exit(EXIT_FAILURE);
+	if(cases != NULL) {
+		archive_ajouter(morpion->archive, morpion->config, joueurs, nb_joueurs, gagnant, cases, nb_coups);
+		free(cases);
 	}
-	*( (int*) (buffer + (0 * sizeof(int))) ) = config.longueur;
-	*( (int*) (buffer + (1 * sizeof(int))) ) = config.largeur;
-	*( (int*) (buffer + (2 * sizeof(int))) ) = config.alignement;
 
-	return buffer;
-}
-
-/**
- * \fn MorpionConfig morpion_config_deserialize(char* serialized)
- * \brief Désérialise un MorpionConfig.
- *
- * \param serialized Suite d'octets à désérialiser.
- * \return MorpionConfig issu de la désérialisation.
- */
-MorpionConfig morpion_config_deserialize(char* serialized) {
-	MorpionConfig config;
-	config.longueur   = *( (int*) serialized);
-	config.largeur    = *( (int*) ( serialized + sizeof(int) ) );
-	config.alignement = *( (int*) ( serialized + 2 * sizeof(int) ) );
-
-	return config;
+	return gagnant;
 }
@@ -0,0 +1,343 @@
+/**
+ * \file parties.c
+ * \brief Table des parties hébergées par un serveur.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "parties.h"
+#include "alea.h"
+
+/** Marque les cases des parties supprimées. */
+static Partie parties_supprimee;
+
+/**
+ * \fn static int parties_case(TableParties* table, int id)
+ * \brief Première case à sonder pour un identifiant.
+ */
+static int parties_case(TableParties* table, int id) {
+	return (int) (alea_melanger((uint64_t) id) & (uint64_t) table->masque);
+}
+
+/**
+ * \fn static Partie** parties_allouer_cases(int nombre)
+ * \brief Alloue des cases vides.
+ */
+static Partie** parties_allouer_cases(int nombre) {
+	Partie** cases = (Partie**) calloc(nombre, sizeof(Partie*));
+	if(cases == NULL) {
+		perror("Impossible d'allouer la table des parties.");
+		exit(EXIT_FAILURE);
+	}
+	return cases;
+}
+
+/**
+ * \fn static void parties_redimensionner(TableParties* table)
+ * \brief Range à nouveau les parties, dans une table plus grande si besoin.
+ *
+ * Les cases des parties supprimées disparaissent.
+ */
+static void parties_redimensionner(TableParties* table) {
+	Partie** anciennes = table->cases;
+	int ancien_nombre = table->masque + 1;
+	int nombre = ancien_nombre;
+	int i;
+
+	while(table->nombre * 2 >= nombre) {
+		nombre *= 2;
+	}
+
+	table->cases    = parties_allouer_cases(nombre);
+	table->masque   = nombre - 1;
+	table->occupees = table->nombre;
+
+	for(i = 0; i < ancien_nombre; i++) {
+		if(anciennes[i] != NULL && anciennes[i] != &parties_supprimee) {
+			int c = parties_case(table, anciennes[i]->id);
+			while(table->cases[c] != NULL) {
+				c = (c + 1) & table->masque;
+			}
+			table->cases[c] = anciennes[i];
+		}
+	}
+
+	free(anciennes);
+}
+
+/**
+ * \fn TableParties* parties_creer(MorpionConfig config)
+ * \brief Alloue une table de parties vide.
+ *
+ * \param config Configuration des parties créées dans la table.
+ * \return La table, NULL en cas d'échec.
+ */
+TableParties* parties_creer(MorpionConfig config) {
+	TableParties* table = (TableParties*) malloc(sizeof(TableParties));
+	if(table == NULL) {
+		perror("Impossible d'allouer la table des parties.");
+		return NULL;
+	}
+
+	table->cases       = parties_allouer_cases(PARTIES_TAILLE_INITIALE);
+	table->masque      = PARTIES_TAILLE_INITIALE - 1;
+	table->nombre      = 0;
+	table->occupees    = 0;
+	table->prochain_id = 1;
+	table->config      = config;
+
+	return table;
+}
+
+/**
+ * \fn static void parties_liberer_partie(Partie* partie)
+ * \brief Libère une partie, sa grille et ses joueurs.
+ */
+static void parties_liberer_partie(Partie* partie) {
+	morpion_free_resources(&partie->morpion);
+	free(partie->journal);
+	free(partie);
+}
+
+/**
+ * \fn void parties_liberer(TableParties* table)
+ * \brief Libère une table et toutes ses parties.
+ *
+ * \param table Table à libérer.
+ */
+void parties_liberer(TableParties* table) {
+	int i;
+
+	for(i = 0; i <= table->masque; i++) {
+		if(table->cases[i] != NULL && table->cases[i] != &parties_supprimee) {
+			parties_liberer_partie(table->cases[i]);
+		}
+	}
+	free(table->cases);
+	free(table);
+}
+
+/**
+ * \fn Partie* parties_chercher(TableParties* table, int id)
+ * \brief Cherche une partie par son identifiant.
+ *
+ * \param table Table des parties.
+ * \param id Identifiant de la partie.
+ * \return La partie, NULL si elle n'existe pas.
+ */
+Partie* parties_chercher(TableParties* table, int id) {
+	int c = parties_case(table, id);
+
+	while(table->cases[c] != NULL) {
+		if(table->cases[c] != &parties_supprimee && table->cases[c]->id == id) {
+			return table->cases[c];
+		}
+		c = (c + 1) & table->masque;
+	}
+
+	return NULL;
+}
+
+/**
+ * \fn Partie* parties_creer_partie(TableParties* table, int id)
+ * \brief Crée une nouvelle partie, sans joueur, dans la table.
+ *
+ * \param table Table des parties.
+ * \param id Identifiant voulu, 0 pour le premier identifiant libre.
+ * \return La partie, NULL si l'identifiant est déjà pris ou invalide.
+ */
+Partie* parties_creer_partie(TableParties* table, int id) {
+	Partie* partie;
+	int c;
+
+	if(id < 0 || (id > 0 && parties_chercher(table, id) != NULL)) {
+		return NULL;
+	}
+	if(id == 0) {
+		while(parties_chercher(table, table->prochain_id) != NULL) {
+			table->prochain_id = table->prochain_id % 0x7FFFFFFF + 1;
+		}
+		id = table->prochain_id;
+		table->prochain_id = table->prochain_id % 0x7FFFFFFF + 1;
+	}
+
+	if((table->occupees + 1) * 4 > (table->masque + 1) * 3) {
+		parties_redimensionner(table);
+	}
+
+	partie = (Partie*) malloc(sizeof(Partie));
+	if(partie == NULL) {
+		perror("Impossible d'allouer une partie.");
+		return NULL;
+	}
+	partie->journal = (int*) malloc(sizeof(int) * 2 * table->config.longueur * table->config.largeur);
+	if(partie->journal == NULL) {
+		perror("Impossible d'allouer le journal d'une partie.");
+		free(partie);
+		return NULL;
+	}
+	partie->id                    = id;
+	partie->nb_joueurs            = 0;
+	partie->presents              = 0;
+	partie->version               = 0;
+	partie->morpion.grille        = NULL;
+	partie->morpion.config        = table->config;
+	partie->morpion.ui            = null_interface_create();
+	partie->morpion.archive       = NULL;
+	partie->morpion.liste_joueurs = NULL;
+	morpion_reset_grille(&partie->morpion);
+
+	c = parties_case(table, id);
+	while(table->cases[c] != NULL && table->cases[c] != &parties_supprimee) {
+		c = (c + 1) & table->masque;
+	}
+	if(table->cases[c] == NULL) {
+		table->occupees += 1;
+	}
+	table->cases[c] = partie;
+	table->nombre  += 1;
+
+	return partie;
+}
+
+/**
+ * \fn void parties_supprimer(TableParties* table, int id)
+ * \brief Retire une partie de la table et la libère.
+ *
+ * \param table Table des parties.
+ * \param id Identifiant de la partie.
+ */
+void parties_supprimer(TableParties* table, int id) {
+	int c = parties_case(table, id);
+
+	while(table->cases[c] != NULL) {
+		if(table->cases[c] != &parties_supprimee && table->cases[c]->id == id) {
+			parties_liberer_partie(table->cases[c]);
+			table->cases[c] = &parties_supprimee;
+			table->nombre  -= 1;
+			return;
+		}
+		c = (c + 1) & table->masque;
+	}
+}
+
+/**
+ * \fn int parties_ajouter_joueur(Partie* partie)
+ * \brief Ajoute un joueur humain à une partie.
+ *
+ * Les identifiants ne sont jamais réutilisés, et ceux au delà de
+ * ::GRILLE_JOUEUR_MAX ne peuvent pas placer de pion : une partie qui en a
+ * déjà donné autant refuse les nouveaux joueurs.
+ *
+ * \param partie La partie.
+ * \return L'identifiant du nouveau joueur, 0 si la partie est complète.
+ */
+int parties_ajouter_joueur(Partie* partie) {
+	Joueur* joueur;
+
+	if(partie->nb_joueurs >= GRILLE_JOUEUR_MAX) {
+		return 0;
+	}
+	partie->nb_joueurs += 1;
+	partie->presents   += 1;
+	joueur = creerJoueurHumain(partie->nb_joueurs);
+
+	if(partie->morpion.liste_joueurs == NULL) {
+		partie->morpion.liste_joueurs = joueurs_creer_liste(joueur);
+	} else {
+		joueurs_place_suivant(partie->morpion.liste_joueurs, joueur);
+	}
+
+	return joueur->id;
+}
+
+/**
+ * \fn int parties_retirer_joueur(Partie* partie, int joueur_id)
+ * \brief Retire un joueur d'une partie.
+ *
+ * Si c'était à lui de jouer, le tour passe au joueur suivant.
+ *
+ * \param partie La partie.
+ * \param joueur_id Identifiant du joueur qui quitte la partie.
+ * \return 1 si le joueur a été retiré, 0 s'il n'était pas dans la partie.
+ */
+int parties_retirer_joueur(Partie* partie, int joueur_id) {
+	ListeJoueurs* tete = partie->morpion.liste_joueurs;
+	ListeJoueurs* precedent = tete;
+	ListeJoueurs* element;
+
+	if(tete == NULL) {
+		return 0;
+	}
+
+	do {
+		element = precedent->suivant;
+		if(element->joueur->id == joueur_id) {
+			if(element == precedent) {
+				partie->morpion.liste_joueurs = NULL;
+			} else {
+				precedent->suivant = element->suivant;
+				if(element == tete) {
+					partie->morpion.liste_joueurs = element->suivant;
+				}
+			}
+			libererJoueur(element->joueur);
+			joueurs_liberer_element(element);
+			partie->presents -= 1;
+			return 1;
+		}
+		precedent = element;
+	} while(precedent != tete);
+
+	return 0;
+}
+
+/**
+ * \fn int parties_joueur_courant(Partie* partie)
+ * \brief Identifiant du joueur qui doit jouer.
+ *
+ * \param partie La partie.
+ * \return L'identifiant du joueur, 0 si la partie attend encore des joueurs.
+ */
+int parties_joueur_courant(Partie* partie) {
+	if(partie->morpion.liste_joueurs == NULL
+			|| partie->morpion.liste_joueurs->suivant == partie->morpion.liste_joueurs) {
+		return 0;
+	}
+	return partie->morpion.liste_joueurs->joueur->id;
+}
+
+/**
+ * \fn int parties_jouer(Partie* partie, int joueur_id, int x, int y)
+ * \brief Joue un coup s'il est valide.
+ *
+ * Le pion est placé si c'est le tour du joueur et que la case est libre ; le
+ * coup entre alors dans le journal et le tour passe au joueur suivant.
+ *
+ * \param partie La partie.
+ * \param joueur_id Identifiant du joueur qui joue.
+ * \param x Position x de la case.
+ * \param y Position y de la case.
+ * \return 1 si le coup a été joué, 0 s'il est refusé.
+ */
+int parties_jouer(Partie* partie, int joueur_id, int x, int y) {
+	Grille* grille = partie->morpion.grille;
+
+	if(joueur_id == 0 || joueur_id != parties_joueur_courant(partie)) {
+		return 0;
+	}
+	if(!placerPion(grille, joueur_id, x, y)) {
+		return 0;
+	}
+
+	partie->journal[2 * partie->version]     = joueur_id;
+	partie->journal[2 * partie->version + 1] = y * grille->longueur + x;
+	partie->version += 1;
+	partie->morpion.liste_joueurs = partie->morpion.liste_joueurs->suivant;
+
+	return 1;
+}
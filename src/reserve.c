@@ -0,0 +1,73 @@
+/**
+ * \file reserve.c
+ * \brief Réserve d'objets de même taille, recyclés sans passer par malloc.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "reserve.h"
+
+/**
+ * \union AlignementReserve
+ * \brief Types dont les objets d'une réserve respectent l'alignement.
+ */
+typedef union AlignementReserve {
+	void* pointeur;
+	long entier;
+	double reel;
+} AlignementReserve;
+
+/**
+ * \fn void* reserve_prendre(Reserve* reserve)
+ * \brief Prend un objet de la réserve.
+ *
+ * Si la réserve est vide, un bloc de ::RESERVE_PAR_BLOC objets est alloué.
+ * Le contenu de l'objet est indéfini.
+ *
+ * \param reserve La réserve.
+ * \return L'objet, NULL si l'allocation d'un bloc échoue.
+ */
+void* reserve_prendre(Reserve* reserve) {
+	void* objet;
+
+	pthread_mutex_lock(&reserve->verrou);
+	if(reserve->libres == NULL) {
+		size_t taille = (reserve->taille + sizeof(AlignementReserve) - 1)
+				/ sizeof(AlignementReserve) * sizeof(AlignementReserve);
+		char* bloc = (char*) malloc(taille * RESERVE_PAR_BLOC);
+		int i;
+
+		if(bloc == NULL) {
+			pthread_mutex_unlock(&reserve->verrou);
+			perror("Impossible d'allouer un bloc de la réserve.");
+			return NULL;
+		}
+		for(i = RESERVE_PAR_BLOC - 1; i >= 0; i--) {
+			*(void**) (bloc + i * taille) = reserve->libres;
+			reserve->libres = bloc + i * taille;
+		}
+	}
+	objet = reserve->libres;
+	reserve->libres = *(void**) objet;
+	pthread_mutex_unlock(&reserve->verrou);
+
+	return objet;
+}
+
+/**
+ * \fn void reserve_rendre(Reserve* reserve, void* objet)
+ * \brief Rend un objet pris par ::reserve_prendre.
+ *
+ * \param reserve La réserve d'où vient l'objet.
+ * \param objet L'objet, qui ne doit plus être utilisé.
+ */
+void reserve_rendre(Reserve* reserve, void* objet) {
+	pthread_mutex_lock(&reserve->verrou);
+	*(void**) objet = reserve->libres;
+	reserve->libres = objet;
+	pthread_mutex_unlock(&reserve->verrou);
+}
@@ -0,0 +1,345 @@
+/**
+ * \file selfplay.c
+ * \brief Fait jouer des parties entre stratégies sur plusieurs threads.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ *
+ * Chaque thread a son propre Morpion (grille et joueurs) et ses propres
+ * générateurs aléatoires. Les threads ne partagent rien pendant les parties,
+ * leurs résultats sont additionnés à la fin.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "morpion.h"
+#include "horloge.h"
+#include "archive.h"
+
+#define SELFPLAY_MAX_JOUEURS 16 /**< Nombre maximal de joueurs par partie. */
+
+/**
+ * \struct SelfplayOptions
+ * \brief Options de la ligne de commande.
+ */
+typedef struct SelfplayOptions {
+	MorpionConfig config;                    /*!< Configuration des parties. */
+	long parties;                            /*!< Nombre total de parties. */
+	int threads;                             /*!< Nombre de threads. */
+	char* strategies[SELFPLAY_MAX_JOUEURS];  /*!< Stratégie de chaque joueur. */
+	int nb_strategies;                       /*!< Nombre de joueurs. */
+	unsigned long graine;                    /*!< Graine de la première partie. */
+	Archive* archive;                        /*!< Archive des parties, NULL sans archive. */
+} SelfplayOptions;
+
+/**
+ * \struct SelfplayTravail
+ * \brief Parties et résultats d'un thread.
+ */
+typedef struct SelfplayTravail {
+	pthread_t thread;                        /*!< Thread qui joue. */
+	Morpion morpion;                         /*!< Jeu propre au thread. */
+	int nb_joueurs;                          /*!< Nombre de joueurs. */
+	long parties;                            /*!< Parties à jouer. */
+	long premiere_partie;                    /*!< Numéro de la première partie du thread. */
+	uint64_t graine;                         /*!< Graine de la commande. */
+	long coups;                              /*!< Coups joués. */
+	long nulles;                             /*!< Parties sans gagnant. */
+	long victoires[SELFPLAY_MAX_JOUEURS];    /*!< Victoires par joueur. */
+} SelfplayTravail;
+
+/**
+ * \fn static void selfplay_usage(FILE* stream, int exit_code)
+ * \brief Affiche comment utiliser la commande.
+ *
+ * \param stream Le flux où écrire l'aide.
+ * \param exit_code Le code d'erreur à utiliser.
+ */
+static void selfplay_usage(FILE* stream, int exit_code) {
+	fprintf(stream, "Utilisation : selfplay options\n");
+	fprintf(stream,
+			" -n --parties n          Nombre total de parties (1000).\n"
+			" -t --threads n          Nombre de threads (nombre de coeurs).\n"
+			" -y --hauteur n          Fixe la hauteur du plateau à n cases.\n"
+			" -x --largeur n          Fixe la largeur du plateau à n cases.\n"
+	);
+	fprintf(stream,
+			" -a --alignement n       Fixe à n le nombre de pions à aligner pour gagner.\n"
+			" -s --strategies s,...   Stratégies des joueurs, dans l'ordre (random,defense).\n"
+			" -g --graine n           Graine des générateurs aléatoires (heure courante).\n"
+			" -r --archive fichier    Ajoute les parties jouées à cette archive.\n"
+			" -h --help               Affiche une aide et quitte le programme.\n"
+	);
+	exit(exit_code);
+}
+
+/**
+ * \fn static SelfplayOptions selfplay_parse_options(int argc, char* argv[])
+ * \brief Lit les options de la ligne de commande.
+ *
+ * \param argc Nombre d'arguments de la commande (du main).
+ * \param argv Tableau des chaines des arguments de la commande (du main).
+ * \return Les options.
+ */
+static SelfplayOptions selfplay_parse_options(int argc, char* argv[]) {
+	int next_option;
+	char* strategie;
+	const char* const short_options = "n:t:y:x:a:s:g:r:h";
+
+	const struct option long_options[] = {
+		{ "parties",    1, NULL, 'n' },
+		{ "threads",    1, NULL, 't' },
+		{ "hauteur",    1, NULL, 'y' },
+		{ "largeur",    1, NULL, 'x' },
+		{ "alignement", 1, NULL, 'a' },
+		{ "strategies", 1, NULL, 's' },
+		{ "graine",     1, NULL, 'g' },
+		{ "archive",    1, NULL, 'r' },
+		{ "help",       0, NULL, 'h' },
+		{ NULL,         0, NULL,   0 }
+	};
+
+	static char strategies_defaut[] = "random,defense";
+
+	SelfplayOptions options;
+	options.config.longueur   = MORPION_DEFAULT_LONGUEUR;
+	options.config.largeur    = MORPION_DEFAULT_LARGEUR;
+	options.config.alignement = MORPION_DEFAULT_ALIGNEMENT;
+	options.parties           = 1000;
+	options.threads           = sysconf(_SC_NPROCESSORS_ONLN);
+	options.graine            = time(NULL);
+	options.archive           = NULL;
+	strategie                 = strategies_defaut;
+
+	do {
+		next_option = getopt_long(argc, argv, short_options, long_options, NULL);
+
+		switch (next_option) {
+		case 'n':
+			options.parties = atol(optarg);
+			break;
+		case 't':
+			options.threads = atoi(optarg);
+			break;
+		case 'x':
+			options.config.longueur = atoi(optarg);
+			break;
+		case 'y':
+			options.config.largeur = atoi(optarg);
+			break;
+		case 'a':
+			options.config.alignement = atoi(optarg);
+			break;
+		case 's':
+			strategie = optarg;
+			break;
+		case 'g':
+			options.graine = strtoul(optarg, NULL, 10);
+			break;
+		case 'r':
+			options.archive = archive_ouvrir(optarg);
+			if(options.archive == NULL) {
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'h':
+			selfplay_usage(stdout, 0);
+			break;
+		case '?':
+			selfplay_usage(stderr, 1);
+			break;
+		case -1:
+			break;
+		default:
+			abort();
+		}
+	} while (next_option != -1);
+
+	options.nb_strategies = 0;
+	for(strategie = strtok(strategie, ","); strategie != NULL; strategie = strtok(NULL, ",")) {
+		if(options.nb_strategies < SELFPLAY_MAX_JOUEURS) {
+			options.strategies[options.nb_strategies++] = strategie;
+		}
+	}
+
+	if(options.nb_strategies == 0 || options.threads < 1) {
+		selfplay_usage(stderr, 1);
+	}
+
+	return options;
+}
+
+/**
+ * \fn static uint64_t selfplay_graine_joueur(uint64_t graine, long partie, int joueur)
+ * \brief Graine du générateur d'un joueur pour une partie.
+ *
+ * \param graine Graine de la commande.
+ * \param partie Numéro de la partie, de 0 au nombre total de parties.
+ * \param joueur Identifiant du joueur.
+ * \return La graine, différente pour chaque triplet.
+ */
+static uint64_t selfplay_graine_joueur(uint64_t graine, long partie, int joueur) {
+	return alea_melanger(alea_melanger(alea_melanger(graine) ^ (uint64_t) partie) ^ (uint64_t) joueur);
+}
+
+/**
+ * \fn static void selfplay_preparer(SelfplayOptions* options, SelfplayTravail* travail, int numero)
+ * \brief Crée le Morpion et les joueurs d'un thread.
+ *
+ * Les parties sont numérotées de 0 au nombre total de parties, les threads
+ * en jouent des tranches consécutives.
+ *
+ * \param options Options de la commande.
+ * \param travail Travail du thread à préparer.
+ * \param numero Numéro du thread.
+ */
+static void selfplay_preparer(SelfplayOptions* options, SelfplayTravail* travail, int numero) {
+	ListeJoueurs* dernier = NULL;
+	int i;
+
+	memset(travail, 0, sizeof(SelfplayTravail));
+	travail->morpion.grille  = NULL;
+	travail->morpion.config  = options->config;
+	travail->morpion.ui      = null_interface_create();
+	travail->morpion.archive = options->archive;
+	travail->nb_joueurs     = options->nb_strategies;
+	travail->parties        = options->parties / options->threads
+			+ (numero < options->parties % options->threads ? 1 : 0);
+	travail->premiere_partie = numero * (options->parties / options->threads)
+			+ (numero < options->parties % options->threads ? numero : options->parties % options->threads);
+	travail->graine         = options->graine;
+
+	for(i = 0; i < options->nb_strategies; i++) {
+		Joueur* joueur = creerJoueurParNom(options->strategies[i], i + 1);
+		if(joueur == NULL) {
+			fprintf(stderr, "Stratégie inconnue : %s\n", options->strategies[i]);
+			exit(EXIT_FAILURE);
+		}
+		if(i == 0) {
+			travail->morpion.liste_joueurs = dernier = joueurs_creer_liste(joueur);
+		} else {
+			joueurs_place_suivant(dernier, joueur);
+			dernier = dernier->suivant;
+		}
+	}
+}
+
+/**
+ * \fn static void* selfplay_thread(void* argument)
+ * \brief Joue les parties d'un thread.
+ *
+ * Le premier joueur change à chaque partie. Avant chaque partie, le
+ * générateur de chaque joueur est initialisé à partir de la graine, du numéro
+ * de la partie et de l'identifiant du joueur : une même graine et un même
+ * nombre de threads redonnent exactement les mêmes parties.
+ *
+ * \param argument Le SelfplayTravail du thread.
+ * \return NULL.
+ */
+static void* selfplay_thread(void* argument) {
+	SelfplayTravail* travail = (SelfplayTravail*) argument;
+	ListeJoueurs* premier = travail->morpion.liste_joueurs;
+	long partie;
+
+	for(partie = 0; partie < travail->parties; partie++) {
+		ListeJoueurs* element = premier;
+		int gagnant;
+
+		do {
+			alea_init(&element->joueur->alea, selfplay_graine_joueur(travail->graine,
+					travail->premiere_partie + partie, element->joueur->id));
+			element = element->suivant;
+		} while(element != premier);
+
+		morpion_reset_grille(&travail->morpion);
+		travail->morpion.liste_joueurs = premier;
+
+		gagnant = morpion_play(&travail->morpion);
+		travail->coups += travail->morpion.grille->longueur * travail->morpion.grille->largeur
+				- travail->morpion.grille->libres;
+
+		if(gagnant == 0) {
+			travail->nulles += 1;
+		} else {
+			travail->victoires[gagnant - 1] += 1;
+		}
+		premier = premier->suivant;
+	}
+
+	travail->morpion.liste_joueurs = premier;
+
+	return NULL;
+}
+
+/**
+ * \fn int main(int argc, char* argv[])
+ * \brief Point d'entrée du self-play multi-thread.
+ *
+ * \param argc Nombre d'arguments de la commande.
+ * \param argv Tableau des arguments.
+ *
+ * \return Code de sortie du programme.
+ */
+int main(int argc, char* argv[]) {
+	SelfplayOptions options = selfplay_parse_options(argc, argv);
+	SelfplayTravail* travaux;
+	SelfplayTravail total;
+	double debut, duree;
+	int i, j;
+
+	travaux = (SelfplayTravail*) malloc(sizeof(SelfplayTravail) * options.threads);
+	if(travaux == NULL) {
+		perror("Impossible d'allouer les travaux des threads.");
+		exit(EXIT_FAILURE);
+	}
+
+	for(i = 0; i < options.threads; i++) {
+		selfplay_preparer(&options, &travaux[i], i);
+	}
+
+	debut = horloge_secondes();
+	for(i = 0; i < options.threads; i++) {
+		if(pthread_create(&travaux[i].thread, NULL, selfplay_thread, &travaux[i]) != 0) {
+			perror("Impossible de créer un thread.");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	memset(&total, 0, sizeof(total));
+	for(i = 0; i < options.threads; i++) {
+		pthread_join(travaux[i].thread, NULL);
+		total.parties += travaux[i].parties;
+		total.coups   += travaux[i].coups;
+		total.nulles  += travaux[i].nulles;
+		for(j = 0; j < options.nb_strategies; j++) {
+			total.victoires[j] += travaux[i].victoires[j];
+		}
+		morpion_free_resources(&travaux[i].morpion);
+	}
+	duree = horloge_secondes() - debut;
+	if(duree <= 0) {
+		duree = 1e-9;
+	}
+
+	printf("%dx%d alignement %d, %d threads, graine %lu : %ld parties, %ld coups, "
+			"%.3f s, %.1f parties/s, %.1f coups/s\n",
+			options.config.longueur, options.config.largeur, options.config.alignement,
+			options.threads, options.graine, total.parties, total.coups,
+			duree, total.parties / duree, total.coups / duree);
+	for(j = 0; j < options.nb_strategies; j++) {
+		printf("  joueur %d (%s) : %ld victoires\n", j + 1, options.strategies[j], total.victoires[j]);
+	}
+	printf("  nulles : %ld\n", total.nulles);
+
+	free(travaux);
+	if(options.archive != NULL) {
+		archive_fermer(options.archive);
+	}
+
+	return EXIT_SUCCESS;
+}
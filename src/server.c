@@ -4,158 +4,883 @@
  * \author Philippe Lewin <lewinp@esiee.fr>
  * \version 0.1
  * \date Janvier 2013
+ *
+ * Un seul processus héberge toutes les parties. Le thread principal est un
+ * frontal : il reçoit les requêtes sur un socket ROUTER et les aiguille vers
+ * un groupe de travailleurs, un thread par cœur, par des sockets DEALER
+ * inproc. Chaque partie appartient au travailleur d'indice
+ * identifiant % nombre de travailleurs, qui range ses parties dans sa propre
+ * TableParties : l'état d'une partie n'est modifié que par un seul thread,
+ * sans verrou. Les réponses repassent par le frontal, les notifications des
+ * travailleurs aussi, pour être publiées sur le socket PUB.
+ *
+ * Avec un journal, les changements des parties y sont ajoutés par les
+ * travailleurs ; au démarrage, le journal est rejoué avant de lancer les
+ * travailleurs et les parties reprennent où elles en étaient.
  */
 
 #include <zmq.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <unistd.h>
 #include <string.h>
+#include <pthread.h>
+#include <signal.h>
 
 #include "server.h"
 #include "protocol.h"
 #include "morpion.h"
+#include "parties.h"
+#include "format.h"
+#include "trace.h"
+#include "statistiques.h"
+#include "horloge.h"
+#include "journal.h"
+#include "archive.h"
+
+/** Mis à 1 par SIGINT ou SIGTERM : le frontal sort de sa boucle et arrête le serveur. */
+static volatile sig_atomic_t server_arret = 0;
 
 /**
- * \fn int main(int argc, char* argv[])
- * \brief Point d'entrée pour le serveur du morpion en réseau.
+ * \struct Travailleur
+ * \brief État d'un thread travailleur et des parties qu'il héberge.
+ */
+typedef struct Travailleur {
+	int indice;                             /*!< Rang du travailleur dans le serveur. */
+	void* context;                          /*!< Contexte ZeroMQ partagé avec le frontal. */
+	void* canal;                            /*!< Extrémité DEALER du frontal vers ce travailleur. */
+	void* socket;                           /*!< Extrémité DEALER du travailleur. */
+	void* notifications;                    /*!< Socket PUSH des notifications vers le frontal. */
+	TableParties* parties;                  /*!< Parties hébergées par ce travailleur. */
+	unsigned char* tampon;                  /*!< Tampon des réponses, alloué une fois au démarrage. */
+	size_t taille_tampon;                   /*!< Taille du tampon des réponses. */
+	zmq_msg_t enveloppe[SERVER_TRAMES_MAX]; /*!< Trames d'adresse de la requête en cours. */
+	int nb_enveloppe;                       /*!< Nombre de trames d'adresse. */
+	int joueurs;                            /*!< Joueurs présents dans ses parties. */
+	Statistiques* statistiques;             /*!< Activité, écrite par ce seul thread. */
+	Journal* journal;                       /*!< Journal partagé des parties, NULL sans journal. */
+	Archive* archive;                       /*!< Archive partagée des parties finies, NULL sans archive. */
+	pthread_t thread;                       /*!< Thread du travailleur. */
+} Travailleur;
+
+/**
+ * \struct Serveur
+ * \brief État du frontal.
+ */
+typedef struct Serveur {
+	void* frontal;                  /*!< Socket ROUTER des clients. */
+	void* publisher;                /*!< Socket PUB des notifications. */
+	void* notifications;            /*!< Socket PULL des notifications des travailleurs. */
+	int partie_en_attente;          /*!< Partie qui attend des joueurs, 0 s'il n'y en a pas. */
+	int joueurs_en_attente;         /*!< Joueurs envoyés vers la partie en attente. */
+	int prochain_id;                /*!< Prochain identifiant de partie en attente. */
+	int nb_travailleurs;            /*!< Nombre de travailleurs. */
+	Travailleur travailleurs[SERVER_TRAVAILLEURS_MAX]; /*!< Travailleurs. */
+	Statistiques* statistiques;     /*!< Activité du frontal : PROTOCOL_GET_STATS. */
+	Statistiques* total;            /*!< Fusion des statistiques de tous les threads. */
+	unsigned char* tampon;          /*!< Tampon des réponses PROTOCOL_GET_STATS. */
+	const char* fichier;            /*!< Fichier des statistiques périodiques, NULL si aucun. */
+	double periode;                 /*!< Période d'écriture du fichier (s). */
+	double prochaine_ecriture;      /*!< Date de la prochaine écriture du fichier (s). */
+	Journal* journal;               /*!< Journal des parties, NULL sans journal. */
+	Archive* archive;               /*!< Archive des parties finies, NULL sans archive. */
+	double prochaine_archive;       /*!< Date de la prochaine écriture de l'archive (s). */
+} Serveur;
+
+/**
+ * \fn static int server_recevoir(void* socket, zmq_msg_t* trames, int max)
+ * \brief Reçoit toutes les trames d'un message.
  *
- * \param argc Nombre d'arguments de la commande.
- * \param argv Tableau des arguments.
+ * Les trames au-delà de max sont ignorées, sauf la dernière qui est toujours
+ * gardée : c'est le corps du message.
  *
- * \return Code de sortie du programme.
+ * \param socket Socket ZeroMQ à lire.
+ * \param trames Tableau d'au moins max trames, à fermer par l'appelant.
+ * \param max Nombre maximal de trames gardées.
+ * \return Le nombre de trames gardées.
  */
-int main(int argc, char* argv[]) {
-	void *context = zmq_init(1);
-	void *responder = zmq_socket(context, ZMQ_REP);
+static int server_recevoir(void* socket, zmq_msg_t* trames, int max) {
+	int nombre = 0;
+	int64_t suite = 1;
+	size_t taille = sizeof(suite);
 
-	Morpion morpion;
+	while(suite) {
+		if(nombre == max) {
+			zmq_msg_close(&trames[--nombre]);
+		}
+		zmq_msg_init(&trames[nombre]);
+		zmq_recv(socket, &trames[nombre++], 0);
+		zmq_getsockopt(socket, ZMQ_RCVMORE, &suite, &taille);
+	}
 
-	morpion.grille = NULL;
-	morpion.config = morpion_config_parse_options(argc, argv);
-	morpion.ui     = text_interface_create();
+	return nombre;
+}
 
-	int nbJoueurs = 0;
+/**
+ * \fn static void server_envoyer(void* socket, zmq_msg_t* trames, int nombre)
+ * \brief Envoie des trames en un seul message et les ferme.
+ *
+ * \param socket Socket ZeroMQ destinataire.
+ * \param trames Trames à envoyer.
+ * \param nombre Nombre de trames.
+ */
+static void server_envoyer(void* socket, zmq_msg_t* trames, int nombre) {
+	int i;
 
-	morpion_reset_grille(&morpion);
+	for(i = 0; i < nombre; i++) {
+		zmq_send(socket, &trames[i], i + 1 < nombre ? ZMQ_SNDMORE : 0);
+		zmq_msg_close(&trames[i]);
+	}
+}
 
-	morpion.liste_joueurs = NULL;
+/**
+ * \fn static void server_relayer(void* source, void* destination)
+ * \brief Fait suivre un message d'un socket à un autre.
+ *
+ * \param source Socket ZeroMQ à lire.
+ * \param destination Socket ZeroMQ destinataire.
+ */
+static void server_relayer(void* source, void* destination) {
+	zmq_msg_t trames[SERVER_TRAMES_MAX];
+	server_envoyer(destination, trames, server_recevoir(source, trames, SERVER_TRAMES_MAX));
+}
 
-	zmq_bind(responder, "tcp://*:5555");
+/**
+ * \fn static void server_repondre(Travailleur* travailleur, const void* donnees, size_t taille)
+ * \brief Envoie une réponse au client de la requête en cours.
+ *
+ * \param travailleur Travailleur qui traite la requête.
+ * \param donnees Octets de la réponse.
+ * \param taille Nombre d'octets de la réponse.
+ */
+static void server_repondre(Travailleur* travailleur, const void* donnees, size_t taille) {
+	zmq_msg_t reply;
+	int i;
 
-	while (1) {
-		char* request_data;
-
-		zmq_msg_t request;
-		zmq_msg_init(&request);
-		zmq_recv(responder, &request, 0);
-		request_data = (char*) zmq_msg_data(&request);
-		switch(*request_data) {
-			case PROTOCOL_JOIN:
-				nbJoueurs++;
-				printf("DEBUG: Joueur %d rejoint la partie : %s\n", nbJoueurs, request_data+1);
-				if(morpion.liste_joueurs == NULL) {
-					morpion.liste_joueurs = joueurs_creer_liste(creerJoueurHumain(nbJoueurs));
-				} else {
-					joueurs_place_suivant(morpion.liste_joueurs, creerJoueurHumain(nbJoueurs));
+	for(i = 0; i < travailleur->nb_enveloppe; i++) {
+		zmq_send(travailleur->socket, &travailleur->enveloppe[i], ZMQ_SNDMORE);
+		zmq_msg_close(&travailleur->enveloppe[i]);
+	}
+	travailleur->nb_enveloppe = 0;
+
+	zmq_msg_init_size(&reply, taille);
+	if(taille > 0) {
+		memcpy(zmq_msg_data(&reply), donnees, taille);
+	}
+	zmq_send(travailleur->socket, &reply, 0);
+	zmq_msg_close(&reply);
+}
+
+/**
+ * \fn static int server_lire_entier(zmq_msg_t* request, int rang, int* valeur)
+ * \brief Lit le rang-ième entier qui suit l'opcode d'une requête.
+ *
+ * \param request Requête du client.
+ * \param rang Rang de l'entier, 0 pour l'identifiant de partie.
+ * \param valeur Pointeur pour sauver l'entier lu.
+ * \return 1 si la requête est assez longue, 0 sinon.
+ */
+static int server_lire_entier(zmq_msg_t* request, int rang, int* valeur) {
+	size_t debut = 1 + rang * sizeof(int);
+
+	if(zmq_msg_size(request) < debut + sizeof(int)) {
+		return 0;
+	}
+	memcpy(valeur, (char*) zmq_msg_data(request) + debut, sizeof(int));
+	return 1;
+}
+
+/**
+ * \fn static void server_notifier(Travailleur* travailleur, Partie* partie, int auteur, int x, int y)
+ * \brief Publie une PROTOCOL_NOTIFICATION pour les abonnés d'une partie.
+ *
+ * La notification passe par le frontal, seul propriétaire du socket PUB.
+ *
+ * \param travailleur Travailleur qui héberge la partie.
+ * \param partie Partie qui a changé.
+ * \param auteur Joueur qui a placé un pion, 0 si aucun pion n'a été placé.
+ * \param x Position x du pion.
+ * \param y Position y du pion.
+ */
+static void server_notifier(Travailleur* travailleur, Partie* partie, int auteur, int x, int y) {
+	zmq_msg_t notification;
+	char* data;
+	int champs[5];
+
+	champs[0] = parties_joueur_courant(partie);
+	champs[1] = auteur;
+	champs[2] = x;
+	champs[3] = y;
+	champs[4] = partie->version;
+
+	zmq_msg_init_size(&notification, sizeof(int) + 1 + sizeof(champs));
+	data = (char*) zmq_msg_data(&notification);
+	memcpy(data, &partie->id, sizeof(int));
+	data[sizeof(int)] = (char) PROTOCOL_NOTIFICATION;
+	memcpy(data + sizeof(int) + 1, champs, sizeof(champs));
+	zmq_send(travailleur->notifications, &notification, 0);
+	zmq_msg_close(&notification);
+}
+
+/**
+ * \fn static void server_archiver(Travailleur* travailleur, Partie* partie)
+ * \brief Ajoute à l'archive une partie que tous ses joueurs ont quittée.
+ *
+ * Le serveur ne déclare pas de gagnant : les coups sont rejoués sur la
+ * grille de la partie, qui va être libérée, et la partie archivée s'arrête
+ * au premier alignement. Une partie où les joueurs n'ont pas joué chacun
+ * leur tour n'est pas archivée.
+ *
+ * \param travailleur Travailleur qui héberge la partie.
+ * \param partie Partie sur le point d'être supprimée.
+ */
+static void server_archiver(Travailleur* travailleur, Partie* partie) {
+	Grille* grille = partie->morpion.grille;
+	int joueurs[ARCHIVE_MAX_JOUEURS];
+	int nb_joueurs = partie->nb_joueurs < partie->version ? partie->nb_joueurs : partie->version;
+	int gagnant = 0;
+	int nb_coups, k;
+
+	if(nb_joueurs < 1 || nb_joueurs > ARCHIVE_MAX_JOUEURS) {
+		return;
+	}
+	for(k = 0; k < nb_joueurs; k++) {
+		joueurs[k] = partie->journal[2 * k];
+	}
+
+	grille_vider(grille);
+	for(nb_coups = 0; nb_coups < partie->version && gagnant == 0; nb_coups++) {
+		int joueur = partie->journal[2 * nb_coups];
+		int x = partie->journal[2 * nb_coups + 1] % grille->longueur;
+		int y = partie->journal[2 * nb_coups + 1] / grille->longueur;
+
+		if(joueur != joueurs[nb_coups % nb_joueurs]) {
+			TRACE(TRACE_DEBUG, "Partie %d non archivée : les joueurs n'alternent pas.", partie->id);
+			return;
+		}
+		placerPion(grille, joueur, x, y);
+		if(alignePion(grille, x, y, partie->morpion.config.alignement)) {
+			gagnant = joueur;
+		}
+	}
+
+	/* Les cases seules, en place : le journal de la partie ne sert plus. */
+	for(k = 0; k < nb_coups; k++) {
+		partie->journal[k] = partie->journal[2 * k + 1];
+	}
+	archive_ajouter(travailleur->archive, partie->morpion.config, joueurs, nb_joueurs,
+			gagnant, partie->journal, nb_coups);
+}
+
+/**
+ * \fn static void server_traiter(Travailleur* travailleur, zmq_msg_t* request)
+ * \brief Traite une requête et y répond.
+ *
+ * Un PROTOCOL_JOIN crée la partie demandée si elle n'existe pas : le frontal
+ * a déjà remplacé l'identifiant 0 par celui de la partie en attente.
+ *
+ * \param travailleur Travailleur qui héberge la partie visée.
+ * \param request Requête du client.
+ */
+static void server_traiter(Travailleur* travailleur, zmq_msg_t* request) {
+	char* request_data = (char*) zmq_msg_data(request);
+	Partie* partie = NULL;
+	int partie_id;
+
+	if(zmq_msg_size(request) < 1 || !server_lire_entier(request, 0, &partie_id)) {
+		TRACE(TRACE_AVERTISSEMENT, "Requête trop courte (%d octets).", (int) zmq_msg_size(request));
+		server_repondre(travailleur, NULL, 0);
+		return;
+	}
+
+	partie = parties_chercher(travailleur->parties, partie_id);
+	if(partie == NULL && *request_data == PROTOCOL_JOIN && partie_id > 0) {
+		partie = parties_creer_partie(travailleur->parties, partie_id);
+	}
+	if(partie == NULL) {
+		TRACE(TRACE_DEBUG, "Partie %d inconnue.", partie_id);
+		server_repondre(travailleur, NULL, 0);
+		return;
+	}
+
+	switch(*request_data) {
+		case PROTOCOL_JOIN:
+			{
+				int reponse[2];
+				reponse[0] = parties_ajouter_joueur(partie);
+				reponse[1] = partie->id;
+				if(reponse[0] == 0) {
+					TRACE(TRACE_INFO, "Partie %d complète : JOIN refusé.", partie->id);
+					server_repondre(travailleur, reponse, sizeof(reponse));
+					break;
 				}
-				zmq_msg_t reply;
-				zmq_msg_init_size(&reply, sizeof(nbJoueurs));
-				memcpy(zmq_msg_data(&reply), &nbJoueurs, sizeof(nbJoueurs));
-				zmq_send(responder, &reply, 0);
-				zmq_msg_close(&reply);
-				break;
-			case PROTOCOL_GET_CONFIG:
-				printf("DEBUG: Un joueur veut récupérer la configuration du morpion.\n");
-				{
-					char* serialization = morpion_config_serialize(morpion.config);
-					zmq_msg_t reply;
-					zmq_msg_init_size(&reply, sizeof(MorpionConfig));
-					memcpy(zmq_msg_data(&reply), serialization, sizeof(MorpionConfig));
-
-					zmq_send(responder, &reply, 0);
-					zmq_msg_close(&reply);
-					free(serialization);
+				travailleur->joueurs += 1;
+				if(travailleur->journal != NULL) {
+					journal_ecrire(travailleur->journal, JOURNAL_JOIN, partie->id, reponse[0], 0, 0);
 				}
-				break;
-			case PROTOCOL_GET_GRILLE:
-				printf("DEBUG: Un joueur veut récupérer la grille.\n");
-				{
-					char* serialization = grille_serialize(morpion.grille);
-					size_t taille = morpion.grille->largeur * morpion.grille->longueur * sizeof(int);
-					zmq_msg_t reply;
-					zmq_msg_init_size(&reply, taille);
-					memcpy(zmq_msg_data(&reply), serialization, taille);
-
-					for(int j = 0; j < morpion.grille->largeur; j++) {
-						for(int i = 0; i < morpion.grille->longueur; i++) {
-							int* ser = (int*) serialization;
-							printf("%d ", ser[i + j*morpion.grille->longueur]);
-						}
-						printf("\n");
-					}
+				TRACE(TRACE_INFO, "Joueur %d rejoint la partie %d : %.*s", reponse[0], partie->id,
+						(int) (zmq_msg_size(request) - 1 - sizeof(int)), request_data + 1 + sizeof(int));
+				server_repondre(travailleur, reponse, sizeof(reponse));
+				server_notifier(travailleur, partie, 0, 0, 0);
+			}
+			break;
+		case PROTOCOL_GET_CONFIG:
+			TRACE(TRACE_DEBUG, "Partie %d : configuration demandée.", partie->id);
+			{
+				long taille = format_ecrire_config(partie->morpion.config, travailleur->tampon, travailleur->taille_tampon);
+				server_repondre(travailleur, travailleur->tampon, taille);
+			}
+			break;
+		case PROTOCOL_GET_GRILLE:
+			TRACE(TRACE_DEBUG, "Partie %d : grille demandée.", partie->id);
+			{
+				long taille = format_ecrire_grille(partie->morpion.grille, FORMAT_CASES_AUTO,
+						travailleur->tampon, travailleur->taille_tampon);
+				server_repondre(travailleur, travailleur->tampon, taille);
+			}
+			break;
+		case PROTOCOL_GET_COUPS:
+			{
+				unsigned char* reponse = travailleur->tampon;
+				size_t entete = sizeof(int) + 1;
+				int version = -1;
+				int retard;
+				long taille;
 
-					zmq_send(responder, &reply, 0);
-					zmq_msg_close(&reply);
+				server_lire_entier(request, 1, &version);
+				retard = partie->version - version;
+
+				memcpy(reponse, &partie->version, sizeof(int));
+				if(version >= 0 && retard >= 0 && retard <= PROTOCOL_COUPS_MAX) {
+					reponse[sizeof(int)] = PROTOCOL_COUPS_DELTA;
+					taille = retard * 2 * sizeof(int);
+					memcpy(reponse + entete, &partie->journal[2 * version], taille);
+				} else {
+					reponse[sizeof(int)] = PROTOCOL_COUPS_GRILLE;
+					taille = format_ecrire_grille(partie->morpion.grille, FORMAT_CASES_AUTO,
+							reponse + entete, travailleur->taille_tampon - entete);
 				}
-				break;
-			case PROTOCOL_GET_TURN:
-				{
-					int joueur_id = 0;
-					if(morpion.liste_joueurs != NULL) {
-						if(morpion.liste_joueurs->suivant != morpion.liste_joueurs) {
-							joueur_id = morpion.liste_joueurs->joueur->id;
-						}
+
+				server_repondre(travailleur, reponse, entete + taille);
+			}
+			break;
+		case PROTOCOL_GET_TURN:
+			{
+				int joueur_id = parties_joueur_courant(partie);
+				TRACE(TRACE_DEBUG, "Partie %d : tour du joueur %d demandé.", partie->id, joueur_id);
+				server_repondre(travailleur, &joueur_id, sizeof(joueur_id));
+			}
+			break;
+		case PROTOCOL_PLAY_TURN:
+			{
+				int joueur_id, x, y;
+				int code = 0;
+
+				if(!server_lire_entier(request, 1, &joueur_id)
+						|| !server_lire_entier(request, 2, &x)
+						|| !server_lire_entier(request, 3, &y)) {
+					/*Cheater*/
+					statistiques_coup_refuse(travailleur->statistiques);
+					TRACE(TRACE_AVERTISSEMENT, "Partie %d : PLAY_TURN trop court.", partie->id);
+				} else if(!(code = parties_jouer(partie, joueur_id, x, y))) {
+					/*Cheater*/
+					statistiques_coup_refuse(travailleur->statistiques);
+					TRACE(TRACE_DEBUG, "Partie %d : coup (%d, %d) du joueur %d refusé.", partie->id, x, y, joueur_id);
+				} else {
+					TRACE(TRACE_DEBUG, "Partie %d : le joueur %d joue (%d, %d).", partie->id, joueur_id, x, y);
+					if(travailleur->journal != NULL) {
+						journal_ecrire(travailleur->journal, JOURNAL_COUP, partie->id, joueur_id, x, y);
 					}
-					printf("Un joueur veut savoir à qui est le tour.\n");
-					zmq_msg_t reply;
-					zmq_msg_init_size(&reply, sizeof(joueur_id));
-					memcpy(zmq_msg_data(&reply), &joueur_id, sizeof(joueur_id));
-					zmq_send(responder, &reply, 0);
-					zmq_msg_close(&reply);
 				}
-				break;
-			case PROTOCOL_PLAY_TURN:
-				{
-					printf("Play turn ...\n");
-					int joueur_id = * ( (int*) (request_data+1) );
-					int x         = * ( (int*) (request_data+1+1*sizeof(int)) );
-					int y         = * ( (int*) (request_data+1+2*sizeof(int)) );
-					int code;
-
-					if(morpion.liste_joueurs == NULL) {
-						/*Cheater*/
-						break;
-					}
 
-					if(joueur_id != morpion.liste_joueurs->joueur->id) {
-						/*Cheater*/
-						break;
+				server_repondre(travailleur, &code, sizeof(code));
+				if(code) {
+					server_notifier(travailleur, partie, joueur_id, x, y);
+				}
+			}
+			break;
+		case PROTOCOL_QUIT:
+			{
+				int joueur_id = 0;
+				char code = 0;
+
+				if(server_lire_entier(request, 1, &joueur_id)) {
+					code = (char) parties_retirer_joueur(partie, joueur_id);
+					travailleur->joueurs -= code;
+				}
+				if(code && travailleur->journal != NULL) {
+					journal_ecrire(travailleur->journal, JOURNAL_QUIT, partie->id, joueur_id, 0, 0);
+				}
+				TRACE(TRACE_INFO, "Joueur %d quitte la partie %d.", joueur_id, partie->id);
+				server_repondre(travailleur, &code, sizeof(code));
+				if(partie->presents == 0) {
+					if(travailleur->archive != NULL) {
+						server_archiver(travailleur, partie);
 					}
-					code = placerPion(morpion.grille, joueur_id, x, y);
-					morpion.liste_joueurs = morpion.liste_joueurs->suivant;
-
-					zmq_msg_t reply;
-					zmq_msg_init_size(&reply, sizeof(code));
-					memcpy(zmq_msg_data(&reply), &code, sizeof(code));
-					zmq_send(responder, &reply, 0);
-					zmq_msg_close(&reply);
+					parties_supprimer(travailleur->parties, partie->id);
+				} else if(code) {
+					server_notifier(travailleur, partie, 0, 0, 0);
 				}
-				break;
-			case PROTOCOL_QUIT:
-				printf("Un joueur a quité la partie\n");
-				break;
-			default:
-				printf("ERREUR PROTOCOLE !!\n");
-				break;
+			}
+			break;
+		default:
+			TRACE(TRACE_AVERTISSEMENT, "Opcode inconnu 0x%02x.", (unsigned char) *request_data);
+			server_repondre(travailleur, NULL, 0);
+			break;
+	}
+}
+
+/**
+ * \fn static void* server_travailleur(void* argument)
+ * \brief Boucle d'un travailleur : traite les requêtes que lui envoie le frontal.
+ *
+ * Un message d'une seule trame vide, que le frontal n'envoie qu'à l'arrêt du
+ * serveur (les requêtes des clients sont toujours précédées de leur
+ * adresse), termine la boucle.
+ *
+ * \param argument Le Travailleur.
+ * \return NULL.
+ */
+static void* server_travailleur(void* argument) {
+	Travailleur* travailleur = (Travailleur*) argument;
+	char adresse[64];
+
+	sprintf(adresse, "inproc://travailleur-%d", travailleur->indice);
+	travailleur->socket = zmq_socket(travailleur->context, ZMQ_DEALER);
+	zmq_connect(travailleur->socket, adresse);
+	travailleur->notifications = zmq_socket(travailleur->context, ZMQ_PUSH);
+	zmq_connect(travailleur->notifications, "inproc://notifications");
+
+	while (1) {
+		zmq_msg_t trames[SERVER_TRAMES_MAX + 1];
+		int nombre = server_recevoir(travailleur->socket, trames, SERVER_TRAMES_MAX + 1);
+		double debut;
+		int i;
+
+		if(nombre == 1 && zmq_msg_size(&trames[0]) == 0) {
+			zmq_msg_close(&trames[0]);
+			break;
 		}
-		zmq_msg_close(&request);
+
+		/* Tout ce qui précède le corps est l'adresse du client. */
+		for(i = 0; i < nombre - 1; i++) {
+			zmq_msg_init(&travailleur->enveloppe[i]);
+			zmq_msg_move(&travailleur->enveloppe[i], &trames[i]);
+			zmq_msg_close(&trames[i]);
+		}
+		travailleur->nb_enveloppe = nombre - 1;
+
+		debut = horloge_secondes();
+		server_traiter(travailleur, &trames[nombre - 1]);
+		statistiques_requete(travailleur->statistiques,
+				zmq_msg_size(&trames[nombre - 1]) > 0 ? *(char*) zmq_msg_data(&trames[nombre - 1]) : 0,
+				(uint64_t) ((horloge_secondes() - debut) * 1e9));
+		statistiques_jauges(travailleur->statistiques, travailleur->parties->nombre, travailleur->joueurs);
+		zmq_msg_close(&trames[nombre - 1]);
 	}
 
-	zmq_close(responder);
-	zmq_term(context);
+	zmq_close(travailleur->notifications);
+	zmq_close(travailleur->socket);
+	return NULL;
+}
+
+/**
+ * \fn static void server_signal(int numero)
+ * \brief Demande l'arrêt du serveur, sur SIGINT ou SIGTERM.
+ */
+static void server_signal(int numero) {
+	(void) numero;
+	server_arret = 1;
+}
 
-	morpion_free_resources(&morpion);
+/**
+ * \fn static int server_partie_en_attente(Serveur* serveur)
+ * \brief Identifiant de la partie où envoyer un joueur sans partie.
+ *
+ * Une nouvelle partie est ouverte quand la précédente a reçu
+ * ::PARTIES_JOUEURS_PAR_PARTIE joueurs. Les identifiants sont consécutifs :
+ * les nouvelles parties se répartissent entre tous les travailleurs.
+ *
+ * \param serveur État du frontal.
+ * \return L'identifiant de la partie.
+ */
+static int server_partie_en_attente(Serveur* serveur) {
+	if(serveur->partie_en_attente == 0 || serveur->joueurs_en_attente >= PARTIES_JOUEURS_PAR_PARTIE) {
+		serveur->partie_en_attente  = serveur->prochain_id;
+		serveur->joueurs_en_attente = 0;
+		serveur->prochain_id        = serveur->prochain_id % 0x7FFFFFFF + 1;
+		if(serveur->journal != NULL) {
+			journal_ecrire(serveur->journal, JOURNAL_ATTENTE, serveur->partie_en_attente, 0, 0, 0);
+		}
+	}
+	serveur->joueurs_en_attente += 1;
+	return serveur->partie_en_attente;
+}
+
+/**
+ * \fn static Statistiques* server_statistiques(Serveur* serveur)
+ * \brief Fusionne les statistiques du frontal et de tous les travailleurs.
+ *
+ * \param serveur État du frontal.
+ * \return Les statistiques fusionnées, valables jusqu'au prochain appel.
+ */
+static Statistiques* server_statistiques(Serveur* serveur) {
+	int i;
+
+	statistiques_vider(serveur->total);
+	statistiques_fusionner(serveur->total, serveur->statistiques);
+	for(i = 0; i < serveur->nb_travailleurs; i++) {
+		statistiques_fusionner(serveur->total, serveur->travailleurs[i].statistiques);
+	}
+
+	return serveur->total;
+}
+
+/**
+ * \fn static void server_repondre_statistiques(Serveur* serveur, zmq_msg_t* trames, int nombre)
+ * \brief Répond à un PROTOCOL_GET_STATS depuis le frontal.
+ *
+ * \param serveur État du frontal.
+ * \param trames Trames de la requête : adresse du client puis corps.
+ * \param nombre Nombre de trames.
+ */
+static void server_repondre_statistiques(Serveur* serveur, zmq_msg_t* trames, int nombre) {
+	double debut = horloge_secondes();
+	size_t taille = statistiques_serialiser(server_statistiques(serveur), serveur->nb_travailleurs,
+			serveur->tampon);
+
+	zmq_msg_close(&trames[nombre - 1]);
+	zmq_msg_init_size(&trames[nombre - 1], taille);
+	memcpy(zmq_msg_data(&trames[nombre - 1]), serveur->tampon, taille);
+	server_envoyer(serveur->frontal, trames, nombre);
+
+	statistiques_requete(serveur->statistiques, PROTOCOL_GET_STATS,
+			(uint64_t) ((horloge_secondes() - debut) * 1e9));
+}
+
+/**
+ * \fn static void server_ecrire_statistiques(Serveur* serveur)
+ * \brief Remplace le fichier des statistiques par leur état actuel.
+ *
+ * Le fichier est écrit à côté puis renommé : un lecteur ne voit jamais un
+ * fichier à moitié écrit.
+ *
+ * \param serveur État du frontal.
+ */
+static void server_ecrire_statistiques(Serveur* serveur) {
+	char provisoire[1024];
+	FILE* fichier;
+
+	sprintf(provisoire, "%.1000s.tmp", serveur->fichier);
+	fichier = fopen(provisoire, "w");
+	if(fichier == NULL) {
+		TRACE(TRACE_ERREUR, "Impossible d'écrire %s.", provisoire);
+		return;
+	}
+	statistiques_ecrire(server_statistiques(serveur), serveur->nb_travailleurs, fichier);
+	if(fclose(fichier) != 0 || rename(provisoire, serveur->fichier) != 0) {
+		TRACE(TRACE_ERREUR, "Impossible d'écrire %s.", serveur->fichier);
+	}
+}
+
+/**
+ * \fn static void server_rejouer(void* contexte, const EnregistrementJournal* enregistrement)
+ * \brief Rejoue un changement du journal dans la table de son travailleur.
+ *
+ * Les parties en attente du frontal sont journalisées aussi : la partie en
+ * attente et les identifiants des suivantes reprennent où ils en étaient.
+ *
+ * \param contexte Le Serveur, travailleurs pas encore lancés.
+ * \param enregistrement Changement à rejouer.
+ */
+static void server_rejouer(void* contexte, const EnregistrementJournal* enregistrement) {
+	Serveur* serveur = (Serveur*) contexte;
+	Travailleur* travailleur = &serveur->travailleurs[(unsigned int) enregistrement->partie % serveur->nb_travailleurs];
+	Partie* partie = parties_chercher(travailleur->parties, enregistrement->partie);
+
+	switch(enregistrement->type) {
+		case JOURNAL_ATTENTE:
+			serveur->partie_en_attente  = enregistrement->partie;
+			serveur->joueurs_en_attente = 0;
+			serveur->prochain_id        = enregistrement->partie % 0x7FFFFFFF + 1;
+			return;
+		case JOURNAL_JOIN:
+			if(partie == NULL) {
+				partie = parties_creer_partie(travailleur->parties, enregistrement->partie);
+			}
+			if(partie != NULL && parties_ajouter_joueur(partie) == enregistrement->joueur) {
+				travailleur->joueurs += 1;
+				if(partie->id == serveur->partie_en_attente) {
+					serveur->joueurs_en_attente += 1;
+				}
+				return;
+			}
+			break;
+		case JOURNAL_COUP:
+			if(partie != NULL && parties_jouer(partie, enregistrement->joueur, enregistrement->x, enregistrement->y)) {
+				return;
+			}
+			break;
+		case JOURNAL_QUIT:
+			if(partie != NULL && parties_retirer_joueur(partie, enregistrement->joueur)) {
+				travailleur->joueurs -= 1;
+				if(partie->presents == 0) {
+					parties_supprimer(travailleur->parties, partie->id);
+				}
+				return;
+			}
+			break;
+	}
+	TRACE(TRACE_AVERTISSEMENT, "Journal : changement %d de la partie %d incohérent, ignoré.",
+			enregistrement->type, enregistrement->partie);
+}
+
+/**
+ * \fn static void server_aiguiller(Serveur* serveur)
+ * \brief Envoie une requête d'un client au travailleur qui héberge sa partie.
+ *
+ * Une requête trop courte pour contenir un identifiant de partie part vers
+ * le premier travailleur, qui y répond par une erreur de protocole.
+ *
+ * \param serveur État du frontal.
+ */
+static void server_aiguiller(Serveur* serveur) {
+	zmq_msg_t trames[SERVER_TRAMES_MAX];
+	int nombre = server_recevoir(serveur->frontal, trames, SERVER_TRAMES_MAX);
+	zmq_msg_t* request = &trames[nombre - 1];
+	char* request_data = (char*) zmq_msg_data(request);
+	int partie_id = 0;
+
+	if(zmq_msg_size(request) >= 1 && *request_data == PROTOCOL_GET_STATS) {
+		server_repondre_statistiques(serveur, trames, nombre);
+		return;
+	}
+	if(zmq_msg_size(request) >= 1 + sizeof(int)) {
+		memcpy(&partie_id, request_data + 1, sizeof(int));
+		if(*request_data == PROTOCOL_JOIN && partie_id == 0) {
+			partie_id = server_partie_en_attente(serveur);
+			memcpy(request_data + 1, &partie_id, sizeof(int));
+		}
+	}
+
+	server_envoyer(serveur->travailleurs[(unsigned int) partie_id % serveur->nb_travailleurs].canal,
+			trames, nombre);
+}
+
+/**
+ * \fn int main(int argc, char* argv[])
+ * \brief Point d'entrée pour le serveur du morpion en réseau.
+ *
+ * Les traces vont dans le fichier MORPION_TRACES, ou sur la sortie d'erreur
+ * si la variable n'est pas définie. MORPION_TRACES_NIVEAU choisit leur
+ * niveau, de 0 (::TRACE_ERREUR) à 3 (::TRACE_DEBUG), ::TRACE_INFO par défaut.
+ *
+ * Si MORPION_STATS est défini, les statistiques y sont écrites toutes les
+ * MORPION_STATS_PERIODE secondes (::SERVER_STATS_PERIODE par défaut).
+ *
+ * Si MORPION_JOURNAL est défini, les parties y sont journalisées et celles
+ * du journal existant sont reprises au démarrage.
+ *
+ * Si MORPION_ARCHIVE est défini, les parties que tous leurs joueurs ont
+ * quittées y sont ajoutées (voir archive.h), au plus tard
+ * ::SERVER_ARCHIVE_PERIODE secondes après.
+ *
+ * SIGINT et SIGTERM arrêtent le serveur proprement : les travailleurs
+ * finissent leur requête en cours, puis le journal, l'archive et les traces
+ * sont fermés. Seul le thread principal reçoit ces signaux.
+ *
+ * \param argc Nombre d'arguments de la commande.
+ * \param argv Tableau des arguments.
+ *
+ * \return Code de sortie du programme.
+ */
+int main(int argc, char* argv[]) {
+	MorpionConfig config = morpion_config_parse_options(argc, argv);
+	char* niveau = getenv("MORPION_TRACES_NIVEAU");
+	char* periode = getenv("MORPION_STATS_PERIODE");
+	char* journal = getenv("MORPION_JOURNAL");
+	char* archive = getenv("MORPION_ARCHIVE");
+	void *context = zmq_init(1);
+	zmq_pollitem_t items[2 + SERVER_TRAVAILLEURS_MAX];
+	size_t taille_tampon;
+	long coeurs = sysconf(_SC_NPROCESSORS_ONLN);
+	struct sigaction action;
+	sigset_t signaux;
+	int i;
+
+	static Serveur serveur;
+
+	/* Les threads lancés d'ici héritent du masque et ignorent ces signaux. */
+	sigemptyset(&signaux);
+	sigaddset(&signaux, SIGINT);
+	sigaddset(&signaux, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &signaux, NULL);
+
+	if(!trace_demarrer(getenv("MORPION_TRACES"), niveau != NULL ? atoi(niveau) : TRACE_INFO)) {
+		exit(EXIT_FAILURE);
+	}
+
+	serveur.frontal            = zmq_socket(context, ZMQ_ROUTER);
+	serveur.publisher          = zmq_socket(context, ZMQ_PUB);
+	serveur.notifications      = zmq_socket(context, ZMQ_PULL);
+	serveur.partie_en_attente  = 0;
+	serveur.joueurs_en_attente = 0;
+	serveur.prochain_id        = 1;
+	serveur.nb_travailleurs    = coeurs < 1 ? 1 : coeurs > SERVER_TRAVAILLEURS_MAX ? SERVER_TRAVAILLEURS_MAX : (int) coeurs;
+	serveur.statistiques       = statistiques_creer();
+	serveur.total              = statistiques_creer();
+	serveur.tampon             = (unsigned char*) malloc(STATISTIQUES_TAILLE_MAX);
+	serveur.fichier            = getenv("MORPION_STATS");
+	serveur.periode            = periode != NULL && atof(periode) > 0 ? atof(periode) : SERVER_STATS_PERIODE;
+	serveur.prochaine_ecriture = horloge_secondes() + serveur.periode;
+	serveur.journal            = NULL;
+	serveur.archive            = NULL;
+	serveur.prochaine_archive  = horloge_secondes() + SERVER_ARCHIVE_PERIODE;
+	if(archive != NULL && (serveur.archive = archive_ouvrir(archive)) == NULL) {
+		exit(EXIT_FAILURE);
+	}
+	if(serveur.statistiques == NULL || serveur.total == NULL || serveur.tampon == NULL) {
+		perror("Impossible d'allouer les statistiques du serveur.");
+		exit(EXIT_FAILURE);
+	}
+
+	zmq_bind(serveur.frontal, "tcp://*:5555");
+	zmq_bind(serveur.publisher, "tcp://*:5556");
+	zmq_bind(serveur.notifications, "inproc://notifications");
+
+	/* Assez grand pour une grille, un delta ou une configuration. */
+	taille_tampon = sizeof(int) + 1 + format_taille_max_grille(config.longueur, config.largeur);
+	if(taille_tampon < sizeof(int) + 1 + PROTOCOL_COUPS_MAX * 2 * sizeof(int)) {
+		taille_tampon = sizeof(int) + 1 + PROTOCOL_COUPS_MAX * 2 * sizeof(int);
+	}
+
+	items[0].socket  = serveur.frontal;
+	items[1].socket  = serveur.notifications;
+	for(i = 0; i < serveur.nb_travailleurs; i++) {
+		Travailleur* travailleur = &serveur.travailleurs[i];
+		char adresse[64];
+
+		travailleur->indice        = i;
+		travailleur->context       = context;
+		travailleur->parties       = parties_creer(config);
+		travailleur->taille_tampon = taille_tampon;
+		travailleur->tampon        = (unsigned char*) malloc(taille_tampon);
+		travailleur->nb_enveloppe  = 0;
+		travailleur->joueurs       = 0;
+		travailleur->statistiques  = statistiques_creer();
+		if(travailleur->parties == NULL || travailleur->tampon == NULL || travailleur->statistiques == NULL) {
+			perror("Impossible d'allouer un travailleur.");
+			exit(EXIT_FAILURE);
+		}
+
+		/* Le bind inproc doit précéder le connect du travailleur. */
+		sprintf(adresse, "inproc://travailleur-%d", i);
+		travailleur->canal = zmq_socket(context, ZMQ_DEALER);
+		zmq_bind(travailleur->canal, adresse);
+		items[2 + i].socket = travailleur->canal;
+	}
+
+	if(journal != NULL) {
+		double debut = horloge_secondes();
+		int parties = 0;
+
+		serveur.journal = journal_ouvrir(journal, config, server_rejouer, &serveur);
+		if(serveur.journal == NULL) {
+			exit(EXIT_FAILURE);
+		}
+		for(i = 0; i < serveur.nb_travailleurs; i++) {
+			parties += serveur.travailleurs[i].parties->nombre;
+		}
+		TRACE(TRACE_INFO, "Journal %s rejoué en %.3f s : %d parties reprises.",
+				journal, horloge_secondes() - debut, parties);
+	}
+
+	for(i = 0; i < serveur.nb_travailleurs; i++) {
+		Travailleur* travailleur = &serveur.travailleurs[i];
+
+		travailleur->journal = serveur.journal;
+		travailleur->archive = serveur.archive;
+		statistiques_jauges(travailleur->statistiques, travailleur->parties->nombre, travailleur->joueurs);
+		if(pthread_create(&travailleur->thread, NULL, server_travailleur, travailleur) != 0) {
+			perror("Impossible de lancer un travailleur.");
+			exit(EXIT_FAILURE);
+		}
+	}
+	for(i = 0; i < 2 + serveur.nb_travailleurs; i++) {
+		items[i].fd     = 0;
+		items[i].events = ZMQ_POLLIN;
+	}
+	/* Sans SA_RESTART, un signal interrompt zmq_poll. */
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = server_signal;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+	pthread_sigmask(SIG_UNBLOCK, &signaux, NULL);
+	TRACE(TRACE_INFO, "Serveur prêt, %d travailleurs.", serveur.nb_travailleurs);
+
+	while (!server_arret) {
+		long attente = -1;
+
+		if(serveur.fichier != NULL) {
+			double reste = serveur.prochaine_ecriture - horloge_secondes();
+			if(reste <= 0) {
+				server_ecrire_statistiques(&serveur);
+				serveur.prochaine_ecriture = horloge_secondes() + serveur.periode;
+				continue;
+			}
+			attente = (long) (reste * 1e6) + 1;
+		}
+		if(serveur.archive != NULL) {
+			double reste = serveur.prochaine_archive - horloge_secondes();
+			if(reste <= 0) {
+				archive_synchroniser(serveur.archive);
+				serveur.prochaine_archive = horloge_secondes() + SERVER_ARCHIVE_PERIODE;
+				continue;
+			}
+			if(attente < 0 || (long) (reste * 1e6) + 1 < attente) {
+				attente = (long) (reste * 1e6) + 1;
+			}
+		}
+		if(zmq_poll(items, 2 + serveur.nb_travailleurs, attente) <= 0) {
+			continue;
+		}
+		if(items[0].revents & ZMQ_POLLIN) {
+			server_aiguiller(&serveur);
+		}
+		if(items[1].revents & ZMQ_POLLIN) {
+			server_relayer(serveur.notifications, serveur.publisher);
+		}
+		for(i = 0; i < serveur.nb_travailleurs; i++) {
+			if(items[2 + i].revents & ZMQ_POLLIN) {
+				server_relayer(serveur.travailleurs[i].canal, serveur.frontal);
+			}
+		}
+	}
+
+	TRACE(TRACE_INFO, "Arrêt du serveur.");
+	for(i = 0; i < serveur.nb_travailleurs; i++) {
+		zmq_msg_t arret;
+		zmq_msg_init(&arret);
+		server_envoyer(serveur.travailleurs[i].canal, &arret, 1);
+	}
+	for(i = 0; i < serveur.nb_travailleurs; i++) {
+		pthread_join(serveur.travailleurs[i].thread, NULL);
+		zmq_close(serveur.travailleurs[i].canal);
+	}
+
+	zmq_close(serveur.notifications);
+	zmq_close(serveur.publisher);
+	zmq_close(serveur.frontal);
+	zmq_term(context);
+	if(serveur.journal != NULL) {
+		journal_fermer(serveur.journal);
+	}
+	if(serveur.archive != NULL) {
+		archive_fermer(serveur.archive);
+	}
+	trace_arreter();
 
 	return 0;
 }
@@ -0,0 +1,275 @@
+/**
+ * \file solution.c
+ * \brief Solution exacte des petites configurations, lue par projection en mémoire.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "solution.h"
+
+/** Solutions de MORPION_SOLUTION, ouvertes une fois par ::solution_partage. */
+static Solution* solution_partagees = NULL;
+/** Garantit une seule ouverture des solutions partagées. */
+static pthread_once_t solution_partagees_ouvertes = PTHREAD_ONCE_INIT;
+
+/**
+ * \fn int solution_symetries(Symetries* symetries, int longueur, int largeur)
+ * \brief Calcule les symétries d'une grille.
+ *
+ * Les symétries sont celles de ::grille_symetrie_case, dans le même ordre.
+ *
+ * \param symetries Symétries à remplir.
+ * \param longueur Longueur de la grille.
+ * \param largeur Largeur de la grille.
+ * \return Le nombre de symétries, 0 si la grille a plus de ::SOLUTION_CASES_MAX cases.
+ */
+int solution_symetries(Symetries* symetries, int longueur, int largeur) {
+	int cases = longueur * largeur;
+	int s, i;
+
+	if(longueur < 1 || largeur < 1 || cases > SOLUTION_CASES_MAX) {
+		return 0;
+	}
+	symetries->cases  = cases;
+	symetries->nombre = grille_nb_symetries(longueur, largeur);
+
+	for(s = 0; s < symetries->nombre; s++) {
+		for(i = 0; i < cases; i++) {
+			int image = grille_symetrie_case(longueur, largeur, s, i);
+			int k;
+
+			symetries->image[s][i]       = image;
+			symetries->origine[s][image] = i;
+			symetries->poids[s][i]       = 1;
+			for(k = 0; k < image; k++) {
+				symetries->poids[s][i] *= 3;
+			}
+		}
+	}
+
+	return symetries->nombre;
+}
+
+/**
+ * \fn uint64_t solution_canonique(const Symetries* symetries, const uint8_t* cases, int* symetrie)
+ * \brief Code de la forme canonique d'une position.
+ *
+ * \param symetries Symétries de la grille.
+ * \param cases Contenu de chaque case : 0 vide, 1 joueur au trait, 2 adversaire.
+ * \param symetrie Pointeur pour sauver la symétrie qui donne la forme canonique.
+ * \return Le plus petit code des images de la position.
+ */
+uint64_t solution_canonique(const Symetries* symetries, const uint8_t* cases, int* symetrie) {
+	uint64_t minimum = 0;
+	int s, i;
+
+	for(s = 0; s < symetries->nombre; s++) {
+		uint64_t code = 0;
+		for(i = 0; i < symetries->cases; i++) {
+			code += cases[i] * symetries->poids[s][i];
+		}
+		if(s == 0 || code < minimum) {
+			minimum   = code;
+			*symetrie = s;
+		}
+	}
+
+	return minimum;
+}
+
+/**
+ * \fn Solution* solution_ouvrir(const char* chemin)
+ * \brief Projette une solution en mémoire, en lecture seule.
+ *
+ * \param chemin Fichier de la solution.
+ * \return La solution, NULL si elle est illisible.
+ */
+Solution* solution_ouvrir(const char* chemin) {
+	Solution* solution;
+	const EnteteSolution* entete;
+	struct stat etat;
+	void* carte;
+	int fd = open(chemin, O_RDONLY);
+
+	if(fd < 0 || fstat(fd, &etat) < 0) {
+		perror("Impossible d'ouvrir la solution.");
+		if(fd >= 0) {
+			close(fd);
+		}
+		return NULL;
+	}
+	if((size_t) etat.st_size < sizeof(EnteteSolution)) {
+		fprintf(stderr, "Solution %s illisible : fichier trop court.\n", chemin);
+		close(fd);
+		return NULL;
+	}
+
+	carte = mmap(NULL, etat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(carte == MAP_FAILED) {
+		perror("Impossible de projeter la solution en mémoire.");
+		return NULL;
+	}
+	madvise(carte, etat.st_size, MADV_RANDOM);
+
+	entete = (const EnteteSolution*) carte;
+	if(entete->magique != SOLUTION_MAGIQUE || entete->version != SOLUTION_VERSION
+			|| entete->nombre != (etat.st_size - sizeof(EnteteSolution)) / (sizeof(uint64_t) + sizeof(uint16_t))) {
+		fprintf(stderr, "Solution %s illisible : format, version ou taille inconnus.\n", chemin);
+		munmap(carte, etat.st_size);
+		return NULL;
+	}
+
+	solution = (Solution*) malloc(sizeof(Solution));
+	if(solution == NULL) {
+		perror("Impossible d'allouer la solution.");
+		munmap(carte, etat.st_size);
+		return NULL;
+	}
+	solution->entete   = entete;
+	solution->codes    = (const uint64_t*) (entete + 1);
+	solution->valeurs  = (const uint16_t*) (solution->codes + entete->nombre);
+	solution->taille   = etat.st_size;
+	solution->suivante = NULL;
+	if(solution_symetries(&solution->symetries, entete->longueur, entete->largeur) == 0) {
+		fprintf(stderr, "Solution %s illisible : grille de plus de %d cases.\n", chemin, SOLUTION_CASES_MAX);
+		solution_fermer(solution);
+		return NULL;
+	}
+
+	return solution;
+}
+
+/**
+ * \fn void solution_fermer(Solution* solution)
+ * \brief Ferme une solution ouverte par ::solution_ouvrir.
+ *
+ * \param solution Solution ouverte, que plus aucun joueur ne consulte.
+ */
+void solution_fermer(Solution* solution) {
+	munmap((void*) solution->entete, solution->taille);
+	free(solution);
+}
+
+/**
+ * \fn int solution_chercher(const Solution* solution, Grille* grille, int joueur, int* valeur)
+ * \brief Cherche le meilleur coup d'une position.
+ *
+ * Les solutions suivantes sont consultées si la première n'est pas de la
+ * configuration de la grille. La position n'est pas résolue si elle
+ * contient les pions de plus d'un adversaire.
+ *
+ * \param solution Première solution à consulter, peut être NULL.
+ * \param grille Position.
+ * \param joueur Identifiant du joueur au trait.
+ * \param valeur Pointeur pour sauver la valeur de la position, peut être NULL.
+ * \return L'indice de la case à jouer, -1 si la position n'est pas résolue.
+ */
+int solution_chercher(const Solution* solution, Grille* grille, int joueur, int* valeur) {
+	for(; solution != NULL; solution = solution->suivante) {
+		const EnteteSolution* entete = solution->entete;
+		uint8_t cases[SOLUTION_CASES_MAX];
+		uint64_t code;
+		size_t debut, fin;
+		int adversaire = 0;
+		int symetrie, coup, i;
+
+		if(entete->longueur != grille->longueur || entete->largeur != grille->largeur
+				|| entete->alignement != grille->alignement) {
+			continue;
+		}
+
+		for(i = 0; i < solution->symetries.cases; i++) {
+			int J = GRILLE_OCTET(grille, i % grille->longueur, i / grille->longueur);
+			if(J != 0 && J != joueur) {
+				if(adversaire != 0 && J != adversaire) {
+					return -1;
+				}
+				adversaire = J;
+			}
+			cases[i] = J == 0 ? 0 : J == joueur ? 1 : 2;
+		}
+		code  = solution_canonique(&solution->symetries, cases, &symetrie);
+		debut = 0;
+		fin   = entete->nombre;
+		while(debut < fin) {
+			size_t milieu = debut + (fin - debut) / 2;
+			if(solution->codes[milieu] < code) {
+				debut = milieu + 1;
+			} else {
+				fin = milieu;
+			}
+		}
+		if(debut == entete->nombre || solution->codes[debut] != code) {
+			return -1;
+		}
+
+		/* Un fichier corrompu ou d'une autre version ne doit pas faire lire hors des tables. */
+		coup = SOLUTION_COUP(solution->valeurs[debut]);
+		if(coup >= solution->symetries.cases) {
+			return -1;
+		}
+		coup = solution->symetries.origine[symetrie][coup];
+		if(GRILLE_OCTET(grille, coup % grille->longueur, coup / grille->longueur) != 0) {
+			return -1;
+		}
+		if(valeur != NULL) {
+			*valeur = solution->valeurs[debut];
+		}
+		return coup;
+	}
+
+	return -1;
+}
+
+/**
+ * \fn static void solution_ouvrir_partagees(void)
+ * \brief Ouvre les solutions de MORPION_SOLUTION, séparées par des ':'.
+ */
+static void solution_ouvrir_partagees(void) {
+	char* chemins = getenv("MORPION_SOLUTION");
+	Solution** derniere = &solution_partagees;
+	char* copie;
+	char* chemin;
+	char* reste;
+	int nombre = 0;
+
+	if(chemins == NULL || (copie = strdup(chemins)) == NULL) {
+		return;
+	}
+	for(chemin = strtok_r(copie, ":", &reste); chemin != NULL && nombre < SOLUTION_MAX;
+			chemin = strtok_r(NULL, ":", &reste)) {
+		Solution* solution = solution_ouvrir(chemin);
+		if(solution != NULL) {
+			*derniere = solution;
+			derniere  = &solution->suivante;
+			nombre++;
+		}
+	}
+	free(copie);
+}
+
+/**
+ * \fn const Solution* solution_partage(void)
+ * \brief Solutions exactes du processus.
+ *
+ * Les fichiers de la variable d'environnement MORPION_SOLUTION, séparés par
+ * des ':', sont ouverts au premier appel et le restent jusqu'à la fin du
+ * processus : tous les joueurs de tous les threads les partagent.
+ *
+ * \return La première solution, NULL si MORPION_SOLUTION n'en donne aucune.
+ */
+const Solution* solution_partage(void) {
+	pthread_once(&solution_partagees_ouvertes, solution_ouvrir_partagees);
+	return solution_partagees;
+}
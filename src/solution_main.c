@@ -0,0 +1,393 @@
+/**
+ * \file solution_main.c
+ * \brief Résout exactement une petite configuration et écrit sa solution.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ *
+ * L'arbre de jeu est parcouru en entier par negamax, sans coupure : chaque
+ * position atteignable doit avoir sa valeur exacte. Les positions déjà
+ * résolues, ou symétriques d'une position résolue, sont retrouvées dans une
+ * table de hachage par leur code canonique (voir solution.h). La table
+ * devient le fichier de la solution.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <getopt.h>
+
+#include "morpion.h"
+#include "solution.h"
+#include "alea.h"
+#include "horloge.h"
+
+/** Nombre maximal de positions par défaut, la table occupe alors environ 1,3 Go. */
+#define RESOLUTION_POSITIONS_MAX (1L << 26)
+
+/**
+ * \struct Resolution
+ * \brief État de la résolution d'une configuration.
+ *
+ * La table de hachage est à adressage ouvert : cles vaut le code canonique
+ * plus 1, 0 pour une case vide.
+ */
+typedef struct Resolution {
+	MorpionConfig config;     /*!< Configuration résolue. */
+	Symetries symetries;      /*!< Symétries de la grille. */
+	uint64_t* cles;           /*!< Code canonique + 1 de chaque case de la table. */
+	uint16_t* valeurs;        /*!< Valeur de chaque case de la table. */
+	size_t masque;            /*!< Nombre de cases de la table - 1. */
+	size_t nombre;            /*!< Positions dans la table. */
+	size_t maximum;           /*!< Nombre maximal de positions. */
+} Resolution;
+
+/**
+ * \fn static void resolution_usage(FILE* stream, int exit_code)
+ * \brief Affiche comment utiliser la commande.
+ *
+ * \param stream Le flux où écrire l'aide.
+ * \param exit_code Le code d'erreur à utiliser.
+ */
+static void resolution_usage(FILE* stream, int exit_code) {
+	fprintf(stream, "Utilisation : solution options -o fichier\n");
+	fprintf(stream,
+			" -o --sortie fichier     Fichier de la solution, remplacé s'il existe.\n"
+			" -y --hauteur n          Fixe la hauteur du plateau à n cases.\n"
+			" -x --largeur n          Fixe la largeur du plateau à n cases.\n"
+			" -a --alignement n       Fixe à n le nombre de pions à aligner pour gagner.\n"
+			" -m --maximum n          Abandonne au-delà de n positions (67108864).\n"
+			" -h --help               Affiche une aide et quitte le programme.\n"
+	);
+	exit(exit_code);
+}
+
+/**
+ * \fn static Resolution resolution_parse_options(int argc, char* argv[], char** sortie)
+ * \brief Lit les options de la ligne de commande.
+ *
+ * \param argc Nombre d'arguments de la commande (du main).
+ * \param argv Tableau des chaines des arguments de la commande (du main).
+ * \param sortie Pointeur pour sauver le fichier de la solution.
+ * \return La résolution à faire, sans table.
+ */
+static Resolution resolution_parse_options(int argc, char* argv[], char** sortie) {
+	int next_option;
+	const char* const short_options = "o:y:x:a:m:h";
+
+	const struct option long_options[] = {
+		{ "sortie",     1, NULL, 'o' },
+		{ "hauteur",    1, NULL, 'y' },
+		{ "largeur",    1, NULL, 'x' },
+		{ "alignement", 1, NULL, 'a' },
+		{ "maximum",    1, NULL, 'm' },
+		{ "help",       0, NULL, 'h' },
+		{ NULL,         0, NULL,   0 }
+	};
+
+	Resolution resolution;
+	memset(&resolution, 0, sizeof(resolution));
+	resolution.config.longueur   = 3;
+	resolution.config.largeur    = 3;
+	resolution.config.alignement = 3;
+	resolution.maximum           = RESOLUTION_POSITIONS_MAX;
+	*sortie                      = NULL;
+
+	do {
+		next_option = getopt_long(argc, argv, short_options, long_options, NULL);
+
+		switch (next_option) {
+		case 'o':
+			*sortie = optarg;
+			break;
+		case 'x':
+			resolution.config.longueur = atoi(optarg);
+			break;
+		case 'y':
+			resolution.config.largeur = atoi(optarg);
+			break;
+		case 'a':
+			resolution.config.alignement = atoi(optarg);
+			break;
+		case 'm':
+			resolution.maximum = atol(optarg);
+			break;
+		case 'h':
+			resolution_usage(stdout, 0);
+			break;
+		case '?':
+			resolution_usage(stderr, 1);
+			break;
+		case -1:
+			break;
+		default:
+			abort();
+		}
+	} while (next_option != -1);
+
+	if(*sortie == NULL || resolution.config.alignement < 1) {
+		resolution_usage(stderr, 1);
+	}
+	if(solution_symetries(&resolution.symetries, resolution.config.longueur, resolution.config.largeur) == 0) {
+		fprintf(stderr, "Seules les grilles de %d cases au plus peuvent être résolues.\n", SOLUTION_CASES_MAX);
+		exit(EXIT_FAILURE);
+	}
+
+	return resolution;
+}
+
+/**
+ * \fn static size_t resolution_case(const Resolution* resolution, uint64_t code)
+ * \brief Case de la table d'un code, ou la case vide où le ranger.
+ */
+static size_t resolution_case(const Resolution* resolution, uint64_t code) {
+	size_t i = alea_melanger(code) & resolution->masque;
+
+	while(resolution->cles[i] != 0 && resolution->cles[i] != code + 1) {
+		i = (i + 1) & resolution->masque;
+	}
+	return i;
+}
+
+/**
+ * \fn static void resolution_allouer(Resolution* resolution, size_t cases)
+ * \brief Alloue la table, ou l'agrandit en y rangeant à nouveau les positions.
+ */
+static void resolution_allouer(Resolution* resolution, size_t cases) {
+	uint64_t* cles = resolution->cles;
+	uint16_t* valeurs = resolution->valeurs;
+	size_t anciennes = resolution->cles != NULL ? resolution->masque + 1 : 0;
+	size_t i;
+
+	resolution->cles    = (uint64_t*) calloc(cases, sizeof(uint64_t));
+	resolution->valeurs = (uint16_t*) malloc(sizeof(uint16_t) * cases);
+	if(resolution->cles == NULL || resolution->valeurs == NULL) {
+		perror("Impossible d'allouer la table des positions.");
+		exit(EXIT_FAILURE);
+	}
+	resolution->masque = cases - 1;
+
+	for(i = 0; i < anciennes; i++) {
+		if(cles[i] != 0) {
+			size_t j = resolution_case(resolution, cles[i] - 1);
+			resolution->cles[j]    = cles[i];
+			resolution->valeurs[j] = valeurs[i];
+		}
+	}
+	free(cles);
+	free(valeurs);
+}
+
+/**
+ * \fn static int resolution_aligne(const Resolution* resolution, const uint8_t* cases, int indice)
+ * \brief Vrai si le pion du joueur au trait sur une case fait un alignement.
+ */
+static int resolution_aligne(const Resolution* resolution, const uint8_t* cases, int indice) {
+	static const int directions[4][2] = { { 1, 0 }, { 0, 1 }, { 1, 1 }, { 1, -1 } };
+	int longueur = resolution->config.longueur;
+	int largeur  = resolution->config.largeur;
+	int d;
+
+	for(d = 0; d < 4; d++) {
+		int alignes = 1;
+		int sens;
+
+		for(sens = -1; sens <= 1; sens += 2) {
+			int x = indice % longueur + sens * directions[d][0];
+			int y = indice / longueur + sens * directions[d][1];
+			while(x >= 0 && x < longueur && y >= 0 && y < largeur && cases[y * longueur + x] == 1) {
+				alignes++;
+				x += sens * directions[d][0];
+				y += sens * directions[d][1];
+			}
+		}
+		if(alignes >= resolution->config.alignement) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * \fn static uint16_t resolution_resoudre(Resolution* resolution, uint8_t* cases, int libres)
+ * \brief Valeur exacte d'une position où il faut jouer.
+ *
+ * Une victoire rapide vaut mieux qu'une victoire lente, une défaite lente
+ * mieux qu'une défaite rapide : l'adversaire a plus d'occasions de se
+ * tromper. La position est rendue inchangée.
+ *
+ * \param resolution Résolution en cours.
+ * \param cases Position : 0 vide, 1 joueur au trait, 2 adversaire.
+ * \param libres Nombre de cases vides, au moins 1.
+ * \return La valeur de la position, son coup dans la forme canonique.
+ */
+static uint16_t resolution_resoudre(Resolution* resolution, uint8_t* cases, int libres) {
+	int nb_cases = resolution->symetries.cases;
+	int symetrie, coup, i;
+	int meilleur_resultat = 0, meilleure_distance = 0, meilleur_coup = -1;
+	uint64_t code = solution_canonique(&resolution->symetries, cases, &symetrie);
+	size_t place = resolution_case(resolution, code);
+	uint16_t valeur;
+
+	if(resolution->cles[place] != 0) {
+		return resolution->valeurs[place];
+	}
+
+	for(coup = 0; coup < nb_cases; coup++) {
+		int resultat, distance;
+
+		if(cases[coup] != 0) {
+			continue;
+		}
+
+		cases[coup] = 1;
+		if(resolution_aligne(resolution, cases, coup)) {
+			resultat = SOLUTION_GAGNEE;
+			distance = 1;
+		} else if(libres == 1) {
+			resultat = SOLUTION_NULLE;
+			distance = 1;
+		} else {
+			/* Le point de vue change : l'adversaire est au trait. */
+			for(i = 0; i < nb_cases; i++) {
+				cases[i] = cases[i] == 0 ? 0 : 3 - cases[i];
+			}
+			valeur = resolution_resoudre(resolution, cases, libres - 1);
+			for(i = 0; i < nb_cases; i++) {
+				cases[i] = cases[i] == 0 ? 0 : 3 - cases[i];
+			}
+			resultat = 4 - SOLUTION_RESULTAT(valeur);
+			distance = SOLUTION_DISTANCE(valeur) + 1;
+		}
+		cases[coup] = 0;
+
+		if(resultat > meilleur_resultat
+				|| (resultat == meilleur_resultat && resultat == SOLUTION_GAGNEE && distance < meilleure_distance)
+				|| (resultat == meilleur_resultat && resultat != SOLUTION_GAGNEE && distance > meilleure_distance)) {
+			meilleur_resultat  = resultat;
+			meilleure_distance = distance;
+			meilleur_coup      = coup;
+		}
+	}
+
+	valeur = SOLUTION_VALEUR(meilleur_resultat, meilleure_distance,
+			resolution->symetries.image[symetrie][meilleur_coup]);
+
+	/* La table a pu grandir pendant la recherche des positions suivantes. */
+	if(2 * (resolution->nombre + 1) > resolution->masque + 1) {
+		resolution_allouer(resolution, 2 * (resolution->masque + 1));
+	}
+	if(resolution->nombre == resolution->maximum) {
+		fprintf(stderr, "Plus de %lu positions : configuration trop grande pour être résolue.\n",
+				(unsigned long) resolution->maximum);
+		exit(EXIT_FAILURE);
+	}
+	place = resolution_case(resolution, code);
+	resolution->cles[place]    = code + 1;
+	resolution->valeurs[place] = valeur;
+	resolution->nombre        += 1;
+
+	return valeur;
+}
+
+/**
+ * \fn static int resolution_comparer(const void* a, const void* b)
+ * \brief Compare deux positions (code, valeur) par code pour qsort.
+ */
+static int resolution_comparer(const void* a, const void* b) {
+	uint64_t code_a = ((const uint64_t*) a)[0];
+	uint64_t code_b = ((const uint64_t*) b)[0];
+
+	return code_a < code_b ? -1 : code_a > code_b;
+}
+
+/**
+ * \fn static int resolution_ecrire(const Resolution* resolution, const char* chemin, uint16_t valeur)
+ * \brief Écrit la solution : entête, codes triés puis valeurs.
+ *
+ * \return 1 si la solution est écrite, 0 sinon.
+ */
+static int resolution_ecrire(const Resolution* resolution, const char* chemin, uint16_t valeur) {
+	EnteteSolution entete;
+	uint64_t* paires = (uint64_t*) malloc(2 * sizeof(uint64_t) * resolution->nombre);
+	uint64_t* codes = (uint64_t*) malloc(sizeof(uint64_t) * resolution->nombre);
+	uint16_t* valeurs = (uint16_t*) malloc(sizeof(uint16_t) * resolution->nombre);
+	FILE* fichier;
+	size_t i, n = 0;
+
+	if(paires == NULL || codes == NULL || valeurs == NULL) {
+		perror("Impossible d'allouer la solution.");
+		exit(EXIT_FAILURE);
+	}
+	for(i = 0; i <= resolution->masque; i++) {
+		if(resolution->cles[i] != 0) {
+			paires[2 * n]     = resolution->cles[i] - 1;
+			paires[2 * n + 1] = resolution->valeurs[i];
+			n++;
+		}
+	}
+	qsort(paires, n, 2 * sizeof(uint64_t), resolution_comparer);
+	for(i = 0; i < n; i++) {
+		codes[i]   = paires[2 * i];
+		valeurs[i] = (uint16_t) paires[2 * i + 1];
+	}
+	free(paires);
+
+	memset(&entete, 0, sizeof(entete));
+	entete.magique    = SOLUTION_MAGIQUE;
+	entete.version    = SOLUTION_VERSION;
+	entete.longueur   = resolution->config.longueur;
+	entete.largeur    = resolution->config.largeur;
+	entete.alignement = resolution->config.alignement;
+	entete.valeur     = valeur;
+	entete.nombre     = n;
+
+	fichier = fopen(chemin, "wb");
+	if(fichier == NULL || fwrite(&entete, sizeof(entete), 1, fichier) != 1
+			|| fwrite(codes, sizeof(uint64_t), n, fichier) != n
+			|| fwrite(valeurs, sizeof(uint16_t), n, fichier) != n
+			|| fclose(fichier) != 0) {
+		perror("Impossible d'écrire la solution.");
+		free(codes);
+		free(valeurs);
+		return 0;
+	}
+
+	free(codes);
+	free(valeurs);
+	return 1;
+}
+
+/**
+ * \fn int main(int argc, char* argv[])
+ * \brief Point d'entrée du solveur.
+ *
+ * \param argc Nombre d'arguments de la commande.
+ * \param argv Tableau des arguments.
+ *
+ * \return Code de sortie du programme.
+ */
+int main(int argc, char* argv[]) {
+	static const char* const resultats[] = { "?", "perdue", "nulle", "gagnée" };
+	char* sortie;
+	Resolution resolution = resolution_parse_options(argc, argv, &sortie);
+	uint8_t cases[SOLUTION_CASES_MAX];
+	double debut = horloge_secondes();
+	uint16_t valeur;
+
+	resolution_allouer(&resolution, 1 << 16);
+	memset(cases, 0, sizeof(cases));
+	valeur = resolution_resoudre(&resolution, cases, resolution.symetries.cases);
+
+	if(!resolution_ecrire(&resolution, sortie, valeur)) {
+		exit(EXIT_FAILURE);
+	}
+	printf("%dx%d alignement %d : %s pour le premier joueur en %d coups, %lu positions, %.1f s\n",
+			resolution.config.longueur, resolution.config.largeur, resolution.config.alignement,
+			resultats[SOLUTION_RESULTAT(valeur)], SOLUTION_DISTANCE(valeur),
+			(unsigned long) resolution.nombre, horloge_secondes() - debut);
+
+	free(resolution.cles);
+	free(resolution.valeurs);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,349 @@
+/**
+ * \file statistiques.c
+ * \brief Compteurs et histogrammes de latence des requêtes du serveur.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "statistiques.h"
+#include "protocol.h"
+#include "format.h"
+
+/** Opcodes suivis, dans l'ordre de leurs rangs. */
+static const char statistiques_codes[STATISTIQUES_OPCODES - 1] = {
+	PROTOCOL_JOIN, PROTOCOL_QUIT, PROTOCOL_GET_CONFIG, PROTOCOL_GET_GRILLE,
+	PROTOCOL_GET_TURN, PROTOCOL_PLAY_TURN, PROTOCOL_GET_COUPS, PROTOCOL_GET_STATS
+};
+
+/** Noms des opcodes pour ::statistiques_ecrire. */
+static const char* const statistiques_noms[STATISTIQUES_OPCODES] = {
+	"JOIN", "QUIT", "GET_CONFIG", "GET_GRILLE",
+	"GET_TURN", "PLAY_TURN", "GET_COUPS", "GET_STATS", "INCONNU"
+};
+
+/**
+ * \fn static void statistiques_ajouter(uint64_t* compteur, uint64_t valeur)
+ * \brief Ajoute à un compteur qui n'a qu'un seul thread qui écrit.
+ *
+ * Pas d'instruction verrouillée : une lecture et une écriture atomiques
+ * suffisent pour que les autres threads lisent une valeur entière.
+ */
+static void statistiques_ajouter(uint64_t* compteur, uint64_t valeur) {
+	__atomic_store_n(compteur, __atomic_load_n(compteur, __ATOMIC_RELAXED) + valeur, __ATOMIC_RELAXED);
+}
+
+/**
+ * \fn static uint64_t statistiques_lire(uint64_t* compteur)
+ * \brief Lit un compteur écrit par un autre thread.
+ */
+static uint64_t statistiques_lire(uint64_t* compteur) {
+	return __atomic_load_n(compteur, __ATOMIC_RELAXED);
+}
+
+/**
+ * \fn static int statistiques_rang(char opcode)
+ * \brief Rang d'un opcode dans les tableaux des statistiques.
+ */
+static int statistiques_rang(char opcode) {
+	int rang = 0;
+	while(rang < STATISTIQUES_OPCODES - 1 && statistiques_codes[rang] != opcode) {
+		rang++;
+	}
+	return rang;
+}
+
+/**
+ * \fn static int histogramme_rang(uint64_t valeur)
+ * \brief Case d'un histogramme où compter une valeur.
+ *
+ * Les valeurs inférieures à 2 * ::STATISTIQUES_SOUS_CASES ont chacune leur
+ * case ; au-delà, une case couvre 2^decalage valeurs consécutives.
+ */
+static int histogramme_rang(uint64_t valeur) {
+	int decalage;
+
+	if(valeur < 2 * STATISTIQUES_SOUS_CASES) {
+		return (int) valeur;
+	}
+	decalage = 63 - __builtin_clzll(valeur) - STATISTIQUES_PRECISION;
+	return decalage * STATISTIQUES_SOUS_CASES + (int) (valeur >> decalage);
+}
+
+/**
+ * \fn uint64_t histogramme_borne(int rang)
+ * \brief Plus petite valeur comptée dans une case.
+ *
+ * \param rang Rang de la case.
+ * \return La valeur.
+ */
+uint64_t histogramme_borne(int rang) {
+	int decalage;
+
+	if(rang < 2 * STATISTIQUES_SOUS_CASES) {
+		return (uint64_t) rang;
+	}
+	decalage = rang / STATISTIQUES_SOUS_CASES - 1;
+	return (uint64_t) (rang - decalage * STATISTIQUES_SOUS_CASES) << decalage;
+}
+
+/**
+ * \fn uint64_t histogramme_quantile(Histogramme* histogramme, double quantile)
+ * \brief Valeur sous laquelle tombe une proportion des valeurs.
+ *
+ * La valeur rendue est la plus grande de sa case, sans dépasser le maximum.
+ *
+ * \param histogramme Histogramme.
+ * \param quantile Proportion entre 0 et 1.
+ * \return La valeur, 0 si l'histogramme est vide.
+ */
+uint64_t histogramme_quantile(Histogramme* histogramme, double quantile) {
+	uint64_t cible = (uint64_t) (quantile * histogramme->nombre + 0.5);
+	uint64_t cumul = 0;
+	int rang;
+
+	if(histogramme->nombre == 0) {
+		return 0;
+	}
+	if(cible < 1) {
+		cible = 1;
+	}
+
+	for(rang = 0; rang < STATISTIQUES_CASES - 1; rang++) {
+		cumul += histogramme->cases[rang];
+		if(cumul >= cible) {
+			uint64_t haut = histogramme_borne(rang + 1) - 1;
+			return haut < histogramme->maximum ? haut : histogramme->maximum;
+		}
+	}
+	return histogramme->maximum;
+}
+
+/**
+ * \fn Statistiques* statistiques_creer(void)
+ * \brief Alloue des statistiques à zéro.
+ *
+ * \return Les statistiques, NULL en cas d'échec.
+ */
+Statistiques* statistiques_creer(void) {
+	Statistiques* statistiques = (Statistiques*) calloc(1, sizeof(Statistiques));
+	if(statistiques == NULL) {
+		perror("Impossible d'allouer les statistiques.");
+	}
+	return statistiques;
+}
+
+/**
+ * \fn void statistiques_liberer(Statistiques* statistiques)
+ * \brief Libère des statistiques.
+ *
+ * \param statistiques Statistiques à libérer.
+ */
+void statistiques_liberer(Statistiques* statistiques) {
+	free(statistiques);
+}
+
+/**
+ * \fn void statistiques_vider(Statistiques* statistiques)
+ * \brief Remet les statistiques à zéro, avant une fusion par exemple.
+ *
+ * \param statistiques Statistiques sans autre thread qui écrit.
+ */
+void statistiques_vider(Statistiques* statistiques) {
+	memset(statistiques, 0, sizeof(Statistiques));
+}
+
+/**
+ * \fn void statistiques_requete(Statistiques* statistiques, char opcode, uint64_t duree)
+ * \brief Compte une requête traitée.
+ *
+ * \param statistiques Statistiques du thread qui a traité la requête.
+ * \param opcode Opcode de la requête.
+ * \param duree Durée du traitement en nanosecondes.
+ */
+void statistiques_requete(Statistiques* statistiques, char opcode, uint64_t duree) {
+	int rang = statistiques_rang(opcode);
+	Histogramme* histogramme = &statistiques->latences[rang];
+
+	statistiques_ajouter(&statistiques->requetes[rang], 1);
+	statistiques_ajouter(&histogramme->cases[histogramme_rang(duree)], 1);
+	statistiques_ajouter(&histogramme->nombre, 1);
+	statistiques_ajouter(&histogramme->somme, duree);
+	if(duree > histogramme->maximum) {
+		__atomic_store_n(&histogramme->maximum, duree, __ATOMIC_RELAXED);
+	}
+}
+
+/**
+ * \fn void statistiques_coup_refuse(Statistiques* statistiques)
+ * \brief Compte un PLAY_TURN refusé.
+ *
+ * \param statistiques Statistiques du thread qui a refusé le coup.
+ */
+void statistiques_coup_refuse(Statistiques* statistiques) {
+	statistiques_ajouter(&statistiques->coups_refuses, 1);
+}
+
+/**
+ * \fn void statistiques_jauges(Statistiques* statistiques, int parties, int joueurs)
+ * \brief Met à jour le nombre de parties et de joueurs d'un thread.
+ *
+ * \param statistiques Statistiques du thread.
+ * \param parties Parties hébergées par le thread.
+ * \param joueurs Joueurs présents dans ces parties.
+ */
+void statistiques_jauges(Statistiques* statistiques, int parties, int joueurs) {
+	__atomic_store_n(&statistiques->parties, parties, __ATOMIC_RELAXED);
+	__atomic_store_n(&statistiques->joueurs, joueurs, __ATOMIC_RELAXED);
+}
+
+/**
+ * \fn void statistiques_fusionner(Statistiques* total, Statistiques* source)
+ * \brief Ajoute les statistiques d'un thread à un total.
+ *
+ * La source peut être écrite par son thread pendant la fusion.
+ *
+ * \param total Statistiques où ajouter, au seul thread appelant.
+ * \param source Statistiques à ajouter.
+ */
+void statistiques_fusionner(Statistiques* total, Statistiques* source) {
+	int i, rang;
+
+	for(i = 0; i < STATISTIQUES_OPCODES; i++) {
+		Histogramme* h = &total->latences[i];
+		Histogramme* s = &source->latences[i];
+		uint64_t maximum = statistiques_lire(&s->maximum);
+
+		total->requetes[i] += statistiques_lire(&source->requetes[i]);
+		for(rang = 0; rang < STATISTIQUES_CASES; rang++) {
+			h->cases[rang] += statistiques_lire(&s->cases[rang]);
+		}
+		h->nombre += statistiques_lire(&s->nombre);
+		h->somme  += statistiques_lire(&s->somme);
+		if(maximum > h->maximum) {
+			h->maximum = maximum;
+		}
+	}
+	total->coups_refuses += statistiques_lire(&source->coups_refuses);
+	total->parties += __atomic_load_n(&source->parties, __ATOMIC_RELAXED);
+	total->joueurs += __atomic_load_n(&source->joueurs, __ATOMIC_RELAXED);
+}
+
+/**
+ * \fn static unsigned char* statistiques_ecrire_u32(unsigned char* tampon, unsigned long valeur)
+ * \brief Écrit un entier de 32 bits en petit-boutiste et avance.
+ */
+static unsigned char* statistiques_ecrire_u32(unsigned char* tampon, unsigned long valeur) {
+	format_ecrire_u32(tampon, valeur);
+	return tampon + 4;
+}
+
+/**
+ * \fn static unsigned char* statistiques_ecrire_u64(unsigned char* tampon, uint64_t valeur)
+ * \brief Écrit un entier de 64 bits en petit-boutiste et avance.
+ */
+static unsigned char* statistiques_ecrire_u64(unsigned char* tampon, uint64_t valeur) {
+	format_ecrire_u64(tampon, valeur);
+	return tampon + 8;
+}
+
+/**
+ * \fn size_t statistiques_serialiser(Statistiques* statistiques, int travailleurs, unsigned char* tampon)
+ * \brief Sérialise les statistiques pour la réponse à PROTOCOL_GET_STATS.
+ *
+ * \param statistiques Statistiques à sérialiser.
+ * \param travailleurs Nombre de threads travailleurs du serveur.
+ * \param tampon Tampon d'au moins ::STATISTIQUES_TAILLE_MAX octets.
+ * \return Le nombre d'octets écrits.
+ */
+size_t statistiques_serialiser(Statistiques* statistiques, int travailleurs, unsigned char* tampon) {
+	unsigned char* fin = tampon;
+	int i, j, rang;
+
+	fin = statistiques_ecrire_u32(fin, (unsigned long) statistiques->parties);
+	fin = statistiques_ecrire_u32(fin, (unsigned long) statistiques->joueurs);
+	fin = statistiques_ecrire_u32(fin, (unsigned long) travailleurs);
+	fin = statistiques_ecrire_u64(fin, statistiques->coups_refuses);
+	fin = statistiques_ecrire_u32(fin, STATISTIQUES_OPCODES);
+
+	for(i = 0; i < STATISTIQUES_OPCODES; i++) {
+		Histogramme* h = &statistiques->latences[i];
+		uint64_t valeurs[7];
+		int non_vides = 0;
+
+		valeurs[0] = statistiques->requetes[i];
+		valeurs[1] = h->nombre > 0 ? h->somme / h->nombre : 0;
+		valeurs[2] = histogramme_quantile(h, 0.5);
+		valeurs[3] = histogramme_quantile(h, 0.9);
+		valeurs[4] = histogramme_quantile(h, 0.99);
+		valeurs[5] = histogramme_quantile(h, 0.999);
+		valeurs[6] = h->maximum;
+		for(rang = 0; rang < STATISTIQUES_CASES; rang++) {
+			if(h->cases[rang] > 0) {
+				non_vides++;
+			}
+		}
+
+		*fin++ = (unsigned char) (i < STATISTIQUES_OPCODES - 1 ? statistiques_codes[i] : 0);
+		for(j = 0; j < 7; j++) {
+			fin = statistiques_ecrire_u64(fin, valeurs[j]);
+		}
+		fin = statistiques_ecrire_u32(fin, (unsigned long) non_vides);
+		for(rang = 0; rang < STATISTIQUES_CASES; rang++) {
+			if(h->cases[rang] > 0) {
+				fin = statistiques_ecrire_u64(fin, histogramme_borne(rang));
+				fin = statistiques_ecrire_u64(fin, h->cases[rang]);
+			}
+		}
+	}
+
+	return (size_t) (fin - tampon);
+}
+
+/**
+ * \fn void statistiques_ecrire_latences(Statistiques* statistiques, FILE* fichier)
+ * \brief Écrit la table des requêtes et latences par opcode.
+ *
+ * \param statistiques Statistiques à écrire.
+ * \param fichier Fichier ouvert en écriture.
+ */
+void statistiques_ecrire_latences(Statistiques* statistiques, FILE* fichier) {
+	int i;
+
+	fprintf(fichier, "%-10s %10s %10s %10s %10s %10s %10s %10s\n",
+			"opcode", "requetes", "moy_us", "p50_us", "p90_us", "p99_us", "p999_us", "max_us");
+
+	for(i = 0; i < STATISTIQUES_OPCODES; i++) {
+		Histogramme* h = &statistiques->latences[i];
+
+		if(statistiques->requetes[i] == 0) {
+			continue;
+		}
+		fprintf(fichier, "%-10s %10llu %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+				statistiques_noms[i], (unsigned long long) statistiques->requetes[i],
+				h->somme / 1e3 / h->nombre,
+				histogramme_quantile(h, 0.5) / 1e3,
+				histogramme_quantile(h, 0.9) / 1e3,
+				histogramme_quantile(h, 0.99) / 1e3,
+				histogramme_quantile(h, 0.999) / 1e3,
+				h->maximum / 1e3);
+	}
+}
+
+/**
+ * \fn void statistiques_ecrire(Statistiques* statistiques, int travailleurs, FILE* fichier)
+ * \brief Écrit les statistiques sous forme de texte.
+ *
+ * \param statistiques Statistiques à écrire.
+ * \param travailleurs Nombre de threads travailleurs du serveur.
+ * \param fichier Fichier ouvert en écriture.
+ */
+void statistiques_ecrire(Statistiques* statistiques, int travailleurs, FILE* fichier) {
+	fprintf(fichier, "parties %d\njoueurs %d\ntravailleurs %d\ncoups_refuses %llu\n",
+			statistiques->parties, statistiques->joueurs, travailleurs,
+			(unsigned long long) statistiques->coups_refuses);
+	statistiques_ecrire_latences(statistiques, fichier);
+}
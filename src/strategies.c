@@ -23,121 +23,198 @@ void strategie_manuelle(Joueur* joueur, Grille* grille, int* x, int* y) {
  * \fn void strategie_random(Joueur* joueur, Grille* grille, int* x, int* y)
  * \brief Stratégie aléatoire, place le pion dans une case vide aléatoirement.
  *
+ * La case est tirée directement parmi les cases libres de la grille, avec
+ * le générateur du joueur : un seul tirage par coup.
+ *
  * \param joueur Joueur qui a la stratégie.
  * \param grille Grille sur laquelle il faut jouer.
  * \param x Pointeur pour sauver la position x de la case choisie.
  * \param y Pointeur pour sauver la position y de la case choisie.
  */
 void strategie_random(Joueur* joueur, Grille* grille, int* x, int* y) {
-	do {
-		*x = rand() % grille->longueur;
-		*y = rand() % grille->largeur;
-	} while(!placerPion(grille, joueur->id, *x, *y));
-}
+	int indice = grille_case_libre_aleatoire(grille, &joueur->alea);
 
-struct element_list_id {
-   int joueur_id;
-   struct element_list_id* next;
-};
-
-typedef struct element_list_id element_list_id;
-typedef element_list_id* list_id;
-
-char in_list_id(list_id list, int id_joueur) {
-	if(list == NULL) {
-		return 0;
-	}
+	*x = indice % grille->longueur;
+	*y = indice / grille->longueur;
+	placerPion(grille, joueur->id, *x, *y);
+}
 
-	while(list != NULL) {
-		if(list->joueur_id == id_joueur) {
-			return 1;
+/**
+ * \fn static int strategie_joueur_suivant(Grille* grille, int premier)
+ * \brief Cherche le joueur dont le premier pion suit celui d'un autre joueur.
+ *
+ * \param grille Grille sur laquelle on joue.
+ * \param premier Indice du premier pion du joueur précédent, -1 au départ.
+ * \return L'identifiant du joueur dont le premier pion est le plus proche
+ * après premier dans l'ordre des lignes, 0 s'il n'y en a pas.
+ */
+static int strategie_joueur_suivant(Grille* grille, int premier) {
+	int suivant = 0;
+	int indice_suivant = -1;
+	int q;
+
+	for(q = 1; q < grille->nb_menaces; q++) {
+		if(grille->menaces[q].pions > 0) {
+			int indice = grille_premier_pion(grille, q);
+			if(indice > premier && (suivant == 0 || indice < indice_suivant)) {
+				suivant = q;
+				indice_suivant = indice;
+			}
 		}
-
-		list = list->next;
 	}
 
-	return 0;
+	return suivant;
 }
 
-void add_list_id(list_id* list, int id_joueur) {
-	element_list_id* nouveau;
+/**
+ * \fn void strategie_defense(Joueur* joueur, Grille* grille, int* x, int* y)
+ * \brief Stratégie défensive, joue sur la case la plus dangereuse.
+ *
+ * Le coup de la solution exacte ou du livre d'ouvertures est joué s'il y en
+ * a un. Sinon, les joueurs présents sont pris dans l'ordre de leur premier
+ * pion sur la grille et leurs cases parcourues ligne par ligne. Une case est
+ * retenue dès que la ligne qu'un joueur y ferait dépasse le nombre de cases
+ * déjà retenues, la dernière case retenue est jouée.
+ *
+ * Seule la première case vide est retenue avec une ligne de 1 : ensuite il
+ * suffit de parcourir les cases menacées de chaque joueur, que la grille tient
+ * à jour et dans l'ordre des lignes à chaque coup (voir
+ * ::grille_suivre_menaces). La première case vide vient de
+ * ::grille_premiere_case_libre, sans parcourir la grille.
+ *
+ * \param joueur Joueur qui a la stratégie.
+ * \param grille Grille sur laquelle il faut jouer.
+ * \param x Pointeur pour sauver la position x de la case choisie.
+ * \param y Pointeur pour sauver la position y de la case choisie.
+ */
+void strategie_defense(Joueur* joueur, Grille* grille, int* x, int* y) {
+	int coefficient = 0;
+	int case_dangereuse = 0;
+	int premier = -1;
+	int q, i;
 
-	if(list == NULL) {
+	if(strategie_coup_connu(joueur, grille, x, y)) {
 		return;
 	}
+	grille_suivre_menaces(grille);
 
-	nouveau = (element_list_id*) malloc(sizeof(element_list_id));
-	if(nouveau == NULL) {
-		perror("Impossible d'allouer un élément de liste chainé.");
-		exit(1);
-	}
-	nouveau->joueur_id = id_joueur;
-	nouveau->next = NULL;
-
-	if(*list == NULL) {
-		*list = nouveau;
-	} else {
-		element_list_id* dernier = *list;
-		while(dernier->next != NULL) {
-			dernier = dernier->next;
+	for(q = strategie_joueur_suivant(grille, premier); q != 0; q = strategie_joueur_suivant(grille, premier)) {
+		MenacesJoueur* m = &grille->menaces[q];
+		int deja_retenue = -1;
+
+		if(premier < 0) {
+			deja_retenue = grille_premiere_case_libre(grille);
+			case_dangereuse = deja_retenue;
+			coefficient = 1;
 		}
-		dernier->next = nouveau;
-	}
-}
 
-void free_list_id(list_id list) {
-	while(list != NULL) {
-		element_list_id* tmp = list->next;
-		free(list);
-		list = tmp;
-	}
-}
+		for(i = 0; i < m->nb_cases; i++) {
+			int indice = m->cases[i];
 
-void strategie_defense(Joueur* joueur, Grille* grille, int* x, int* y) {
-	int i, j;
-	list_id liste_joueurs = NULL;
-	element_list_id* joueur_courant;
-	int nombre_adversaires = 0;
-
-	int joueur_dangereux_coefficient = 0;
-	int x_dangereux = 0;
-	int y_dangereux = 0;
-
-	for(j = 0; j < grille->largeur; j++) {
-		for(i = 0; i < grille->longueur; i++) {
-			if(grille->tab[j][i] != 0) {
-				if(!in_list_id(liste_joueurs, grille->tab[j][i])) {
-					add_list_id(&liste_joueurs, grille->tab[j][i]);
-					nombre_adversaires++;
-				}
+			if(indice != deja_retenue && m->valeur[indice] >= coefficient + 1) {
+				case_dangereuse = indice;
+				coefficient += 1;
 			}
 		}
-	}
 
-	joueur_courant = liste_joueurs;
+		premier = grille_premier_pion(grille, q);
+	}
 
-	while(joueur_courant != NULL) {
-		for(j = 0; j < grille->largeur; j++) {
-			for(i = 0; i < grille->longueur; i++) {
-				if(grille->tab[j][i] == 0) {
-					grille->tab[j][i] = joueur_courant->joueur_id;
+	*x = case_dangereuse % grille->longueur;
+	*y = case_dangereuse / grille->longueur;
 
-					if(alignePion(grille,i,j, joueur_dangereux_coefficient+1)) {
-						x_dangereux = i;
-						y_dangereux = j;
-						joueur_dangereux_coefficient += 1;
-					}
+	placerPion(grille, joueur->id, *x, *y);
+}
 
-					grille->tab[j][i] = 0;
-				}
+/**
+ * \fn int strategie_adversaire(Grille* grille, int id)
+ * \brief Cherche l'identifiant d'un adversaire sur la grille.
+ *
+ * Les stratégies de recherche ne savent jouer que contre un seul adversaire :
+ * avec plus de deux joueurs, le premier pion adverse trouvé désigne
+ * l'adversaire.
+ *
+ * \param grille Grille sur laquelle on joue.
+ * \param id Identifiant du joueur qui cherche son adversaire.
+ * \return L'identifiant de l'adversaire, ou un identifiant différent de id
+ * si la grille ne contient pas de pion adverse.
+ */
+int strategie_adversaire(Grille* grille, int id) {
+	int x, y;
+
+	for(y = 0; y < grille->largeur; y++) {
+		for(x = 0; x < grille->longueur; x++) {
+			int J = GRILLE_OCTET(grille, x, y);
+			if(J != 0 && J != id) {
+				return J;
 			}
 		}
+	}
+
+	return id == 1 ? 2 : 1;
+}
 
-		joueur_courant = joueur_courant->next;
+/**
+ * \fn static int strategie_deux_joueurs(Grille* grille, int id)
+ * \brief Vérifie que la grille ne contient que les pions de deux joueurs.
+ *
+ * \param grille Grille sur laquelle on joue.
+ * \param id Identifiant du joueur au trait.
+ * \return 1 si tous les pions sont de id ou d'un même adversaire, 0 sinon.
+ */
+static int strategie_deux_joueurs(Grille* grille, int id) {
+	int adversaire = 0;
+	int x, y;
+
+	for(y = 0; y < grille->largeur; y++) {
+		for(x = 0; x < grille->longueur; x++) {
+			int J = GRILLE_OCTET(grille, x, y);
+			if(J == 0 || J == id || J == adversaire) {
+				continue;
+			}
+			if(adversaire != 0) {
+				return 0;
+			}
+			adversaire = J;
+		}
 	}
 
-	*x = x_dangereux;
-	*y = y_dangereux;
+	return 1;
+}
+
+/**
+ * \fn int strategie_coup_connu(Joueur* joueur, Grille* grille, int* x, int* y)
+ * \brief Joue le coup connu d'avance d'une position, s'il y en a un.
+ *
+ * La solution exacte de la configuration est consultée d'abord, puis le
+ * livre d'ouvertures. Tous deux ne connaissent que des parties à deux
+ * joueurs : ils ne sont pas consultés s'il y a plus d'un adversaire.
+ *
+ * \param joueur Joueur qui cherche son coup.
+ * \param grille Grille sur laquelle il faut jouer.
+ * \param x Pointeur pour sauver la position x de la case jouée.
+ * \param y Pointeur pour sauver la position y de la case jouée.
+ * \return 1 si un coup connu est joué, 0 si la position n'est ni résolue ni dans le livre.
+ */
+int strategie_coup_connu(Joueur* joueur, Grille* grille, int* x, int* y) {
+	int indice = -1;
+
+	if((joueur->solution == NULL && joueur->livre == NULL) || !strategie_deux_joueurs(grille, joueur->id)) {
+		return 0;
+	}
+	if(joueur->solution != NULL) {
+		indice = solution_chercher(joueur->solution, grille, joueur->id, NULL);
+	}
+	if(indice < 0 && joueur->livre != NULL) {
+		indice = livre_chercher(joueur->livre, grille, joueur->id);
+	}
+	if(indice < 0) {
+		return 0;
+	}
 
+	*x = indice % grille->longueur;
+	*y = indice / grille->longueur;
 	placerPion(grille, joueur->id, *x, *y);
+
+	return 1;
 }
@@ -0,0 +1,201 @@
+/**
+ * \file trace.c
+ * \brief Traces du serveur par niveau, écrites par un thread en arrière-plan.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ *
+ * La file est une file bornée à plusieurs producteurs et un seul
+ * consommateur : chaque case porte un numéro de séquence qui dit si elle est
+ * libre pour le producteur du tour pos (sequence == pos) ou remplie pour le
+ * consommateur (sequence == pos + 1).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "trace.h"
+
+/**
+ * \struct CaseTrace
+ * \brief Un message dans la file.
+ */
+typedef struct CaseTrace {
+	unsigned long sequence;                /*!< Tour de la file pour lequel la case est prête. */
+	int niveau;                            /*!< Niveau du message. */
+	struct timespec date;                  /*!< Date du message. */
+	char message[TRACE_TAILLE_MESSAGE];    /*!< Message formaté. */
+} CaseTrace;
+
+int trace_niveau = -1;
+
+static CaseTrace trace_cases[TRACE_CASES];
+static unsigned long trace_ecriture;   /* Prochaine case à remplir, partagée. */
+static unsigned long trace_lecture;    /* Prochaine case à écrire, au thread seul. */
+static unsigned long trace_pertes;
+static int trace_actif;
+static FILE* trace_fichier;
+static pthread_t trace_thread;
+
+static const char* const trace_noms[] = { "ERREUR", "AVERT ", "INFO  ", "DEBUG " };
+
+/**
+ * \fn static int trace_vider(void)
+ * \brief Écrit dans le fichier tous les messages prêts.
+ *
+ * \return Le nombre de messages écrits.
+ */
+static int trace_vider(void) {
+	int ecrits = 0;
+
+	while(1) {
+		CaseTrace* c = &trace_cases[trace_lecture & (TRACE_CASES - 1)];
+		struct tm calendrier;
+		char date[32];
+
+		if(__atomic_load_n(&c->sequence, __ATOMIC_ACQUIRE) != trace_lecture + 1) {
+			break;
+		}
+
+		strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", localtime_r(&c->date.tv_sec, &calendrier));
+		fprintf(trace_fichier, "%s.%06ld %s %s\n", date, c->date.tv_nsec / 1000,
+				trace_noms[c->niveau], c->message);
+
+		__atomic_store_n(&c->sequence, trace_lecture + TRACE_CASES, __ATOMIC_RELEASE);
+		trace_lecture++;
+		ecrits++;
+	}
+
+	if(ecrits > 0) {
+		fflush(trace_fichier);
+	}
+	return ecrits;
+}
+
+/**
+ * \fn static void* trace_thread_ecriture(void* argument)
+ * \brief Boucle du thread qui vide la file dans le fichier.
+ */
+static void* trace_thread_ecriture(void* argument) {
+	(void) argument;
+
+	while(__atomic_load_n(&trace_actif, __ATOMIC_ACQUIRE)) {
+		if(trace_vider() == 0) {
+			usleep(TRACE_ATTENTE_US);
+		}
+	}
+	trace_vider();
+
+	return NULL;
+}
+
+/**
+ * \fn int trace_demarrer(const char* chemin, int niveau)
+ * \brief Ouvre le fichier des traces et lance le thread d'écriture.
+ *
+ * \param chemin Fichier ouvert en ajout, NULL pour la sortie d'erreur.
+ * \param niveau Niveau des messages gardés, un des TRACE_*.
+ * \return 1 si les traces sont démarrées, 0 sinon.
+ */
+int trace_demarrer(const char* chemin, int niveau) {
+	unsigned long i;
+
+	trace_fichier = chemin == NULL ? stderr : fopen(chemin, "a");
+	if(trace_fichier == NULL) {
+		perror("Impossible d'ouvrir le fichier des traces.");
+		return 0;
+	}
+
+	for(i = 0; i < TRACE_CASES; i++) {
+		trace_cases[i].sequence = i;
+	}
+	trace_ecriture = 0;
+	trace_lecture  = 0;
+	trace_pertes   = 0;
+	trace_actif    = 1;
+
+	if(pthread_create(&trace_thread, NULL, trace_thread_ecriture, NULL) != 0) {
+		perror("Impossible de lancer le thread des traces.");
+		if(trace_fichier != stderr) {
+			fclose(trace_fichier);
+		}
+		return 0;
+	}
+	__atomic_store_n(&trace_niveau, niveau, __ATOMIC_RELEASE);
+
+	return 1;
+}
+
+/**
+ * \fn void trace_arreter(void)
+ * \brief Écrit les derniers messages puis arrête le thread d'écriture.
+ */
+void trace_arreter(void) {
+	__atomic_store_n(&trace_niveau, -1, __ATOMIC_RELEASE);
+	__atomic_store_n(&trace_actif, 0, __ATOMIC_RELEASE);
+	pthread_join(trace_thread, NULL);
+
+	if(trace_perdus() > 0) {
+		fprintf(trace_fichier, "%lu messages perdus, file pleine.\n", trace_perdus());
+	}
+	if(trace_fichier != stderr) {
+		fclose(trace_fichier);
+	}
+}
+
+/**
+ * \fn void trace_ecrire(int niveau, const char* format, ...)
+ * \brief Formate un message et le range dans la file, sans bloquer.
+ *
+ * Préférer la macro ::TRACE, qui filtre le niveau avant de formater.
+ *
+ * \param niveau Niveau du message, un des TRACE_*.
+ * \param format Format à la printf.
+ */
+void trace_ecrire(int niveau, const char* format, ...) {
+	unsigned long position = __atomic_load_n(&trace_ecriture, __ATOMIC_RELAXED);
+	CaseTrace* c;
+	va_list arguments;
+
+	while(1) {
+		long ecart;
+
+		c = &trace_cases[position & (TRACE_CASES - 1)];
+		ecart = (long) (__atomic_load_n(&c->sequence, __ATOMIC_ACQUIRE) - position);
+		if(ecart == 0) {
+			if(__atomic_compare_exchange_n(&trace_ecriture, &position, position + 1,
+						1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+				break;
+			}
+		} else if(ecart < 0) {
+			/* File pleine : le thread d'écriture est en retard. */
+			__atomic_add_fetch(&trace_pertes, 1, __ATOMIC_RELAXED);
+			return;
+		} else {
+			position = __atomic_load_n(&trace_ecriture, __ATOMIC_RELAXED);
+		}
+	}
+
+	c->niveau = niveau < TRACE_ERREUR ? TRACE_ERREUR : niveau > TRACE_DEBUG ? TRACE_DEBUG : niveau;
+	clock_gettime(CLOCK_REALTIME, &c->date);
+	va_start(arguments, format);
+	vsnprintf(c->message, sizeof(c->message), format, arguments);
+	va_end(arguments);
+
+	__atomic_store_n(&c->sequence, position + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * \fn unsigned long trace_perdus(void)
+ * \brief Nombre de messages perdus parce que la file était pleine.
+ *
+ * \return Le nombre de messages.
+ */
+unsigned long trace_perdus(void) {
+	return __atomic_load_n(&trace_pertes, __ATOMIC_RELAXED);
+}
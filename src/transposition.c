@@ -0,0 +1,172 @@
+/**
+ * \file transposition.c
+ * \brief Table de transposition pour les stratégies de recherche.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "transposition.h"
+
+#define TRANSPOSITION_LIGNE_CACHE 64 /**< Taille d'une ligne de cache en octets. */
+
+/**
+ * \fn TableTransposition* transposition_creer(size_t octets, int politique)
+ * \brief Alloue une table de transposition.
+ *
+ * Le nombre de seaux est la plus grande puissance de 2 qui tient dans le
+ * budget mémoire (au moins un seau).
+ *
+ * \param octets Budget mémoire de la table.
+ * \param politique TRANSPOSITION_POLITIQUE_PROFONDEUR ou TRANSPOSITION_POLITIQUE_TOUJOURS.
+ * \return La table allouée et vide, NULL en cas d'échec.
+ */
+TableTransposition* transposition_creer(size_t octets, int politique) {
+	size_t seaux = 1;
+	TableTransposition* table = (TableTransposition*) malloc(sizeof(TableTransposition));
+	if(table == NULL) {
+		perror("Impossible d'allouer la table de transposition.");
+		return NULL;
+	}
+
+	while(seaux * 2 * sizeof(SeauTransposition) <= octets) {
+		seaux *= 2;
+	}
+
+	table->memoire = malloc(seaux * sizeof(SeauTransposition) + TRANSPOSITION_LIGNE_CACHE);
+	if(table->memoire == NULL) {
+		perror("Impossible d'allouer les seaux de la table de transposition.");
+		free(table);
+		return NULL;
+	}
+
+	table->seaux = (SeauTransposition*) (((size_t) table->memoire + TRANSPOSITION_LIGNE_CACHE - 1)
+			& ~(size_t) (TRANSPOSITION_LIGNE_CACHE - 1));
+	table->masque    = seaux - 1;
+	table->politique = politique;
+	transposition_vider(table);
+
+	return table;
+}
+
+/**
+ * \fn void transposition_liberer(TableTransposition* table)
+ * \brief Libère une table de transposition.
+ *
+ * \param table Table à libérer, peut être NULL.
+ */
+void transposition_liberer(TableTransposition* table) {
+	if(table == NULL) {
+		return;
+	}
+	free(table->memoire);
+	free(table);
+}
+
+/**
+ * \fn void transposition_vider(TableTransposition* table)
+ * \brief Efface toutes les entrées et les statistiques.
+ *
+ * \param table Table à vider.
+ */
+void transposition_vider(TableTransposition* table) {
+	memset(table->seaux, 0, (table->masque + 1) * sizeof(SeauTransposition));
+	table->age    = 1;
+	table->sondes = 0;
+	table->succes = 0;
+}
+
+/**
+ * \fn void transposition_nouvelle_recherche(TableTransposition* table)
+ * \brief Signale le début d'une nouvelle recherche.
+ *
+ * Les entrées des recherches précédentes restent utilisables mais sont
+ * remplacées en priorité.
+ *
+ * \param table Table de transposition.
+ */
+void transposition_nouvelle_recherche(TableTransposition* table) {
+	table->age = table->age % 63 + 1;
+}
+
+/**
+ * \fn int transposition_sonder(TableTransposition* table, uint64_t cle, EntreeTransposition* entree)
+ * \brief Cherche une position dans la table.
+ *
+ * \param table Table de transposition.
+ * \param cle Clé de Zobrist de la position.
+ * \param entree Pointeur pour sauver l'entrée trouvée.
+ * \return 1 si la position est dans la table, 0 sinon.
+ */
+int transposition_sonder(TableTransposition* table, uint64_t cle, EntreeTransposition* entree) {
+	SeauTransposition* seau = &table->seaux[cle & table->masque];
+	int i;
+
+	table->sondes++;
+	for(i = 0; i < TRANSPOSITION_PAR_SEAU; i++) {
+		if(seau->entrees[i].cle == cle && seau->entrees[i].type_age != 0) {
+			*entree = seau->entrees[i];
+			table->succes++;
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * \fn void transposition_stocker(TableTransposition* table, uint64_t cle, int profondeur, int score, int type, int coup)
+ * \brief Range le résultat d'une recherche dans la table.
+ *
+ * Une entrée de même clé est toujours remplacée. Sinon la victime dépend de
+ * la politique : avec TRANSPOSITION_POLITIQUE_PROFONDEUR, une entrée vide ou
+ * d'une ancienne recherche, à défaut la moins profonde ; avec
+ * TRANSPOSITION_POLITIQUE_TOUJOURS, l'entrée désignée par les bits hauts de
+ * la clé.
+ *
+ * \param table Table de transposition.
+ * \param cle Clé de Zobrist de la position.
+ * \param profondeur Profondeur de la recherche (tronquée à 255).
+ * \param score Score de la position.
+ * \param type TRANSPOSITION_EXACT, TRANSPOSITION_BORNE_INF ou TRANSPOSITION_BORNE_SUP.
+ * \param coup Meilleur coup, TRANSPOSITION_PAS_DE_COUP ou un indice hors limite s'il n'y en a pas.
+ */
+void transposition_stocker(TableTransposition* table, uint64_t cle, int profondeur, int score, int type, int coup) {
+	SeauTransposition* seau = &table->seaux[cle & table->masque];
+	EntreeTransposition* victime = NULL;
+	int i;
+
+	for(i = 0; i < TRANSPOSITION_PAR_SEAU; i++) {
+		if(seau->entrees[i].cle == cle) {
+			victime = &seau->entrees[i];
+			break;
+		}
+	}
+
+	if(victime == NULL && table->politique == TRANSPOSITION_POLITIQUE_TOUJOURS) {
+		victime = &seau->entrees[(cle >> 62) & (TRANSPOSITION_PAR_SEAU - 1)];
+	}
+
+	if(victime == NULL) {
+		int meilleur_rang = 1 << 16;
+		for(i = 0; i < TRANSPOSITION_PAR_SEAU; i++) {
+			EntreeTransposition* entree = &seau->entrees[i];
+			int ancienne = entree->type_age == 0 || (entree->type_age >> 2) != table->age;
+			int rang = ancienne ? -1 : entree->profondeur;
+			if(rang < meilleur_rang) {
+				meilleur_rang = rang;
+				victime = entree;
+			}
+		}
+	}
+
+	victime->cle        = cle;
+	victime->score      = score;
+	victime->coup       = coup >= 0 && coup < TRANSPOSITION_PAS_DE_COUP ? coup : TRANSPOSITION_PAS_DE_COUP;
+	victime->profondeur = profondeur > 255 ? 255 : profondeur;
+	victime->type_age   = (uint8_t) ((table->age << 2) | (type & 3));
+}
@@ -0,0 +1,190 @@
+/**
+ * \file defense.c
+ * \brief Vérifie que strategie_defense joue comme sa première version.
+ * \author Philippe Lewin <lewinp@esiee.fr>
+ * \version 0.1
+ * \date Janvier 2013
+ *
+ * La première version de la stratégie défensive parcourait toute la grille
+ * pour chaque joueur présent. Elle est recopiée ici comme référence et
+ * comparée, position par position, à ::strategie_defense qui lit les menaces
+ * tenues à jour par la grille. Les positions viennent de parties aléatoires
+ * de 2 à 4 joueurs sur des grilles de tailles variées, où des coups sont de
+ * temps en temps retirés pour vérifier aussi ::retirerPion.
+ *
+ * Utilisation : defense [parties [graine]]. Le code de retour est non nul
+ * si une position donne un coup différent.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "joueur.h"
+#include "strategies.h"
+
+#define DEFENSE_PARTIES  200  /**< Nombre de parties par défaut. */
+#define DEFENSE_GRAINE   1    /**< Graine par défaut. */
+#define DEFENSE_JOUEURS  4    /**< Nombre maximal de joueurs d'une partie. */
+
+/**
+ * \fn static int defense_case(Grille* grille, int x, int y)
+ * \brief Identifiant du joueur sur une case, 0 si elle est vide.
+ */
+static int defense_case(Grille* grille, int x, int y) {
+	return GRILLE_OCTET(grille, x, y);
+}
+
+/**
+ * \fn static int defense_ligne(Grille* grille, int J, int x, int y, int n)
+ * \brief Vrai si un pion de J en (x, y) alignerait au moins n pions.
+ *
+ * Comme l'ancien alignePion, les pions sont comptés case par case sur le
+ * plateau, sans lire les longueurs de lignes tenues à jour par la grille.
+ */
+static int defense_ligne(Grille* grille, int J, int x, int y, int n) {
+	static const int directions[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
+	int d, sens;
+
+	for(d = 0; d < 4; d++) {
+		int total = 1;
+		for(sens = -1; sens <= 1; sens += 2) {
+			int i = x + sens * directions[d][0];
+			int j = y + sens * directions[d][1];
+			while(i >= 0 && i < grille->longueur && j >= 0 && j < grille->largeur
+					&& defense_case(grille, i, j) == J) {
+				total++;
+				i += sens * directions[d][0];
+				j += sens * directions[d][1];
+			}
+		}
+		if(total >= n) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * \fn static int defense_reference(Grille* grille)
+ * \brief Coup de la première version de strategie_defense, sans le jouer.
+ *
+ * Les joueurs sont pris dans l'ordre de leur premier pion, ligne par ligne.
+ * Pour chacun, une case vide est retenue dès que la ligne qu'il y ferait,
+ * comptée par ::defense_ligne, dépasse le nombre de cases déjà retenues.
+ *
+ * \param grille Position, qui a au moins une case libre.
+ * \return L'indice de la case retenue.
+ */
+static int defense_reference(Grille* grille) {
+	int joueurs[DEFENSE_JOUEURS + 1];
+	int nb_joueurs = 0;
+	int coefficient = 0;
+	int retenue = 0;
+	int i, j, k;
+
+	for(j = 0; j < grille->largeur; j++) {
+		for(i = 0; i < grille->longueur; i++) {
+			int J = defense_case(grille, i, j);
+			if(J != 0) {
+				for(k = 0; k < nb_joueurs && joueurs[k] != J; k++) {
+				}
+				if(k == nb_joueurs) {
+					joueurs[nb_joueurs++] = J;
+				}
+			}
+		}
+	}
+
+	for(k = 0; k < nb_joueurs; k++) {
+		for(j = 0; j < grille->largeur; j++) {
+			for(i = 0; i < grille->longueur; i++) {
+				if(defense_case(grille, i, j) == 0
+						&& defense_ligne(grille, joueurs[k], i, j, coefficient + 1)) {
+					retenue = j * grille->longueur + i;
+					coefficient += 1;
+				}
+			}
+		}
+	}
+
+	return retenue;
+}
+
+/**
+ * \fn int main(int argc, char** argv)
+ * \brief Compare les deux versions sur des parties aléatoires.
+ */
+int main(int argc, char** argv) {
+	long parties = argc > 1 ? atol(argv[1]) : DEFENSE_PARTIES;
+	Alea alea;
+	Joueur* joueurs[DEFENSE_JOUEURS + 1];
+	long positions = 0;
+	long differences = 0;
+	long partie;
+	int q;
+
+	alea_init(&alea, argc > 2 ? (uint64_t) atol(argv[2]) : DEFENSE_GRAINE);
+	for(q = 1; q <= DEFENSE_JOUEURS; q++) {
+		joueurs[q] = creerJoueurDefense(q);
+		joueurs[q]->livre    = NULL;
+		joueurs[q]->solution = NULL;
+	}
+
+	for(partie = 0; partie < parties; partie++) {
+		int longueur = 3 + alea_borne(&alea, 10);
+		int largeur  = 3 + alea_borne(&alea, 10);
+		int nb_joueurs = 2 + alea_borne(&alea, DEFENSE_JOUEURS - 1);
+		Grille* grille = initGrille(longueur, largeur);
+		int* coups;
+		int nb_coups = 0;
+
+		coups = (int*) malloc(sizeof(int) * longueur * largeur);
+		if(grille == NULL || coups == NULL) {
+			perror("Impossible d'allouer une partie.");
+			return EXIT_FAILURE;
+		}
+		grille->alignement = 3 + alea_borne(&alea, 3);
+
+		while(!estPleineGrille(grille)) {
+			int J = 1 + nb_coups % nb_joueurs;
+			int attendu = defense_reference(grille);
+			int x, y, coup;
+
+			joueurs[J]->place(joueurs[J], grille, &x, &y);
+			positions++;
+			if(y * longueur + x != attendu) {
+				differences++;
+				fprintf(stderr, "Partie %ld, %dx%d, coup %d : (%d, %d) au lieu de (%d, %d).\n",
+						partie, longueur, largeur, nb_coups, x, y, attendu % longueur, attendu / longueur);
+			}
+			retirerPion(grille, x, y);
+
+			/* Un coup sur deux au hasard, pour varier les positions. */
+			coup = alea_borne(&alea, 2) ? y * longueur + x : grille_case_libre_aleatoire(grille, &alea);
+			placerPion(grille, J, coup % longueur, coup / longueur);
+			coups[nb_coups++] = coup;
+			if(alignePion(grille, coup % longueur, coup / longueur, grille->alignement)) {
+				break;
+			}
+
+			/* De temps en temps, quelques coups sont retirés dans l'ordre inverse. */
+			if(alea_borne(&alea, 8) == 0) {
+				int retires = 1 + alea_borne(&alea, nb_coups);
+				while(retires-- > 0) {
+					nb_coups--;
+					retirerPion(grille, coups[nb_coups] % longueur, coups[nb_coups] / longueur);
+				}
+			}
+		}
+
+		free(coups);
+		libererGrille(grille);
+	}
+
+	for(q = 1; q <= DEFENSE_JOUEURS; q++) {
+		libererJoueur(joueurs[q]);
+	}
+
+	printf("defense : %ld parties, %ld positions, %ld différences.\n", parties, positions, differences);
+	return differences == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}